@@ -1,6 +1,8 @@
 #include "UDKImportPluginPrivatePCH.h"
 #include "SUDKImportScreen.h"
 #include "T3DLevelParser.h"
+#include "UDKImportPipeline.h"
+#include "UDKImportProgressReporter.h"
 #include "UDKImportPlugin/Public/UDKInstallVerifier.h"
 
 #define LOCTEXT_NAMESPACE "UDKImportScreen"
@@ -200,37 +202,45 @@ void SUDKImportScreen::Construct(const FArguments& Args)
 
 FReply SUDKImportScreen::OnRun()
 {
+	if (RunningImport.IsValid())
+	{
+		return FReply::Handled();
+	}
+
 	const FString UdkPath = SUDKPath.Get()->GetText().ToString();
 	const FString TmpPath = STmpPath.Get()->GetText().ToString();
 	const FString Ressource = SLevel.Get()->GetText().ToString();
 
+	TSharedPtr<FUDKImportProgressReporter, ESPMode::ThreadSafe> Reporter = MakeShareable(new FUDKImportProgressReporterUI());
+	TSharedPtr<T3DLevelParser, ESPMode::ThreadSafe> Parser = MakeShareable(new T3DLevelParser(UdkPath, TmpPath));
+	TSharedRef<FUDKImportPipeline, ESPMode::ThreadSafe> Pipeline = MakeShareable(new FUDKImportPipeline(Reporter));
+	Parser->SetProgressReporter(Reporter.Get());
+
 	switch (ExportMode)
 	{
 	case EUDKImportMode::Map:
-	{
-		T3DLevelParser Parser(UdkPath, TmpPath);
-		Parser.ImportLevel(Ressource);
+		Parser->AddLevelImportStages(*Pipeline, Ressource);
 		break;
-	}
 	case EUDKImportMode::StaticMesh:
-	{
-		T3DLevelParser Parser(UdkPath, TmpPath);
-		Parser.ImportStaticMesh(Ressource);
+		Parser->AddStaticMeshImportStages(*Pipeline, Ressource);
 		break;
-	}
 	case EUDKImportMode::Material:
-	{
-		T3DLevelParser Parser(UdkPath, TmpPath);
-		Parser.ImportMaterial(Ressource);
+		Parser->AddMaterialImportStages(*Pipeline, Ressource);
 		break;
-	}
 	case EUDKImportMode::MaterialInstanceConstant:
-	{
-		T3DLevelParser Parser(UdkPath, TmpPath);
-		Parser.ImportMaterialInstanceConstant(Ressource);
+		Parser->AddMaterialInstanceConstantImportStages(*Pipeline, Ressource);
 		break;
 	}
-	}
+
+	// The parser and the reporter live until the import is over
+	RunningImport = Pipeline;
+	Pipeline->Start(FUDKImportPipeline::FOnFinished::CreateLambda([Parser, Reporter, Ressource](bool bSuccess)
+	{
+		if (!bSuccess && !Reporter->IsCancelled())
+		{
+			Reporter->LogError(FText::Format(LOCTEXT("ImportFailed", "Unable to import {0}"), FText::FromString(Ressource)));
+		}
+	}));
 
 	return FReply::Handled();
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+class FUDKImportPipeline;
+
 DECLARE_LOG_CATEGORY_EXTERN(LogUDKImportPlugin, Warning, All);
 
 struct EUDKImportMode
@@ -76,4 +78,7 @@ protected:
 
 	/** Verification status widget */
 	TSharedPtr<class STextBlock> SVerifyStatus;
+
+	/** Import started by OnRun, one import runs at a time */
+	TWeakPtr<FUDKImportPipeline, ESPMode::ThreadSafe> RunningImport;
 };
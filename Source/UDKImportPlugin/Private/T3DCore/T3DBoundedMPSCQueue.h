@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace T3DCore
+{
+	/**
+	 * Bounded lock-free queue with any number of producer threads and a single consumer thread.
+	 * Every cell carries a sequence number telling whether it is free for the producer of a given position or
+	 * holds the item of the consumer position, so producers only contend on the enqueue position and never wait
+	 * on each other. A full queue is the back-pressure: Enqueue waits until the consumer frees a cell.
+	 */
+	template<typename ItemType>
+	class TBoundedMPSCQueue
+	{
+	public:
+		/** The capacity is rounded up to a power of two */
+		explicit TBoundedMPSCQueue(std::uint32_t MinCapacity)
+		{
+			std::uint32_t Capacity = 2;
+			while (Capacity < MinCapacity)
+			{
+				Capacity <<= 1;
+			}
+			this->Mask = Capacity - 1;
+			this->Cells.reset(new FCell[Capacity]);
+			for (std::uint32_t Index = 0; Index < Capacity; ++Index)
+			{
+				Cells[Index].Sequence.store(Index, std::memory_order_relaxed);
+			}
+			EnqueuePosition.store(0, std::memory_order_relaxed);
+			DequeuePosition.store(0, std::memory_order_relaxed);
+		}
+
+		TBoundedMPSCQueue(const TBoundedMPSCQueue &) = delete;
+		TBoundedMPSCQueue & operator=(const TBoundedMPSCQueue &) = delete;
+
+		/** Can be called from any thread, @return false if the queue is full, Item is then left untouched */
+		bool TryEnqueue(ItemType &&Item)
+		{
+			std::uint32_t Position = EnqueuePosition.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				FCell &Cell = Cells[Position & Mask];
+				const std::int32_t Delta = (std::int32_t)(Cell.Sequence.load(std::memory_order_acquire) - Position);
+				if (Delta == 0)
+				{
+					// The cell is free for this position, claim the position
+					if (EnqueuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+					{
+						Cell.Item = std::move(Item);
+						Cell.Sequence.store(Position + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (Delta < 0)
+				{
+					// The consumer did not release the cell from the previous lap yet
+					return false;
+				}
+				else
+				{
+					// Another producer claimed the position
+					Position = EnqueuePosition.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		/**
+		 * Can be called from any thread, waits for the consumer while the queue is full.
+		 * @param ShouldAbort - Polled while waiting, the item is dropped once it returns true
+		 * @return false if the item was dropped
+		 */
+		template<typename AbortPredicateType>
+		bool Enqueue(ItemType &&Item, AbortPredicateType ShouldAbort)
+		{
+			for (int Attempt = 0; !TryEnqueue(std::move(Item)); ++Attempt)
+			{
+				if (ShouldAbort())
+					return false;
+
+				// Yield while the consumer is likely to free a cell soon, then stop competing with it for the CPU
+				if (Attempt < 64)
+					std::this_thread::yield();
+				else
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			return true;
+		}
+
+		/** Must only be called from the consumer thread, @return false if the queue is empty */
+		bool TryDequeue(ItemType &OutItem)
+		{
+			const std::uint32_t Position = DequeuePosition.load(std::memory_order_relaxed);
+			FCell &Cell = Cells[Position & Mask];
+			if ((std::int32_t)(Cell.Sequence.load(std::memory_order_acquire) - (Position + 1)) < 0)
+				return false;
+
+			OutItem = std::move(Cell.Item);
+			// Hand the cell to the producer of the next lap
+			Cell.Sequence.store(Position + Mask + 1, std::memory_order_release);
+			DequeuePosition.store(Position + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		std::uint32_t GetCapacity() const
+		{
+			return Mask + 1;
+		}
+
+	private:
+		/** Size of a cache line on the supported platforms */
+		static const std::size_t CacheLineSize = 64;
+
+		struct FCell
+		{
+			std::atomic<std::uint32_t> Sequence;
+			ItemType Item;
+
+			FCell() : Item() {}
+		};
+
+		std::unique_ptr<FCell[]> Cells;
+		std::uint32_t Mask;
+
+		/** Kept on separate cache lines so that producers and the consumer don't invalidate each other */
+		alignas(CacheLineSize) std::atomic<std::uint32_t> EnqueuePosition;
+		alignas(CacheLineSize) std::atomic<std::uint32_t> DequeuePosition;
+	};
+}
@@ -0,0 +1,363 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+
+/**
+ * Engine independent core of the T3D parsing: line trimming, property values, ressource urls and polygon
+ * lines. It only depends on the standard library and works on ranges of any character type, so that it
+ * can be built and measured outside of the editor. T3DParser adapts it to FString, see FT3DRange.
+ */
+namespace T3DCore
+{
+	/** Characters of a string from Begin to End, not null terminated */
+	template<typename CharType>
+	struct TRange
+	{
+		const CharType * Begin;
+		const CharType * End;
+
+		TRange() : Begin(NULL), End(NULL) {}
+		TRange(const CharType * Begin, const CharType * End) : Begin(Begin), End(End) {}
+
+		std::ptrdiff_t Len() const { return End - Begin; }
+		bool IsEmpty() const { return End == Begin; }
+		CharType operator[](std::ptrdiff_t Index) const { return Begin[Index]; }
+
+		TRange Mid(std::ptrdiff_t Start, std::ptrdiff_t Count) const
+		{
+			return TRange(Begin + Start, Begin + Start + Count);
+		}
+
+		/** @return the index of the first occurrence of Char, -1 if there is none */
+		std::ptrdiff_t FindChar(CharType Char, std::ptrdiff_t From = 0) const
+		{
+			for (const CharType * Iter = Begin + From; Iter < End; ++Iter)
+			{
+				if (*Iter == Char)
+					return Iter - Begin;
+			}
+			return -1;
+		}
+
+		std::ptrdiff_t FindLastChar(CharType Char) const
+		{
+			for (const CharType * Iter = End; Iter > Begin; --Iter)
+			{
+				if (Iter[-1] == Char)
+					return Iter - 1 - Begin;
+			}
+			return -1;
+		}
+
+		/** @return the index of the first occurrence of Key, case sensitive, -1 if there is none */
+		std::ptrdiff_t Find(const TRange &Key) const
+		{
+			const std::ptrdiff_t KeyLen = Key.Len();
+			for (const CharType * Iter = Begin; End - Iter >= KeyLen; ++Iter)
+			{
+				std::ptrdiff_t Index = 0;
+				while (Index < KeyLen && Iter[Index] == Key.Begin[Index])
+				{
+					++Index;
+				}
+				if (Index == KeyLen)
+					return Iter - Begin;
+			}
+			return -1;
+		}
+
+		bool StartsWith(const TRange &Prefix) const
+		{
+			if (Len() < Prefix.Len())
+				return false;
+			for (std::ptrdiff_t Index = 0; Index < Prefix.Len(); ++Index)
+			{
+				if (Begin[Index] != Prefix.Begin[Index])
+					return false;
+			}
+			return true;
+		}
+	};
+
+	/** @return the range of a null terminated string */
+	template<typename CharType>
+	TRange<CharType> MakeRange(const CharType * String)
+	{
+		const CharType * End = String;
+		while (*End)
+		{
+			++End;
+		}
+		return TRange<CharType>(String, End);
+	}
+
+	template<typename CharType>
+	bool IsWhitespace(CharType Char)
+	{
+		return Char == ' ' || Char == '\t' || Char == '\r' || Char == '\n' || Char == '\v' || Char == '\f';
+	}
+
+	template<typename CharType>
+	TRange<CharType> Trim(TRange<CharType> Line)
+	{
+		while (Line.Begin < Line.End && IsWhitespace(*Line.Begin))
+		{
+			++Line.Begin;
+		}
+		while (Line.End > Line.Begin && IsWhitespace(Line.End[-1]))
+		{
+			--Line.End;
+		}
+		return Line;
+	}
+
+	/** Call Func(Line) for every line of Content split at '\n', empty lines are skipped like ParseIntoArray does */
+	template<typename CharType, typename FuncType>
+	void ForEachLine(const TRange<CharType> &Content, FuncType Func)
+	{
+		const CharType * Start = Content.Begin;
+		for (const CharType * Iter = Content.Begin; Iter < Content.End; ++Iter)
+		{
+			if (*Iter == '\n')
+			{
+				if (Iter > Start)
+				{
+					Func(TRange<CharType>(Start, Iter));
+				}
+				Start = Iter + 1;
+			}
+		}
+		if (Content.End > Start)
+		{
+			Func(TRange<CharType>(Start, Content.End));
+		}
+	}
+
+	/**
+	 * Find the value following the first occurrence of Key in Line. A quoted value is returned without its
+	 * quotes, a parenthesized one with its parentheses, and any other one up to a space, a comma or a ')'.
+	 * @param MaxIndex - The value is only returned if Key starts at or before this index
+	 */
+	template<typename CharType>
+	bool FindValueAfter(const TRange<CharType> &Line, const TRange<CharType> &Key, std::ptrdiff_t MaxIndex, TRange<CharType> &Value)
+	{
+		const std::ptrdiff_t KeyIndex = Line.Find(Key);
+		if (KeyIndex == -1 || KeyIndex > MaxIndex)
+			return false;
+
+		const CharType * Start = Line.Begin + KeyIndex + Key.Len();
+		const CharType * Buffer = Start;
+		if (Buffer < Line.End && *Buffer == '"')
+		{
+			++Start;
+			++Buffer;
+			bool bEscaping = false;
+			while (Buffer < Line.End && (*Buffer != '"' || bEscaping))
+			{
+				if (bEscaping)
+					bEscaping = false;
+				else if (*Buffer == '\\')
+					bEscaping = true;
+				++Buffer;
+			}
+		}
+		else if (Buffer < Line.End && *Buffer == '(')
+		{
+			++Buffer;
+			int Level = 1;
+			while (Buffer < Line.End && Level != 0)
+			{
+				if (*Buffer == '(')
+					++Level;
+				else if (*Buffer == ')')
+					--Level;
+				++Buffer;
+			}
+		}
+		else
+		{
+			while (Buffer < Line.End && *Buffer != ' ' && *Buffer != ',' && *Buffer != ')')
+			{
+				++Buffer;
+			}
+		}
+
+		Value = TRange<CharType>(Start, Buffer);
+		return true;
+	}
+
+	/** Split a "Name=Value" line at its first '=', the name can't be empty */
+	template<typename CharType>
+	bool SplitProperty(const TRange<CharType> &Line, TRange<CharType> &Name, TRange<CharType> &Value)
+	{
+		const std::ptrdiff_t Index = Line.FindChar('=');
+		if (Index <= 0)
+			return false;
+
+		Name = TRange<CharType>(Line.Begin, Line.Begin + Index);
+		Value = TRange<CharType>(Line.Begin + Index + 1, Line.End);
+		return true;
+	}
+
+	/**
+	 * Split a "Type'Package.Group.Name'" url, bHasPackage is false for "Type'Name'" urls, whose package is
+	 * the one being imported.
+	 */
+	template<typename CharType>
+	bool ParseRessourceUrl(const TRange<CharType> &Url, TRange<CharType> &Type, bool &bHasPackage, TRange<CharType> &Package, TRange<CharType> &Name)
+	{
+		const std::ptrdiff_t Index = Url.FindChar('\'');
+		if (Index == -1 || Url.IsEmpty() || Url.End[-1] != '\'')
+			return false;
+
+		Type = TRange<CharType>(Url.Begin, Url.Begin + Index);
+		const CharType * NameEnd = Url.End - 1 > Url.Begin + Index ? Url.End - 1 : Url.Begin + Index + 1;
+		const std::ptrdiff_t PackageIndex = Url.FindChar('.', Index + 1);
+		bHasPackage = PackageIndex != -1;
+		if (!bHasPackage)
+		{
+			Package = TRange<CharType>();
+			Name = TRange<CharType>(Url.Begin + Index + 1, NameEnd);
+		}
+		else
+		{
+			Package = TRange<CharType>(Url.Begin + Index + 1, Url.Begin + PackageIndex);
+			Name = TRange<CharType>(Url.Begin + Url.FindLastChar('.') + 1, NameEnd);
+		}
+		return true;
+	}
+
+	/** Split a "Package.Group.Name" path, Name is empty if there is no '.' */
+	template<typename CharType>
+	void SplitPackagePath(const TRange<CharType> &Path, TRange<CharType> &Package, TRange<CharType> &Name)
+	{
+		const std::ptrdiff_t PackageIndex = Path.FindChar('.');
+		if (PackageIndex == -1)
+		{
+			Package = Path;
+			Name = TRange<CharType>(Path.End, Path.End);
+		}
+		else
+		{
+			Package = TRange<CharType>(Path.Begin, Path.Begin + PackageIndex);
+			Name = TRange<CharType>(Path.Begin + Path.FindLastChar('.') + 1, Path.End);
+		}
+	}
+
+	/** Parse the number at the start of Stream like atof does, @return the character following it */
+	template<typename CharType>
+	const CharType * ParseNumber(const CharType * Stream, double &Value)
+	{
+		while (IsWhitespace(*Stream))
+		{
+			++Stream;
+		}
+
+		// Numbers are ASCII, they are narrowed to use strtod whatever the character type
+		char Buffer[64];
+		int Length = 0;
+		while (Length < (int)sizeof(Buffer) - 1 && ((*Stream >= '0' && *Stream <= '9') || *Stream == '+' || *Stream == '-' || *Stream == '.' || *Stream == 'e' || *Stream == 'E'))
+		{
+			Buffer[Length++] = (char)*Stream++;
+		}
+		Buffer[Length] = 0;
+		Value = std::strtod(Buffer, NULL);
+		return Stream;
+	}
+
+	/** Parse "X,Y,Z", @return false if a component is missing, the missing ones are left to 0 */
+	template<typename CharType>
+	bool ParseVector(const CharType * Stream, double Vector[3])
+	{
+		Vector[0] = Vector[1] = Vector[2] = 0.0;
+		for (int Component = 0; Component < 3; ++Component)
+		{
+			Stream = ParseNumber(Stream, Vector[Component]);
+			if (Component == 2)
+				break;
+
+			while (*Stream && *Stream != ',')
+			{
+				++Stream;
+			}
+			if (!*Stream)
+				return false;
+			++Stream;
+		}
+		return true;
+	}
+
+	/**
+	 * Match Command at the start of Stream, case insensitive and followed by a non alphanumeric character,
+	 * then skip it and the following whitespaces.
+	 */
+	template<typename CharType>
+	bool MatchCommand(const CharType * &Stream, const char * Command)
+	{
+		const CharType * Iter = Stream;
+		while (IsWhitespace(*Iter))
+		{
+			++Iter;
+		}
+
+		for (; *Command; ++Command, ++Iter)
+		{
+			CharType Char = *Iter;
+			if (Char >= 'a' && Char <= 'z')
+				Char = Char - 'a' + 'A';
+			if (Char != (CharType)*Command)
+				return false;
+		}
+
+		const CharType Next = *Iter;
+		if ((Next >= '0' && Next <= '9') || (Next >= 'a' && Next <= 'z') || (Next >= 'A' && Next <= 'Z') || Next == '_')
+			return false;
+
+		while (IsWhitespace(*Iter))
+		{
+			++Iter;
+		}
+		Stream = Iter;
+		return true;
+	}
+
+	enum class EPolyLine
+	{
+		Origin,
+		Vertex,
+		TextureU,
+		TextureV,
+		Normal,
+		Other
+	};
+
+	/** Parse a line of a "Begin Polygon" block, Vector receives its value unless it is Other */
+	template<typename CharType>
+	EPolyLine ParsePolyLine(const CharType * Line, double Vector[3])
+	{
+		static const struct
+		{
+			const char * Command;
+			EPolyLine Type;
+		} Commands[] =
+		{
+			{ "ORIGIN", EPolyLine::Origin },
+			{ "VERTEX", EPolyLine::Vertex },
+			{ "TEXTUREU", EPolyLine::TextureU },
+			{ "TEXTUREV", EPolyLine::TextureV },
+			{ "NORMAL", EPolyLine::Normal }
+		};
+
+		for (const auto &Command : Commands)
+		{
+			const CharType * Stream = Line;
+			if (MatchCommand(Stream, Command.Command))
+			{
+				ParseVector(Stream, Vector);
+				return Command.Type;
+			}
+		}
+		return EPolyLine::Other;
+	}
+}
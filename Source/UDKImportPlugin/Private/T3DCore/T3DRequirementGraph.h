@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace T3DCore
+{
+	/**
+	 * Objects required by parsed T3D files and the actions waiting for them. A requirement is pending until
+	 * it is fixed to an object, which runs its actions, then the actions added to it later run right away.
+	 * It only depends on the standard library, T3DParser adapts it to FRequirement and UObject delegates.
+	 * @param KeyType - Identifies a requirement, hashed with HasherType and compared with operator==
+	 * @param ActionType - Called as Action(Object) once its requirement is fixed
+	 * @param ObjectType - Copied into the graph, usually a pointer
+	 */
+	template<typename KeyType, typename ActionType, typename ObjectType, typename HasherType = std::hash<KeyType> >
+	class TRequirementGraph
+	{
+	public:
+		/** Run Action if Key is fixed, otherwise keep it until Key gets fixed */
+		void Add(const KeyType &Key, ActionType Action)
+		{
+			typename FFixedMap::const_iterator Fixed = FixedObjects.find(Key);
+			if (Fixed != FixedObjects.end())
+			{
+				Action(Fixed->second);
+				return;
+			}
+			PendingActions[Key].push_back(std::move(Action));
+		}
+
+		/** Fix Key to Object, then run and drop the actions waiting for it. Actions may add requirements */
+		void Fix(const KeyType &Key, const ObjectType &Object)
+		{
+			FixedObjects[Key] = Object;
+
+			typename FPendingMap::iterator Pending = PendingActions.find(Key);
+			if (Pending == PendingActions.end())
+				return;
+
+			// Moved out first, the actions may add requirements and rehash PendingActions
+			std::vector<ActionType> Actions = std::move(Pending->second);
+			PendingActions.erase(Pending);
+			for (ActionType &Action : Actions)
+			{
+				Action(Object);
+			}
+		}
+
+		/** @return the object Key is fixed to, NULL while it is pending */
+		const ObjectType * Find(const KeyType &Key) const
+		{
+			typename FFixedMap::const_iterator Fixed = FixedObjects.find(Key);
+			return Fixed != FixedObjects.end() ? &Fixed->second : NULL;
+		}
+
+		bool IsPending(const KeyType &Key) const
+		{
+			return PendingActions.find(Key) != PendingActions.end();
+		}
+
+		std::size_t NumPending() const { return PendingActions.size(); }
+		std::size_t NumFixed() const { return FixedObjects.size(); }
+
+		/** Call Func(Key) for every pending requirement, Func must not add nor fix requirements */
+		template<typename FuncType>
+		void ForEachPending(FuncType Func) const
+		{
+			for (const typename FPendingMap::value_type &Pending : PendingActions)
+			{
+				Func(Pending.first);
+			}
+		}
+
+		/** Call Func(Key, Object) for every fixed requirement, Func must not add nor fix requirements */
+		template<typename FuncType>
+		void ForEachFixed(FuncType Func) const
+		{
+			for (const typename FFixedMap::value_type &Fixed : FixedObjects)
+			{
+				Func(Fixed.first, Fixed.second);
+			}
+		}
+
+		void Reset()
+		{
+			PendingActions.clear();
+			FixedObjects.clear();
+		}
+
+	private:
+		typedef std::unordered_map<KeyType, std::vector<ActionType>, HasherType> FPendingMap;
+		typedef std::unordered_map<KeyType, ObjectType, HasherType> FFixedMap;
+
+		FPendingMap PendingActions;
+		FFixedMap FixedObjects;
+	};
+}
@@ -2,20 +2,47 @@
 #include "Editor/UnrealEd/Public/BSPOps.h"
 #include "Runtime/Engine/Public/ComponentReregisterContext.h"
 #include "Runtime/Engine/Classes/Sound/SoundNode.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
 #include "T3DLevelParser.h"
 #include "T3DMaterialParser.h"
 #include "T3DMaterialInstanceConstantParser.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "UDKBrushBaker.h"
+#include "UDKImportFilter.h"
+#include "UDKImportPipeline.h"
+#include "UDKImportPluginSettings.h"
+#include "UDKImportProfiler.h"
 
-T3DLevelParser::T3DLevelParser(const FString &UdkPath, const FString &TmpPath) : T3DParser(UdkPath, TmpPath)
+const uint32 T3DLevelParser::ParsedBlockQueueCapacity = 4096;
+
+T3DLevelParser::T3DLevelParser(const FString &UdkPath, const FString &TmpPath) : T3DLevelParser(UdkPath, TmpPath, GetDefault<UUDKImportPluginSettings>())
+{
+}
+
+T3DLevelParser::T3DLevelParser(const FString &UdkPath, const FString &TmpPath, const UUDKImportPluginSettings * Settings) : T3DParser(UdkPath, TmpPath, Settings)
 {
 	this->World = NULL;
+	this->NextPendingRequirement = 0;
+	this->bFixedPendingRequirement = false;
+	this->ImportedBlockCount = 0;
+	this->NextBrushOrder = 1;
+	this->bRespawnBrushes = false;
+	this->bParsedFromCache = false;
+	this->SkippedActorCount = 0;
+	this->UnchangedActorCount = 0;
+	this->MemoryAfterLastCollection = 0;
+	this->Settings = Settings;
+}
 
-	// Initialize brush order tracking
-	BrushOrderCounter = 0;
+T3DLevelParser::~T3DLevelParser()
+{
+	// Parse tasks of a cancelled import may still be waiting for the applier
+	bAbortParse = true;
+	WaitForParseTasks();
 }
 
-template<class T>
-T * T3DLevelParser::SpawnActor()
+void T3DLevelParser::FindWorld()
 {
 	if (World == NULL)
 	{
@@ -23,48 +50,164 @@ T * T3DLevelParser::SpawnActor()
 		World = LevelEditorModule.GetFirstLevelEditor().Get()->GetWorld();
 	}
 	ensure(World != NULL);
+}
 
-	return World->SpawnActor<T>();
+template<class T>
+T * T3DLevelParser::SpawnActor(ULevel * Level)
+{
+	FindWorld();
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.OverrideLevel = Level;
+	T * Actor = World->SpawnActor<T>(SpawnParameters);
+	BlockActors.Add(Actor);
+	return Actor;
+}
+
+ULevel * T3DLevelParser::GetSpawnLevel(const FVector &Location)
+{
+	return SubLevelSharder.IsValid() ? SubLevelSharder->GetLevelFor(Location) : NULL;
 }
 
 void T3DLevelParser::ImportLevel(const FString &Level)
 {
 	GWarn->BeginSlowTask(LOCTEXT("StatusBeginLevel", "Importing requested level"), true, false);
+	FUDKImportPipeline Pipeline;
+	AddLevelImportStages(Pipeline, Level);
+	Pipeline.RunSynchronously();
+	GWarn->EndSlowTask();
+}
+
+void T3DLevelParser::AddLevelImportStages(FUDKImportPipeline &Pipeline, const FString &Level)
+{
 	StatusNumerator = 0;
-	StatusDenominator = 12;
-	
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ExportUDKLevelT3D", "Exporting UDK Level informations"));
+	StatusDenominator = 13;
+	FUDKImportProfiler::Get().Begin();
+
+	Pipeline.AddStage(FUDKImportPipeline::EThread::Worker, [this, Level]()
 	{
+		UpdateStatus(LOCTEXT("ExportUDKLevelT3D", "Exporting UDK Level informations"));
 		const FString CommandLine = FString::Printf(TEXT("batchexport %s Level T3D %s"), *Level, *TmpPath);
-		if (RunUDK(CommandLine) != 0)
+		Package = Level;
+		return RunUDK(CommandLine) == 0;
+	});
+
+	Pipeline.AddStage(FUDKImportPipeline::EThread::Worker, [this]()
+	{
+		UpdateStatus(LOCTEXT("LoadUDKLevelT3D", "Loading UDK Level informations"));
+		return LoadParsedLevel();
+	});
+
+	Pipeline.AddStage(FUDKImportPipeline::EThread::GameThread, [this]()
+	{
+		UpdateStatus(LOCTEXT("ImportingUDKLevel", "Importing UDK Level actors"));
+		BeginImportParsedLevel();
+		return true;
+	});
+
+	// Actors are spawned a few at a time so that the editor keeps running while large maps are imported
+	Pipeline.AddSlicedStage([this](double EndTime)
+	{
+		return ImportParsedBlocks(EndTime) ? FUDKImportPipeline::ESliceResult::Done : FUDKImportPipeline::ESliceResult::Pending;
+	});
+
+	Pipeline.AddStage(FUDKImportPipeline::EThread::GameThread, [this]()
+	{
+		EndImportParsedLevel();
+		return true;
+	});
+
+	Pipeline.AddStage(FUDKImportPipeline::EThread::Worker, [this]()
+	{
+		SaveParsedLevel();
+		return true;
+	});
+
+	AddResolveRequirementsStages(Pipeline);
+
+	// Sub-levels are saved once their actors got their requirements, a few at a time so that the editor keeps running
+	Pipeline.AddSlicedStage([this](double EndTime)
+	{
+		if (SubLevelSharder.IsValid() && !SubLevelSharder->SaveLevels(EndTime))
+			return FUDKImportPipeline::ESliceResult::Pending;
+
+		if (SubLevelSharder.IsValid())
 		{
-			GWarn->EndSlowTask();
-			return;
+			FUDKImportProfiler::Get().AddCount(TEXT("SubLevels"), SubLevelSharder->GetLevelCount());
 		}
-	}
+		SubLevelSharder.Reset();
+		return FUDKImportPipeline::ESliceResult::Done;
+	});
 
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("LoadUDKLevelT3D", "Loading UDK Level informations"));
+	Pipeline.AddStage(FUDKImportPipeline::EThread::GameThread, [this, Level]()
 	{
-		FString UdkLevelT3D;
-		if (!FFileHelper::LoadFileToString(UdkLevelT3D, *(TmpPath / TEXT("PersistentLevel.T3D"))))
+		// Dump brush manifest to TmpPath for richer editor-side parsing
+		if (Settings->bBinaryBrushManifest)
 		{
-			GWarn->EndSlowTask();
-			return;
+			WriteBrushManifest(TmpPath / TEXT("BrushesManifest.bin"), FUDKBrushManifestWriter::EFormat::Binary);
+		}
+		else
+		{
+			WriteBrushManifest(TmpPath / TEXT("BrushesManifest.json"), FUDKBrushManifestWriter::EFormat::Json);
 		}
 
-		ResetParser(UdkLevelT3D);
-		Package = Level;
-	}
+		if (Settings->bBakeBrushesToStaticMeshes)
+		{
+			UpdateStatus(LOCTEXT("BakeBrushes", "Baking brushes into static meshes"));
+			BakeBrushes();
+		}
 
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ParsingUDKLevelT3D", "Parsing UDK Level informations"));
-	ImportLevel();
+		if (Settings->bIncrementalReimport)
+		{
+			ImportManifest.Save(TmpPath / TEXT("ImportManifest.json"), Level);
+		}
 
-	ResolveRequirements();
-	GWarn->EndSlowTask();
+		ParsedLevel.Reset();
+		FUDKImportProfiler::Get().WriteReport(TmpPath / TEXT("ImportReport.json"));
+		return true;
+	});
+}
+
+bool T3DLevelParser::LoadParsedLevel()
+{
+	const FString T3DFileName = TmpPath / TEXT("PersistentLevel.T3D");
+	const FString CacheFileName = TmpPath / TEXT("PersistentLevel.t3db");
+	const FUDKImportFilter ImportFilter(Settings);
+	UDK_IMPORT_PROFILE_SCOPE(LoadParsedLevel);
+	const FMD5Hash SourceHash = FMD5Hash::HashFile(*T3DFileName);
+	if (!SourceHash.IsValid())
+		return false;
+	FUDKImportProfiler::Get().AddBytes(TEXT("LevelT3D"), IFileManager::Get().FileSize(*T3DFileName));
+
+	// Block hashes are only computed for incremental re-imports, see ScanLevel
+	const FString FilterSignature = ImportFilter.GetSignature() + (Settings->bIncrementalReimport ? TEXT("|Hashed") : TEXT(""));
+	BlockBeginLines.Empty();
+	BlockEndLines.Empty();
+	bParsedFromCache = Settings->bCacheParsedLevels && ParsedLevel.LoadCache(CacheFileName, SourceHash, FilterSignature);
+	if (Settings->bCacheParsedLevels)
+	{
+		FUDKImportProfiler::Get().AddCacheLookup(TEXT("ParsedLevel"), bParsedFromCache);
+	}
+	if (bParsedFromCache)
+	{
+		UE_LOG(UDKImportPluginLog, Log, TEXT("Using parsed level cache %s"), *CacheFileName);
+	}
+	else
+	{
+		FString UdkLevelT3D;
+		if (!FFileHelper::LoadFileToString(UdkLevelT3D, *T3DFileName))
+			return false;
+
+		ResetParser(UdkLevelT3D);
+		UdkLevelT3D.Empty();
+		ScanLevel(ImportFilter);
+		ParsedLevel.SourceHash = SourceHash;
+		ParsedLevel.FilterSignature = FilterSignature;
+	}
 
-	// Dump brush manifest to TmpPath for richer editor-side parsing
-	FString ManifestPath = TmpPath / TEXT("BrushesManifest.json");
-	WriteBrushManifest(ManifestPath);
+	// Blocks are parsed while the previous ones get imported, see ImportParsedBlocks
+	StartParseTasks();
+	return true;
 }
 
 void T3DLevelParser::ImportStaticMesh(const FString &StaticMesh)
@@ -82,26 +225,58 @@ void T3DLevelParser::ImportMaterialInstanceConstant(const FString &MaterialInsta
 	ImportRessource(MaterialInstanceConstant, EExportType::MaterialInstanceConstant);
 }
 
+void T3DLevelParser::AddStaticMeshImportStages(FUDKImportPipeline &Pipeline, const FString &StaticMesh)
+{
+	AddRessourceImportStages(Pipeline, StaticMesh, EExportType::StaticMesh);
+}
+
+void T3DLevelParser::AddMaterialImportStages(FUDKImportPipeline &Pipeline, const FString &Material)
+{
+	AddRessourceImportStages(Pipeline, Material, EExportType::Material);
+}
+
+void T3DLevelParser::AddMaterialInstanceConstantImportStages(FUDKImportPipeline &Pipeline, const FString &MaterialInstanceConstant)
+{
+	AddRessourceImportStages(Pipeline, MaterialInstanceConstant, EExportType::MaterialInstanceConstant);
+}
+
 void T3DLevelParser::ImportRessource(const FString &Ressource, EExportType::Type Type)
+{
+	GWarn->BeginSlowTask(LOCTEXT("StatusBeginMaterialRessouce", "Importing requested ressource"), true, false);
+	FUDKImportPipeline Pipeline;
+	AddRessourceImportStages(Pipeline, Ressource, Type);
+	Pipeline.RunSynchronously();
+	GWarn->EndSlowTask();
+}
+
+void T3DLevelParser::AddRessourceImportStages(FUDKImportPipeline &Pipeline, const FString &Ressource, EExportType::Type Type)
 {
 	StatusNumerator = 0;
-	StatusDenominator = 9;
+	StatusDenominator = 10;
+	FUDKImportProfiler::Get().Begin();
 
-	FString Name;
-	ParseRessourceUrl(Ressource, Package, Name);
-	if (Name.Len() > 0)
-	{
-		GWarn->BeginSlowTask(LOCTEXT("StatusBeginMaterialRessouce", "Importing requested ressource"), true, false);
-		AddRequirement(FString::Printf(TEXT("%s'%s.%s'"), *RessourceTypeFor(Type), *Package, *Name), UObjectDelegate());
-	}
-	else
+	Pipeline.AddStage(FUDKImportPipeline::EThread::Worker, [this, Ressource, Type]()
 	{
-		GWarn->BeginSlowTask(LOCTEXT("StatusBeginMaterialRessouces", "Importing requested ressource package"), true, false);
-		ExportPackageToRequirements(Package, Type);
-	}
+		FString Name;
+		ParseRessourceUrl(Ressource, Package, Name);
+		if (Name.Len() > 0)
+		{
+			AddRequirement(FString::Printf(TEXT("%s'%s.%s'"), *RessourceTypeFor(Type), *Package, *Name), UObjectDelegate());
+		}
+		else
+		{
+			ExportPackageToRequirements(Package, Type);
+		}
+		return !IsCancelled();
+	});
 
-	ResolveRequirements();
-	GWarn->EndSlowTask();
+	AddResolveRequirementsStages(Pipeline);
+
+	Pipeline.AddStage(FUDKImportPipeline::EThread::GameThread, [this]()
+	{
+		FUDKImportProfiler::Get().WriteReport(TmpPath / TEXT("ImportReport.json"));
+		return true;
+	});
 }
 
 FString T3DLevelParser::ExportFolderFor(EExportType::Type Type)
@@ -158,6 +333,19 @@ bool T3DLevelParser::ExportPackage(const FString &Package, EExportType::Type Typ
 {
 	ExportFolder = ExportFolderFor(Type) / Package;
 
+	TSharedPtr<FCriticalSection, ESPMode::ThreadSafe> ExportFolderLock;
+	{
+		FScopeLock Lock(&ExportFolderLocksGuard);
+		TSharedPtr<FCriticalSection, ESPMode::ThreadSafe> &FolderLock = ExportFolderLocks.FindOrAdd(ExportFolder);
+		if (!FolderLock.IsValid())
+		{
+			FolderLock = MakeShareable(new FCriticalSection());
+		}
+		ExportFolderLock = FolderLock;
+	}
+
+	// The folder exists as soon as UDK starts the export, wait for it to be done
+	FScopeLock Lock(ExportFolderLock.Get());
 	if (!IFileManager::Get().DirectoryExists(*ExportFolder))
 	{
 		FString Command;
@@ -177,40 +365,236 @@ bool T3DLevelParser::ExportPackage(const FString &Package, EExportType::Type Typ
 	return true;
 }
 
-void T3DLevelParser::ResolveRequirements()
+void T3DLevelParser::AddResolveRequirementsStages(FUDKImportPipeline &Pipeline)
 {
-	FAssetToolsModule& AssetToolsModule = FModuleManager::Get().LoadModuleChecked<FAssetToolsModule>("AssetTools");
-	
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ExportStaticMeshRequirements", "Exporting StaticMesh referenced assets"));
-	ExportStaticMeshRequirements();
+	typedef FUDKImportPipeline::FStageId FStageId;
 
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ExportMaterialInstanceConstantAssets", "Exporting MaterialInstanceConstant assets"));
-	ExportMaterialInstanceConstantAssets();
+	// Requirements is only accessed by game thread stages, worker stages get a copy of the requirements they handle
+	CollectedRequirementUrls.Empty();
+	MemoryAfterLastCollection = 0;
+	PendingAssetExportStages.Set(AssetExportStageCount);
+	const FStageId Start = Pipeline.GetLastStage();
 
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ExportMaterialAssets", "Exporting ExportMaterial assets"));
-	ExportMaterialAssets();
+	// Scanning the asset registry can take a while on large projects, it waits for the import to start
+	const FStageId IndexAssets = Pipeline.AddStage(FUDKImportPipeline::EThread::GameThread, [this]()
+	{
+		UpdateStatus(LOCTEXT("IndexImportedAssets", "Indexing previously imported assets"));
+		ImportedAssets.Build(TEXT("/Game/UDK"));
+		return true;
+	}, Start != INDEX_NONE ? TArray<FStageId>({ Start }) : TArray<FStageId>());
+	const TArray<FStageId> AfterStart = { IndexAssets };
+
+	// Meshes only depend on the requirements found while importing actors, they are converted while materials are imported
+	const FStageId CollectStaticMeshes = Pipeline.AddStage(FUDKImportPipeline::EThread::GameThread, [this]()
+	{
+		CollectRequirements(TEXT("StaticMesh"), StaticMeshAssetRequirements);
+		return true;
+	}, AfterStart);
 
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ExportTextureAssets", "Exporting Texture assets"));
-	ExportTextureAssets();
+	// Both mesh stages run UDK over the same mesh packages, the materials script runs first so that they
+	// never run at the same time. The material stages only wait for the script.
+	const FStageId StaticMeshRequirements = Pipeline.AddStage(FUDKImportPipeline::EThread::Worker, [this]()
+	{
+		UpdateStatus(LOCTEXT("ExportStaticMeshRequirements", "Exporting StaticMesh referenced assets"));
+		ExportStaticMeshRequirements(StaticMeshAssetRequirements);
+		return !IsCancelled();
+	}, { CollectStaticMeshes });
 
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ExportStaticMeshAssets", "Exporting StaticMesh assets"));
-	ExportStaticMeshAssets();
-	
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ImportAssets", "Importing Assets"));
-	TArray<FString> AssetsPath;
-	AssetsPath.Add(TmpPath / TEXT("UDK"));
-	AssetToolsModule.Get().ImportAssets(AssetsPath, TEXT("/Game/"));
-	
-	GWarn->StatusUpdate(++StatusNumerator, StatusDenominator, LOCTEXT("ResolvingLinks", "Updating actors assets"));
-	UTexture2D * DefaultTexture2D = FindObject<UTexture2D>(NULL, TEXT("/Engine/EngineResources/DefaultTexture.DefaultTexture"));
-	for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
+	const FStageId StaticMeshAssets = Pipeline.AddStage(FUDKImportPipeline::EThread::Worker, [this]()
+	{
+		UpdateStatus(LOCTEXT("ExportStaticMeshAssets", "Exporting StaticMesh assets"));
+		ExportStaticMeshAssets(StaticMeshAssetRequirements);
+		PendingAssetExportStages.Decrement();
+		return !IsCancelled();
+	}, { StaticMeshRequirements });
+
+	Pipeline.AddStage(FUDKImportPipeline::EThread::GameThread, [this]()
+	{
+		ParseStaticMeshRequirements();
+		CollectPendingRequirements(TEXT("MaterialInstanceConstant"));
+		return true;
+	}, { StaticMeshRequirements });
+
+	Pipeline.AddStage(FUDKImportPipeline::EThread::Worker, [this]()
+	{
+		UpdateStatus(LOCTEXT("ExportMaterialInstanceConstantAssets", "Exporting MaterialInstanceConstant assets"));
+		if (Settings->bImportMaterials)
+			ExportMaterialInstanceConstantPackages(PendingRequirements);
+		return !IsCancelled();
+	});
+
+	const FStageId MaterialInstanceConstants = Pipeline.AddSlicedStage([this](double EndTime)
+	{
+		const bool bDone = !Settings->bImportMaterials || ExportMaterialInstanceConstantAssets(EndTime);
+		return bDone ? FUDKImportPipeline::ESliceResult::Done : FUDKImportPipeline::ESliceResult::Pending;
+	});
+
+	// Textures of the material instances are exported while materials are
+	const FStageId CollectInstanceTextures = Pipeline.AddStage(FUDKImportPipeline::EThread::GameThread, [this]()
+	{
+		CollectRequirements(TEXT("Texture"), InstanceTextureAssetRequirements);
+		return true;
+	}, { MaterialInstanceConstants });
+
+	const FStageId InstanceTextureAssets = Pipeline.AddStage(FUDKImportPipeline::EThread::Worker, [this]()
+	{
+		UpdateStatus(LOCTEXT("ExportTextureAssets", "Exporting Texture assets"));
+		if (Settings->bImportTextures)
+			ExportTextureAssets(InstanceTextureAssetRequirements);
+		PendingAssetExportStages.Decrement();
+		return !IsCancelled();
+	}, { CollectInstanceTextures });
+
+	const FStageId CollectMaterials = Pipeline.AddStage(FUDKImportPipeline::EThread::GameThread, [this]()
+	{
+		CollectPendingRequirements(TEXT("Material"));
+		return true;
+	}, { MaterialInstanceConstants });
+
+	// Materials are parsed in parallel, the game thread only creates their objects
+	Pipeline.AddStage(FUDKImportPipeline::EThread::Worker, [this]()
+	{
+		UpdateStatus(LOCTEXT("ExportMaterialAssets", "Exporting ExportMaterial assets"));
+		if (Settings->bImportMaterials)
+		{
+			ExportRequiredPackages(PendingRequirements, EExportType::Material);
+			ParseMaterials();
+		}
+		return !IsCancelled();
+	}, { CollectMaterials });
+
+	Pipeline.AddSlicedStage([this](double EndTime)
+	{
+		const bool bDone = !Settings->bImportMaterials || ExportMaterialAssets(EndTime);
+		return bDone ? FUDKImportPipeline::ESliceResult::Done : FUDKImportPipeline::ESliceResult::Pending;
+	});
+
+	Pipeline.AddStage(FUDKImportPipeline::EThread::GameThread, [this]()
+	{
+		CollectRequirements(TEXT("Texture"), TextureAssetRequirements);
+		return true;
+	});
+
+	// Waits for the instance textures, so that a texture package is never exported by two stages at once
+	const FStageId TextureAssets = Pipeline.AddStage(FUDKImportPipeline::EThread::Worker, [this]()
+	{
+		if (Settings->bImportTextures)
+			ExportTextureAssets(TextureAssetRequirements);
+		PendingAssetExportStages.Decrement();
+		return !IsCancelled();
+	}, { Pipeline.GetLastStage(), InstanceTextureAssets });
+
+	// Packages are imported as soon as their export is done, while the next ones are being exported
+	const FStageId ExportedAssets = Pipeline.AddSlicedStage([this](double EndTime)
+	{
+		return ImportExportedAssets(EndTime) ? FUDKImportPipeline::ESliceResult::Done : FUDKImportPipeline::ESliceResult::Pending;
+	}, AfterStart);
+
+	Pipeline.AddStage(FUDKImportPipeline::EThread::GameThread, [this]()
+	{
+		StaticMeshAssetRequirements.Empty();
+		InstanceTextureAssetRequirements.Empty();
+		TextureAssetRequirements.Empty();
+		MaterialReflectionCache.Empty();
+		ImportRequiredAssets();
+		ImportedAssets.Empty();
+		PolygonMaterialGroupIndices.Empty();
+		PolygonMaterialGroups.Empty();
+		return true;
+	}, { TextureAssets, StaticMeshAssets, ExportedAssets });
+}
+
+void T3DLevelParser::QueueAssetImport(const FString &DestinationPath, const TArray<FString> &Files)
+{
+	if (Files.Num() > 0)
+	{
+		FExportedPackageAssets PackageAssets;
+		PackageAssets.DestinationPath = DestinationPath;
+		PackageAssets.Files = Files;
+		ExportedPackageAssets.Enqueue(PackageAssets);
+	}
+}
+
+bool T3DLevelParser::ImportExportedAssets(double EndTime)
+{
+	IAssetTools &AssetTools = FModuleManager::Get().LoadModuleChecked<FAssetToolsModule>("AssetTools").Get();
+
+	// Read before draining, every package of the export stages that are done is then already queued
+	const bool bExportsDone = PendingAssetExportStages.GetValue() == 0;
+
+	FExportedPackageAssets PackageAssets;
+	while (ExportedPackageAssets.Dequeue(PackageAssets))
+	{
+		UDK_IMPORT_PROFILE_SCOPE(ImportAssets);
+		const double StartTime = FPlatformTime::Seconds();
+		for (UObject * Asset : AssetTools.ImportAssets(PackageAssets.Files, PackageAssets.DestinationPath, NULL, false))
+		{
+			ImportedAssets.Add(Asset);
+		}
+		FUDKImportProfiler::Get().AddAssetTime(PackageAssets.DestinationPath, FPlatformTime::Seconds() - StartTime);
+		FUDKImportProfiler::Get().AddCount(TEXT("ImportedAssetFiles"), PackageAssets.Files.Num());
+
+		// Packages are imported in waves under a memory budget, the garbage of a wave is collected before the next one
+		EnforceMemoryBudget();
+		if (FPlatformTime::Seconds() >= EndTime)
+			return false;
+	}
+
+	return bExportsDone;
+}
+
+void T3DLevelParser::EnforceMemoryBudget()
+{
+	check(IsInGameThread());
+	const uint64 MemoryBudget = (uint64)FMath::Max(Settings->MemoryBudgetMB, 0) * 1024 * 1024;
+	if (MemoryBudget == 0)
+		return;
+
+	// Imported assets are standalone, a collection that cannot get back under the budget is only retried once memory grew again
+	const uint64 UsedPhysical = FUDKImportProfiler::Get().SampleMemory();
+	if (UsedPhysical > MemoryBudget && UsedPhysical > MemoryAfterLastCollection + MemoryBudget / 10)
+	{
+		UDK_IMPORT_PROFILE_SCOPE(CollectGarbage);
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		MemoryAfterLastCollection = FUDKImportProfiler::Get().SampleMemory();
+		FUDKImportProfiler::Get().AddCount(TEXT("GarbageCollections"));
+		UE_LOG(UDKImportPluginLog, Log, TEXT("Memory budget exceeded (%llu MB used), garbage collected down to %llu MB"), UsedPhysical / (1024 * 1024), MemoryAfterLastCollection / (1024 * 1024));
+	}
+}
+
+void T3DLevelParser::CollectRequirements(const FString &TypePrefix, TArray<FRequirement> &OutRequirements)
+{
+	OutRequirements.Reset();
+	Requirements.ForEachPending([&](const FRequirement &Requirement)
 	{
-		const FRequirement &Requirement = Iter.Key();
+		if (Requirement.Type.StartsWith(TypePrefix) && !CollectedRequirementUrls.Contains(Requirement.Url))
+		{
+			CollectedRequirementUrls.Add(Requirement.Url);
+			OutRequirements.Add(Requirement);
+		}
+	});
+}
+
+void T3DLevelParser::ImportRequiredAssets()
+{
+	UDK_IMPORT_PROFILE_SCOPE(ResolveLinks);
+	// Assets were imported package by package by ImportExportedAssets
+	UpdateStatus(LOCTEXT("ImportAssets", "Importing Assets"));
 
+	UpdateStatus(LOCTEXT("ResolvingLinks", "Updating actors assets"));
+	UTexture2D * DefaultTexture2D = FindObject<UTexture2D>(NULL, TEXT("/Engine/EngineResources/DefaultTexture.DefaultTexture"));
+	// Fixing a requirement removes it from the pending ones, iterate over a copy
+	TArray<FRequirement> RequiredAssets;
+	Requirements.ForEachPending([&RequiredAssets](const FRequirement &Requirement)
+	{
+		RequiredAssets.Add(Requirement);
+	});
+	for (const FRequirement &Requirement : RequiredAssets)
+	{
 		if (Requirement.Type == TEXT("StaticMesh"))
 		{
 			FString ObjectPath = FString::Printf(TEXT("/Game/UDK/%s/Meshes/%s.%s"), *Requirement.Package, *Requirement.Name, *Requirement.Name);
-			UObject * Object = FindObject<UStaticMesh>(NULL, *ObjectPath);
+			UObject * Object = ImportedAssets.Load<UStaticMesh>(ObjectPath);
 			if (Object)
 			{
 				FixRequirement(Requirement, Object);
@@ -219,7 +603,7 @@ void T3DLevelParser::ResolveRequirements()
 		else if (Requirement.Type.StartsWith(TEXT("Texture")))
 		{
 			FString ObjectPath = FString::Printf(TEXT("/Game/UDK/%s/Textures/%s.%s"), *Requirement.Package, *Requirement.Name, *Requirement.Name);
-			UTexture2D * Texture2D = FindObject<UTexture2D>(NULL, *ObjectPath);
+			UTexture2D * Texture2D = ImportedAssets.Load<UTexture2D>(ObjectPath);
 			if (!Texture2D)
 			{
 				UE_LOG(UDKImportPluginLog, Warning, TEXT("Missing requirements : %s"), *Requirement.Url);
@@ -234,8 +618,11 @@ void T3DLevelParser::ResolveRequirements()
 	FGlobalComponentReregisterContext RecreateComponents;
 
 	// Compile Materials
-	PostEditChangeFor(TEXT("Material"));
-	PostEditChangeFor(TEXT("MaterialInstanceConstant"));
+	{
+		UDK_IMPORT_PROFILE_SCOPE(CompileMaterials);
+		PostEditChangeFor(TEXT("Material"));
+		PostEditChangeFor(TEXT("MaterialInstanceConstant"));
+	}
 	PostEditChangeFor(TEXT("StaticMesh"));
 
 	PrintMissingRequirements();
@@ -243,46 +630,43 @@ void T3DLevelParser::ResolveRequirements()
 
 void T3DLevelParser::PostEditChangeFor(const FString &Type)
 {
-	for (auto Iter = FixedRequirements.CreateIterator(); Iter; ++Iter)
+	Requirements.ForEachFixed([&Type](const FRequirement &Requirement, UObject * Object)
 	{
-		const FRequirement &Requirement = Iter.Key();
 		if (Requirement.Type == Type)
 		{
 			if (Requirement.Name == TEXT("MI_StargateSupport_Base"))
 			{
 				UE_LOG(UDKImportPluginLog, Warning, TEXT("Test Me : %s"), *Requirement.Url);
 			}
-			UObject * Object = Iter.Value();
 			if (Object)
 			{
 				Object->PostEditChange();
 			}
 		}
-	}
+	});
 }
 
-void T3DLevelParser::ExportStaticMeshRequirements()
+void T3DLevelParser::ExportStaticMeshRequirements(const TArray<FRequirement> &AssetRequirements)
 {
+	UDK_IMPORT_PROFILE_SCOPE(ExportStaticMeshRequirements);
 	int32 StaticMeshesParamsCount = 0;
 	FString StaticMeshesParams = TEXT("run UDKPluginExport.ExportStaticMeshMaterials");
-	for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
+	for (int32 Index = 0; Index < AssetRequirements.Num() && !IsCancelled(); ++Index)
 	{
-		const FRequirement &Requirement = Iter.Key();
+		if (AssetRequirements[Index].Type != TEXT("StaticMesh"))
+			continue;
 
-		if (Requirement.Type == TEXT("StaticMesh"))
+		StaticMeshesParams += TEXT(" ") + AssetRequirements[Index].OriginalUrl;
+		++StaticMeshesParamsCount;
+		if (StaticMeshesParamsCount >= 200)
 		{
-			StaticMeshesParams += TEXT(" ") + Requirement.OriginalUrl;
-			++StaticMeshesParamsCount;
-			if (StaticMeshesParamsCount >= 200)
-			{
-				ExportStaticMeshRequirements(StaticMeshesParams);
-				StaticMeshesParamsCount = 0;
-				StaticMeshesParams = TEXT("run UDKPluginExport.ExportStaticMeshMaterials");
-			}
+			ExportStaticMeshRequirements(StaticMeshesParams);
+			StaticMeshesParamsCount = 0;
+			StaticMeshesParams = TEXT("run UDKPluginExport.ExportStaticMeshMaterials");
 		}
 	}
 
-	if (StaticMeshesParamsCount > 0)
+	if (StaticMeshesParamsCount > 0 && !IsCancelled())
 	{
 		ExportStaticMeshRequirements(StaticMeshesParams);
 	}
@@ -292,8 +676,29 @@ void T3DLevelParser::ExportStaticMeshRequirements(const FString &StaticMeshesPar
 {
 	FString ExportStaticMeshMaterialsOutput;
 	if (RunUDK(StaticMeshesParams, ExportStaticMeshMaterialsOutput) == 0)
+	{
+		// Only the script logs are parsed, the rest of the UDK output is dropped right away
+		TArray<FString> OutputLines;
+		ExportStaticMeshMaterialsOutput.ParseIntoArrayLines(OutputLines);
+		ExportStaticMeshMaterialsOutput.Empty();
+		for (const FString &OutputLine : OutputLines)
+		{
+			if (OutputLine.StartsWith(TEXT("ScriptLog: ")))
+			{
+				ExportStaticMeshMaterialsOutput += OutputLine + TEXT("\n");
+			}
+		}
+		StaticMeshRequirementsOutputs.Add(MoveTemp(ExportStaticMeshMaterialsOutput));
+	}
+}
+
+void T3DLevelParser::ParseStaticMeshRequirements()
+{
+	// Resolved requirements run their actions right away, this has to happen on the game thread
+	for (FString &ExportStaticMeshMaterialsOutput : StaticMeshRequirementsOutputs)
 	{
 		ResetParser(ExportStaticMeshMaterialsOutput);
+		ExportStaticMeshMaterialsOutput.Empty();
 		while (NextLine())
 		{
 			if (Line.StartsWith(TEXT("ScriptLog: ")))
@@ -310,171 +715,653 @@ void T3DLevelParser::ExportStaticMeshRequirements(const FString &StaticMeshesPar
 			}
 		}
 	}
+	StaticMeshRequirementsOutputs.Empty();
+	Lines.Reset();
 }
 
-void T3DLevelParser::ExportMaterialInstanceConstantAssets()
+void T3DLevelParser::ExportRequiredPackages(const TArray<FRequirement> &AssetRequirements, EExportType::Type ExportType)
 {
-	bool bRequiresAnotherLoop = false;
+	TSet<FString> Packages;
+	for (const FRequirement &Requirement : AssetRequirements)
+	{
+		Packages.Add(Requirement.Package);
+	}
 
-	for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
+	FString ExportFolder;
+	for (const FString &RequiredPackage : Packages)
 	{
-		const FRequirement &Requirement = Iter.Key();
+		if (IsCancelled())
+			break;
+		ExportPackage(RequiredPackage, ExportType, ExportFolder);
+	}
+}
 
-		if (Requirement.Type == TEXT("MaterialInstanceConstant"))
-		{
-			FString ExportFolder;
-			FString FileName = Requirement.Name + TEXT(".T3D");
-			ExportPackage(Requirement.Package, EExportType::MaterialInstanceConstant, ExportFolder);
+void T3DLevelParser::ExportMaterialInstanceConstantPackages(const TArray<FRequirement> &AssetRequirements)
+{
+	UDK_IMPORT_PROFILE_SCOPE(ExportMaterialInstanceConstantPackages);
+	const FString ExportFolder = ExportFolderFor(EExportType::MaterialInstanceConstant);
+	const FString ParentKey = TEXT("Parent=");
+	TSet<FString> VisitedUrls;
+	TArray<FRequirement> Instances;
+	for (const FRequirement &Requirement : AssetRequirements)
+	{
+		VisitedUrls.Add(Requirement.Url);
+		Instances.Add(Requirement);
+	}
 
-			FString ObjectPath = FString::Printf(TEXT("/Game/UDK/%s/MaterialInstances/%s.%s"), *Requirement.Package, *Requirement.Name, *Requirement.Name);
-			UMaterialInstanceConstant * MaterialInstanceConstant = LoadObject<UMaterialInstanceConstant>(NULL, *ObjectPath, NULL, LOAD_NoWarn | LOAD_Quiet);
-			if (!MaterialInstanceConstant)
-			{
-				T3DMaterialInstanceConstantParser MaterialInstanceConstantParser(this, Requirement.Package);
-				MaterialInstanceConstant = MaterialInstanceConstantParser.ImportT3DFile(ExportFolder / FileName);
-			}
+	// Parents are only known once their children are exported, the game thread never has to export them
+	while (Instances.Num() > 0 && !IsCancelled())
+	{
+		ExportRequiredPackages(Instances, EExportType::MaterialInstanceConstant);
 
-			if (MaterialInstanceConstant)
-			{
-				bRequiresAnotherLoop = true;
-				FixRequirement(Requirement, MaterialInstanceConstant);
-			}
-			else
+		TArray<FRequirement> Parents;
+		for (const FRequirement &Instance : Instances)
+		{
+			FString Content;
+			if (!FFileHelper::LoadFileToString(Content, *(ExportFolder / Instance.Package / Instance.Name + TEXT(".T3D"))))
+				continue;
+
+			T3DCore::ForEachLine(ToRange(Content), [&](const FT3DRange &Line)
 			{
-				UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to import : %s"), *Requirement.Url);
-			}
+				FT3DRange Value, Type, Package, Name;
+				bool bHasPackage;
+				if (!T3DCore::FindValueAfter(T3DCore::Trim(Line), ToRange(ParentKey), 0, Value)
+					|| !T3DCore::ParseRessourceUrl(Value, Type, bHasPackage, Package, Name)
+					|| ToString(Type) != TEXT("MaterialInstanceConstant"))
+					return;
+
+				// Same requirement as the one T3DMaterialInstanceConstantParser adds, whose package is the instance one
+				FRequirement Parent;
+				Parent.OriginalUrl = ToString(Value);
+				Parent.Type = ToString(Type);
+				Parent.Package = bHasPackage ? ToString(Package) : Instance.Package;
+				Parent.Name = ToString(Name);
+				Parent.Url = FString::Printf(TEXT("%s'%s.%s'"), *Parent.Type, *Parent.Package, *Parent.Name);
+				if (!VisitedUrls.Contains(Parent.Url))
+				{
+					VisitedUrls.Add(Parent.Url);
+					Parents.Add(Parent);
+				}
+			});
 		}
+		Instances = MoveTemp(Parents);
 	}
+}
+
+void T3DLevelParser::CollectPendingRequirements(const FString &Type)
+{
+	// Fixing a requirement removes it from Requirements, iterate over a copy
+	PendingRequirements.Reset();
+	NextPendingRequirement = 0;
+	bFixedPendingRequirement = false;
 
-	if (bRequiresAnotherLoop)
+	Requirements.ForEachPending([&](const FRequirement &Requirement)
 	{
-		ExportMaterialInstanceConstantAssets();
-	}
+		if (Requirement.Type == Type)
+		{
+			PendingRequirements.Add(Requirement);
+		}
+	});
 }
 
-void T3DLevelParser::ExportMaterialAssets()
+bool T3DLevelParser::ExportMaterialInstanceConstantAssets(double EndTime)
 {
-	for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
+	UDK_IMPORT_PROFILE_SCOPE(ImportMaterialInstances);
+	for (;;)
 	{
-		const FRequirement &Requirement = Iter.Key();
-
-		if (Requirement.Type == TEXT("Material"))
+		if (NextPendingRequirement >= PendingRequirements.Num())
 		{
-			FString ExportFolder;
-			FString FileName = Requirement.Name + TEXT(".T3D");
-			ExportPackage(Requirement.Package, EExportType::Material, ExportFolder);
-				
-			FString ObjectPath = FString::Printf(TEXT("/Game/UDK/%s/Materials/%s.%s"), *Requirement.Package, *Requirement.Name, *Requirement.Name);
-			UMaterial * Material = LoadObject<UMaterial>(NULL, *ObjectPath, NULL, LOAD_NoWarn | LOAD_Quiet);
-			if (!Material)
+			// Imported instances may require other instances as their parent, loop as long as some get imported
+			if (!bFixedPendingRequirement)
 			{
-				T3DMaterialParser MaterialParser(this, Requirement.Package);
-				Material = MaterialParser.ImportMaterialT3DFile(ExportFolder / FileName);
+				PendingRequirements.Empty();
+				return true;
 			}
+			CollectPendingRequirements(TEXT("MaterialInstanceConstant"));
+			continue;
+		}
+
+		const FRequirement &Requirement = PendingRequirements[NextPendingRequirement++];
+
+		// Exported with their parents by ExportMaterialInstanceConstantPackages
+		const FString ExportFolder = ExportFolderFor(EExportType::MaterialInstanceConstant) / Requirement.Package;
+		FString FileName = Requirement.Name + TEXT(".T3D");
+
+		FString ObjectPath = FString::Printf(TEXT("/Game/UDK/%s/MaterialInstances/%s.%s"), *Requirement.Package, *Requirement.Name, *Requirement.Name);
+		UMaterialInstanceConstant * MaterialInstanceConstant = ImportedAssets.Load<UMaterialInstanceConstant>(ObjectPath);
+		if (!MaterialInstanceConstant)
+		{
+			T3DMaterialInstanceConstantParser MaterialInstanceConstantParser(this, Requirement.Package);
+			MaterialInstanceConstant = MaterialInstanceConstantParser.ImportT3DFile(ExportFolder / FileName);
+			ImportedAssets.Add(MaterialInstanceConstant);
+		}
+
+		if (MaterialInstanceConstant)
+		{
+			bFixedPendingRequirement = true;
+			FixRequirement(Requirement, MaterialInstanceConstant);
+		}
+		else
+		{
+			UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to import : %s"), *Requirement.Url);
+		}
+
+		if (FPlatformTime::Seconds() >= EndTime)
+			return false;
+	}
+}
+
+bool T3DLevelParser::ExportMaterialAssets(double EndTime)
+{
+	UDK_IMPORT_PROFILE_SCOPE(BuildMaterials);
+	while (NextPendingRequirement < PendingRequirements.Num())
+	{
+		const FRequirement &Requirement = PendingRequirements[NextPendingRequirement++];
+
+		FString ExportFolder;
+		FString FileName = Requirement.Name + TEXT(".T3D");
+		ExportPackage(Requirement.Package, EExportType::Material, ExportFolder);
 
-			if (Material)
+		FString ObjectPath = FString::Printf(TEXT("/Game/UDK/%s/Materials/%s.%s"), *Requirement.Package, *Requirement.Name, *Requirement.Name);
+		UMaterial * Material = ImportedAssets.Load<UMaterial>(ObjectPath);
+		if (!Material)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			T3DMaterialParser MaterialParser(this, Requirement.Package);
+			FT3DParsedMaterial &ParsedMaterial = ParsedMaterials[NextPendingRequirement - 1];
+			if (!ParsedMaterial.Name.IsEmpty())
 			{
-				FixRequirement(Requirement, Material);
+				Material = MaterialParser.BuildMaterial(ParsedMaterial);
+				ParsedMaterial = FT3DParsedMaterial();
 			}
 			else
 			{
-				UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to import : %s"), *Requirement.Url);
+				// Skipped by ParseMaterials because it is indexed, but it could not be loaded
+				Material = MaterialParser.ImportMaterialT3DFile(ExportFolder / FileName);
 			}
+			ImportedAssets.Add(Material);
+			FUDKImportProfiler::Get().AddAssetTime(Requirement.Url, FPlatformTime::Seconds() - StartTime);
+			FUDKImportProfiler::Get().AddCount(TEXT("Materials"));
+		}
+
+		if (Material)
+		{
+			FixRequirement(Requirement, Material);
+		}
+		else
+		{
+			UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to import : %s"), *Requirement.Url);
+		}
+
+		if (FPlatformTime::Seconds() >= EndTime && NextPendingRequirement < PendingRequirements.Num())
+		{
+			EnforceMemoryBudget();
+			return false;
 		}
 	}
+
+	PendingRequirements.Empty();
+	ParsedMaterials.Empty();
+	return true;
 }
 
-void T3DLevelParser::ExportTextureAssets()
+void T3DLevelParser::ParseMaterials()
 {
-	IFileManager & FileManager = IFileManager::Get();
-
-	for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
+	UDK_IMPORT_PROFILE_SCOPE(ParseMaterials);
+	ParsedMaterials.Reset();
+	ParsedMaterials.SetNum(PendingRequirements.Num());
+
+	// Packages were exported one after the other by ExportRequiredPackages, UDK is never run from the
+	// task graph workers: they only parse the exported files
+	const FString MaterialsFolder = ExportFolderFor(EExportType::Material);
+	ParallelFor(PendingRequirements.Num(), [this, &MaterialsFolder](int32 Index)
 	{
-		const FRequirement &Requirement = Iter.Key();
+		const FRequirement &Requirement = PendingRequirements[Index];
+		const FString ObjectPath = FString::Printf(TEXT("/Game/UDK/%s/Materials/%s.%s"), *Requirement.Package, *Requirement.Name, *Requirement.Name);
+		if (IsCancelled() || ImportedAssets.Contains(ObjectPath))
+			return;
+
+		T3DMaterialParser MaterialParser(this, Requirement.Package);
+		if (!MaterialParser.ParseMaterialT3DFile(MaterialsFolder / Requirement.Package / (Requirement.Name + TEXT(".T3D")), ParsedMaterials[Index]))
+		{
+			// Let ExportMaterialAssets report it
+			ParsedMaterials[Index] = FT3DParsedMaterial();
+		}
+	});
 
-		if (Requirement.Type.StartsWith(TEXT("Texture")))
+	// FlipBook samples read the T3D export of their texture, the missing ones are exported here rather than
+	// from the parallel parse, then read again
+	for (int32 Index = 0; Index < ParsedMaterials.Num() && !IsCancelled(); ++Index)
+	{
+		for (FT3DParsedMaterial::FExpressionDesc &Desc : ParsedMaterials[Index].Expressions)
 		{
-			FString ExportFolder;
-			FString ImportFolder = TmpPath / TEXT("UDK") / Requirement.Package / TEXT("Textures");
-			FString FileName = Requirement.Name + TEXT(".TGA");
-			ExportPackage(Requirement.Package, EExportType::Texture2D, ExportFolder);
+			if (Desc.ClassName != TEXT("MaterialExpressionFlipBookSample"))
+				continue;
 
-			FileManager.MakeDirectory(*ImportFolder, true);
-			if (FileManager.FileSize(*(ExportFolder / FileName)) > 0)
+			T3DMaterialParser MaterialParser(this, PendingRequirements[Index].Package);
+			FString TexturePackage, ExportFolder;
+			if (!MaterialParser.ReadFlipBookTextureInfo(Desc, TexturePackage) && ExportPackage(TexturePackage, EExportType::Texture2DInfo, ExportFolder))
 			{
-				FileManager.Copy(*(ImportFolder / FileName), *(ExportFolder / FileName));
+				MaterialParser.ReadFlipBookTextureInfo(Desc, TexturePackage);
 			}
 		}
 	}
 }
 
-void T3DLevelParser::ExportStaticMeshAssets()
+void T3DLevelParser::GroupRequirementsByPackage(const TArray<FRequirement> &AssetRequirements, const FString &TypePrefix, TMap<FString, TArray<const FRequirement*> > &OutPackages)
 {
-	FString ExportFolder, ImportFolder, FileNameOBJ, FileNameFBX;
-	IFileManager & FileManager = IFileManager::Get();
+	for (const FRequirement &Requirement : AssetRequirements)
+	{
+		if (Requirement.Type.StartsWith(TypePrefix))
+		{
+			OutPackages.FindOrAdd(Requirement.Package).Add(&Requirement);
+		}
+	}
+}
 
-	FileManager.MakeDirectory(*(TmpPath / TEXT("ExportedMeshes")), true);
+void T3DLevelParser::ExportTextureAssets(const TArray<FRequirement> &AssetRequirements)
+{
+	UDK_IMPORT_PROFILE_SCOPE(ExportTextures);
+	IFileManager & FileManager = IFileManager::Get();
 
-	for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
+	TMap<FString, TArray<const FRequirement*> > Packages;
+	GroupRequirementsByPackage(AssetRequirements, TEXT("Texture"), Packages);
+	for (auto PackageIter = Packages.CreateConstIterator(); PackageIter && !IsCancelled(); ++PackageIter)
 	{
-		const FRequirement &Requirement = Iter.Key();
-
-		if (Requirement.Type == TEXT("StaticMesh"))
+		const FString &RequiredPackage = PackageIter.Key();
+		FString ExportFolder;
+		FString ImportFolder = TmpPath / TEXT("UDK") / RequiredPackage / TEXT("Textures");
+		ExportPackage(RequiredPackage, EExportType::Texture2D, ExportFolder);
+		FileManager.MakeDirectory(*ImportFolder, true);
+
+		TArray<FString> Files;
+		for (const FRequirement * Requirement : PackageIter.Value())
 		{
-			FString ExportFolder;
-			FString ImportFolder = TmpPath / TEXT("UDK") / Requirement.Package / TEXT("Meshes");
-			FString FileNameOBJ = Requirement.Name + TEXT(".OBJ");
-			FString FileNameFBX = Requirement.Name + TEXT(".FBX");
-			ExportPackage(Requirement.Package, EExportType::StaticMesh, ExportFolder);
-
-			FileManager.MakeDirectory(*ImportFolder, true);
-			if (FileManager.FileSize(*(ExportFolder / FileNameFBX)) > 0)
-			{
-				FileManager.Copy(*(ImportFolder / FileNameFBX), *(ExportFolder / FileNameFBX));
-			}
-			else if (FileManager.FileSize(*(ExportFolder / FileNameOBJ)) > 0)
+			FString FileName = Requirement->Name + TEXT(".TGA");
+			const int64 FileSize = FileManager.FileSize(*(ExportFolder / FileName));
+			if (FileSize > 0 && FileManager.Copy(*(ImportFolder / FileName), *(ExportFolder / FileName)) == COPY_OK)
 			{
-				ConvertOBJToFBX(ExportFolder / FileNameOBJ, ImportFolder / FileNameFBX);
+				Files.Add(ImportFolder / FileName);
+				FUDKImportProfiler::Get().AddBytes(TEXT("Textures"), FileSize);
 			}
 		}
+
+		QueueAssetImport(FString::Printf(TEXT("/Game/UDK/%s/Textures"), *RequiredPackage), Files);
 	}
 }
 
-void T3DLevelParser::ImportLevel()
+void T3DLevelParser::ExportStaticMeshAssets(const TArray<FRequirement> &AssetRequirements)
 {
-	FString Class;
+	UDK_IMPORT_PROFILE_SCOPE(ExportStaticMeshes);
+	IFileManager & FileManager = IFileManager::Get();
+
+	FileManager.MakeDirectory(*(TmpPath / TEXT("ExportedMeshes")), true);
+
+	TMap<FString, TArray<const FRequirement*> > Packages;
+	GroupRequirementsByPackage(AssetRequirements, TEXT("StaticMesh"), Packages);
+	for (auto PackageIter = Packages.CreateConstIterator(); PackageIter && !IsCancelled(); ++PackageIter)
+	{
+		const FString &RequiredPackage = PackageIter.Key();
+		FString ExportFolder;
+		FString ImportFolder = TmpPath / TEXT("UDK") / RequiredPackage / TEXT("Meshes");
+		ExportPackage(RequiredPackage, EExportType::StaticMesh, ExportFolder);
+		FileManager.MakeDirectory(*ImportFolder, true);
+
+		TArray<FString> Files;
+		for (const FRequirement * Requirement : PackageIter.Value())
+		{
+			FString FileNameOBJ = Requirement->Name + TEXT(".OBJ");
+			FString FileNameFBX = Requirement->Name + TEXT(".FBX");
+			if (FileManager.FileSize(*(ExportFolder / FileNameFBX)) > 0)
+			{
+				if (FileManager.Copy(*(ImportFolder / FileNameFBX), *(ExportFolder / FileNameFBX)) == COPY_OK)
+				{
+					Files.Add(ImportFolder / FileNameFBX);
+				}
+			}
+			else if (FileManager.FileSize(*(ExportFolder / FileNameOBJ)) > 0)
+			{
+				if (ConvertOBJToFBX(ExportFolder / FileNameOBJ, ImportFolder / FileNameFBX))
+				{
+					Files.Add(ImportFolder / FileNameFBX);
+				}
+			}
+		}
+
+		for (const FString &File : Files)
+		{
+			FUDKImportProfiler::Get().AddBytes(TEXT("StaticMeshes"), FileManager.FileSize(*File));
+		}
+		QueueAssetImport(FString::Printf(TEXT("/Game/UDK/%s/Meshes"), *RequiredPackage), Files);
+	}
+}
+
+void T3DLevelParser::ScanLevel(const FUDKImportFilter &ImportFilter)
+{
+	UDK_IMPORT_PROFILE_SCOPE(ScanLevel);
+	FString Class;
+	int32 BrushCount = 0;
 
 	ensure(NextLine());
 	ensure(Line.Equals(TEXT("Begin Object Class=Level Name=PersistentLevel")));
 
+	// Layers, locations and hashes are only needed to filter blocks and to find the ones that changed since
+	// the previous import, without them the blocks are only delimited
+	const bool bScanBlocks = ImportFilter.IsActive() || Settings->bIncrementalReimport;
+
+	// Blocks are only delimited here, their descriptors are parsed by the parse tasks
 	while (NextLine() && !IsEndObject())
 	{
 		if (IsBeginObject(Class))
 		{
-			UObject * Object = 0;
-			if (Class.Equals(TEXT("StaticMeshActor")))
-				ImportStaticMeshActor();
-			else if (Class.Equals(TEXT("Brush")))
-				ImportBrush();
-			else if (Class.Equals(TEXT("PointLight")))
-				ImportPointLight();
-			else if (Class.Equals(TEXT("SpotLight")))
-				ImportSpotLight();
+			FObjectBlock Block;
+			if (bScanBlocks)
+				ScanObjectBlock(Block);
 			else
-				JumpToEnd();
+				DelimitObjectBlock(Block);
+			LineIndex = Block.EndLine;
+
+			FT3DParsedLevel::FActorBlock &ActorBlock = ParsedLevel.Blocks[ParsedLevel.Blocks.AddDefaulted()];
+			ActorBlock.Class = Block.Class;
+			ActorBlock.Name = Block.Name;
+			ActorBlock.Hash = Block.Hash;
+			ActorBlock.BrushOrder = Class.Equals(TEXT("Brush")) ? ++BrushCount : 0;
+			ActorBlock.DescIndex = INDEX_NONE;
+			ActorBlock.Type = FT3DParsedLevel::FActorBlock::Unsupported;
+
+			// Rejected blocks are skipped without being tokenized
+			if (!ImportFilter.Accept(Block))
+			{
+				ActorBlock.Type = FT3DParsedLevel::FActorBlock::Rejected;
+			}
+			else if (Class.Equals(TEXT("StaticMeshActor")))
+			{
+				ActorBlock.Type = FT3DParsedLevel::FActorBlock::StaticMeshActor;
+				ActorBlock.DescIndex = ParsedLevel.StaticMeshActors.AddDefaulted();
+			}
+			else if (Class.Equals(TEXT("Brush")))
+			{
+				ActorBlock.Type = FT3DParsedLevel::FActorBlock::Brush;
+				ActorBlock.DescIndex = ParsedLevel.Brushes.AddDefaulted();
+			}
+			else if (Class.Equals(TEXT("PointLight")) || Class.Equals(TEXT("SpotLight")))
+			{
+				ActorBlock.Type = FT3DParsedLevel::FActorBlock::Light;
+				ActorBlock.DescIndex = ParsedLevel.Lights.AddDefaulted();
+			}
+
+			BlockBeginLines.Add(ActorBlock.DescIndex != INDEX_NONE ? Block.BeginLine : INDEX_NONE);
+			BlockEndLines.Add(Block.EndLine);
 		}
 	}
+}
 
-	// After parsing all actors, apply metadata for imported brushes to preserve CSG order
+void T3DLevelParser::ParseBlock(const FT3DParsedLevel::FActorBlock &Block, int32 BeginLine, FT3DParsedLevel &Level)
+{
+	LineIndex = BeginLine;
+	ParserLevel = 0;
+	ensure(NextLine());
+
+	switch (Block.Type)
+	{
+	case FT3DParsedLevel::FActorBlock::StaticMeshActor:
+		ParseStaticMeshActor(Level.StaticMeshActors[Block.DescIndex]);
+		break;
+	case FT3DParsedLevel::FActorBlock::Brush:
+		ParseBrush(Level.Brushes[Block.DescIndex]);
+		break;
+	case FT3DParsedLevel::FActorBlock::Light:
+		if (Block.Class.Equals(TEXT("SpotLight")))
+			ParseSpotLight(Level.Lights[Block.DescIndex]);
+		else
+			ParsePointLight(Level.Lights[Block.DescIndex]);
+		break;
+	default:
+		break;
+	}
+}
+
+void T3DLevelParser::StartParseTasks()
+{
+	ParsedBlockQueue.Reset(new T3DCore::TBoundedMPSCQueue<int32>(ParsedBlockQueueCapacity));
+	NextBlockToParse.Reset();
+	bAbortParse = false;
+
+	BrushGeometries.Reset();
+	BrushGeometries.SetNum(ParsedLevel.Brushes.Num());
+
+	// Cached levels have nothing left to parse but the geometry of their brushes, without brushes a single task hands their blocks over
+	const int32 TaskCount = BlockBeginLines.Num() > 0 || ParsedLevel.Brushes.Num() > 0 ? FMath::Max(Settings->MaxParallelImports, 1) : 1;
+	for (int32 TaskIndex = 0; TaskIndex < TaskCount; ++TaskIndex)
+	{
+		ParseTasks.Add(Async(EAsyncExecution::ThreadPool, [this]()
+		{
+			ParseBlocks();
+		}));
+	}
+}
+
+void T3DLevelParser::ParseBlocks()
+{
+	UDK_IMPORT_PROFILE_SCOPE(ParseBlocks);
+	// Each task parses with its own line position over the shared lines, settings are not read off the game thread
+	T3DLevelParser BlockParser(UdkPath, TmpPath, Settings);
+	BlockParser.Lines = Lines;
+
+	const int32 BlockCount = ParsedLevel.Blocks.Num();
+	for (int32 BlockIndex = NextBlockToParse.Increment() - 1; BlockIndex < BlockCount; BlockIndex = NextBlockToParse.Increment() - 1)
+	{
+		if (bAbortParse || IsCancelled())
+			return;
+
+		if (BlockBeginLines.IsValidIndex(BlockIndex) && BlockBeginLines[BlockIndex] != INDEX_NONE)
+		{
+			BlockParser.ParseBlock(ParsedLevel.Blocks[BlockIndex], BlockBeginLines[BlockIndex], ParsedLevel);
+
+			// No other task reads the lines of the block, they are released as soon as it is parsed
+			for (int32 BlockLine = BlockBeginLines[BlockIndex]; BlockLine < BlockEndLines[BlockIndex]; ++BlockLine)
+			{
+				(*Lines)[BlockLine].Empty();
+			}
+		}
+
+		const FT3DParsedLevel::FActorBlock &Block = ParsedLevel.Blocks[BlockIndex];
+		if (Block.Type == FT3DParsedLevel::FActorBlock::Brush)
+		{
+			BuildBrushGeometry(ParsedLevel.Brushes[Block.DescIndex], BrushGeometries[Block.DescIndex]);
+		}
+
+		// Waits while the applier is behind, so that parsed descriptors don't pile up
+		int32 ParsedBlockIndex = BlockIndex;
+		if (!ParsedBlockQueue->Enqueue(MoveTemp(ParsedBlockIndex), [this]() { return bAbortParse || IsCancelled(); }))
+			return;
+	}
+}
+
+void T3DLevelParser::WaitForParseTasks()
+{
+	for (TFuture<void> &ParseTask : ParseTasks)
+	{
+		ParseTask.Wait();
+	}
+	ParseTasks.Empty();
+}
+
+void T3DLevelParser::SaveParsedLevel()
+{
+	WaitForParseTasks();
+	UDK_IMPORT_PROFILE_SCOPE(SaveParsedLevel);
+	BlockBeginLines.Empty();
+	BlockEndLines.Empty();
+	BrushGeometries.Empty();
+	ParsedBlockQueue.Reset();
+	Lines.Reset();
+
+	const FString CacheFileName = TmpPath / TEXT("PersistentLevel.t3db");
+	if (Settings->bCacheParsedLevels && !bParsedFromCache && !ParsedLevel.SaveCache(CacheFileName))
+	{
+		UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to write parsed level cache %s"), *CacheFileName);
+	}
+}
+
+void T3DLevelParser::BeginImportParsedLevel()
+{
+	ImportedBlockCount = 0;
+	NextBrushOrder = 1;
+	bRespawnBrushes = false;
+	DeferredBrushBlocks.Empty();
+	PolygonMaterialGroupIndices.Empty();
+	PolygonMaterialGroups.Empty();
+	SkippedActorCount = 0;
+	UnchangedActorCount = 0;
+
+	SubLevelSharder.Reset();
+	if (Settings->SubLevelCellSize > 0.0f)
+	{
+		FindWorld();
+		SubLevelSharder.Reset(new FUDKSubLevelSharder(World, FString::Printf(TEXT("/Game/UDK/%s/SubLevels"), *Package), Package, Settings->SubLevelCellSize));
+	}
+
+	// Blocks already imported by the previous run are only re-imported if they changed
+	PreviousManifest = FUDKImportManifest();
+	if (Settings->bIncrementalReimport)
+	{
+		PreviousManifest.Load(TmpPath / TEXT("ImportManifest.json"), Package);
+	}
+}
+
+bool T3DLevelParser::ImportParsedBlocks(double EndTime)
+{
+	UDK_IMPORT_PROFILE_SCOPE(SpawnActors);
+	const int32 ActorCount = ParsedLevel.Blocks.Num();
+	const bool bIncremental = Settings->bIncrementalReimport;
+
+	int32 BlockIndex;
+	while (ImportedBlockCount < ActorCount && FPlatformTime::Seconds() < EndTime && ParsedBlockQueue->TryDequeue(BlockIndex))
+	{
+		const FT3DParsedLevel::FActorBlock &Block = ParsedLevel.Blocks[BlockIndex];
+		if (Block.BrushOrder == 0)
+		{
+			ImportParsedBlock(Block, bIncremental);
+			++ImportedBlockCount;
+			continue;
+		}
+
+		// Brushes are spawned in level order since it is their CSG order, the ones parsed early wait for the previous ones
+		DeferredBrushBlocks.Add(Block.BrushOrder, BlockIndex);
+		const int32 * pDeferredBlockIndex;
+		while ((pDeferredBlockIndex = DeferredBrushBlocks.Find(NextBrushOrder)) != NULL)
+		{
+			const int32 DeferredBlockIndex = *pDeferredBlockIndex;
+			DeferredBrushBlocks.Remove(NextBrushOrder++);
+			ImportParsedBlock(ParsedLevel.Blocks[DeferredBlockIndex], bIncremental);
+			++ImportedBlockCount;
+		}
+	}
+
+	NotifySpawnedBrushes();
+
+	if (ImportedBlockCount < ActorCount)
+	{
+		EnforceMemoryBudget();
+		UpdateStepProgress(FText::Format(LOCTEXT("ImportingUDKLevelActors", "Importing UDK Level actors ({0}/{1})"), FText::AsNumber(ImportedBlockCount), FText::AsNumber(ActorCount)), (float)ImportedBlockCount / ActorCount);
+		return false;
+	}
+
+	return true;
+}
+
+void T3DLevelParser::ImportParsedBlock(const FT3DParsedLevel::FActorBlock &Block, bool bIncremental)
+{
+	const FUDKImportManifest::FEntry * PreviousEntry = bIncremental ? PreviousManifest.Find(Block.Name) : NULL;
+
+	if (Block.Type == FT3DParsedLevel::FActorBlock::Rejected)
+	{
+		// Actors imported by a previous run stay untouched
+		if (PreviousEntry)
+		{
+			ImportManifest.Add(Block.Name, *PreviousEntry);
+		}
+		++SkippedActorCount;
+		return;
+	}
+
+	// Consolidated StaticMeshActors can't be traced back to their block, they are always re-imported
+	const bool bTraceable = !(Settings->bConsolidateStaticMeshActors && Block.Type == FT3DParsedLevel::FActorBlock::StaticMeshActor);
+	// Brushes are built in actor order, an unchanged brush following a spawned one would be built before it
+	const bool bRespawn = Block.BrushOrder != 0 && bRespawnBrushes;
+	if (PreviousEntry && bTraceable)
+	{
+		if (PreviousEntry->Hash == Block.Hash && PreviousEntry->IsValid() && !bRespawn)
+		{
+			ImportManifest.Add(Block.Name, *PreviousEntry);
+			++UnchangedActorCount;
+			return;
+		}
+
+		FUDKImportManifest::DestroyActors(*PreviousEntry);
+	}
+
+	BlockActors.Reset();
+	switch (Block.Type)
+	{
+	case FT3DParsedLevel::FActorBlock::StaticMeshActor:
+		ImportStaticMeshActor(ParsedLevel.StaticMeshActors[Block.DescIndex]);
+		break;
+	case FT3DParsedLevel::FActorBlock::Brush:
+		SpawnBrush(ParsedLevel.Brushes[Block.DescIndex], BrushGeometries[Block.DescIndex], Block.BrushOrder);
+		bRespawnBrushes = true;
+		break;
+	case FT3DParsedLevel::FActorBlock::Light:
+		SpawnLight(ParsedLevel.Lights[Block.DescIndex]);
+		break;
+	default:
+		break;
+	}
+
+	if (bIncremental)
+	{
+		ImportManifest.Add(Block.Name, Block.Hash, BlockActors);
+	}
+}
+
+void T3DLevelParser::EndImportParsedLevel()
+{
+	const int32 ActorCount = ParsedLevel.Blocks.Num();
+	const bool bIncremental = Settings->bIncrementalReimport;
+
+	if (SkippedActorCount > 0)
+	{
+		UE_LOG(UDKImportPluginLog, Log, TEXT("Import filter skipped %d of %d actors"), SkippedActorCount, ActorCount);
+	}
+	FUDKImportProfiler::Get().AddCount(TEXT("ActorBlocks"), ActorCount);
+	FUDKImportProfiler::Get().AddCount(TEXT("SkippedActorBlocks"), SkippedActorCount);
+
+	if (bIncremental)
+	{
+		// Remove what the previous run imported from blocks that are gone, or that are rebuilt every run
+		const int32 RemovedActorCount = PreviousManifest.DestroyActorsMissingFrom(ImportManifest);
+		UE_LOG(UDKImportPluginLog, Log, TEXT("Incremental re-import: %d unchanged, %d removed, %d imported actor blocks"), UnchangedActorCount, RemovedActorCount, ActorCount - UnchangedActorCount - SkippedActorCount);
+		PreviousManifest = FUDKImportManifest();
+	}
+
+	BlockActors.Reset();
+	SpawnStaticMeshInstanceGroups();
+	if (bIncremental)
+	{
+		ImportManifest.Add(TEXT("StaticMeshInstanceGroups"), 0, BlockActors);
+	}
+
+	// After spawning all actors, apply metadata for imported brushes to preserve CSG order
 	ApplyImportedBrushOrder();
 }
 
-void T3DLevelParser::ImportBrush()
+void T3DLevelParser::ParseBrush(FT3DParsedLevel::FBrushDesc &Desc)
 {
-	FString Value, Class, Name;
-	ABrush * Brush = SpawnActor<ABrush>();
-	Brush->BrushType = Brush_Add;
-	UModel* Model = new(Brush, NAME_None, RF_Transactional)UModel(FPostConstructInitializeProperties(), Brush, 1);
+	FString Value;
+	Desc.bSubtract = false;
+	Desc.Location = FVector::ZeroVector;
+	Desc.Layer = NAME_None;
 
 	while (NextLine() && !IsEndObject())
 	{
@@ -484,7 +1371,7 @@ void T3DLevelParser::ImportBrush()
 			{
 				if (Line.StartsWith(TEXT("Begin PolyList")))
 				{
-					ImportPolyList(Model->Polys);
+					ParsePolyList(Desc.Polys);
 				}
 			}
 		}
@@ -492,10 +1379,10 @@ void T3DLevelParser::ImportBrush()
 		{
 			if (Value.Equals(TEXT("CSG_Subtract")))
 			{
-				Brush->BrushType = Brush_Subtract;
+				Desc.bSubtract = true;
 			}
 		}
-		else if (IsActorLocation(Brush) || IsActorProperty(Brush))
+		else if (IsActorLocation(Desc.Location) || IsActorProperty(Desc.Layer))
 		{
 			continue;
 		}
@@ -504,224 +1391,257 @@ void T3DLevelParser::ImportBrush()
 			JumpToEnd();
 		}
 	}
-	
+}
+
+void T3DLevelParser::BuildBrushGeometry(const FT3DParsedLevel::FBrushDesc &Desc, FBrushGeometry &Geometry)
+{
+	// Same result as filling UModel::Polys then calling UModel::BuildBound, without touching any UObject
+	TArray<FVector> Points;
+	Geometry.Polys.SetNum(Desc.Polys.Num());
+	for (int32 PolyIndex = 0; PolyIndex < Desc.Polys.Num(); ++PolyIndex)
+	{
+		const FT3DParsedLevel::FPolyDesc &PolyDesc = Desc.Polys[PolyIndex];
+		FPoly &Poly = Geometry.Polys[PolyIndex];
+		Poly.Base = PolyDesc.Base;
+		Poly.Normal = PolyDesc.Normal;
+		Poly.TextureU = PolyDesc.TextureU;
+		Poly.TextureV = PolyDesc.TextureV;
+		Poly.Vertices = PolyDesc.Vertices;
+		Poly.iLink = PolyDesc.iLink;
+		Poly.PolyFlags = PolyDesc.PolyFlags;
+		Points.Append(PolyDesc.Vertices);
+	}
+
+	if (Points.Num() > 0)
+	{
+		Geometry.Bounds = FBoxSphereBounds(Points.GetData(), Points.Num());
+	}
+}
+
+void T3DLevelParser::SpawnBrush(const FT3DParsedLevel::FBrushDesc &Desc, FBrushGeometry &Geometry, int32 BrushOrder)
+{
+	ABrush * Brush = SpawnActor<ABrush>();
+	Brush->BrushType = Desc.bSubtract ? Brush_Subtract : Brush_Add;
+	Brush->SetActorLocation(Desc.Location);
+	if (Desc.Layer != NAME_None)
+	{
+		AddActorToLayer(Brush, Desc.Layer);
+	}
+
+	UModel* Model = new(Brush, NAME_None, RF_Transactional)UModel(FPostConstructInitializeProperties(), Brush, 1);
+	// Polygons were built by the parse tasks. Element is a TTransArray, moved into through its TArray base since
+	// TTransArray has no move assignment from a TArray
+	UPolys * Polys = Model->Polys;
+	const bool bHasPolys = Geometry.Polys.Num() > 0;
+	static_cast<TArray<FPoly>&>(Polys->Element) = MoveTemp(Geometry.Polys);
+	for (int32 PolyIndex = 0; PolyIndex < Desc.Polys.Num(); ++PolyIndex)
+	{
+		if (!Desc.Polys[PolyIndex].MaterialUrl.IsEmpty())
+		{
+			AddPolygonMaterial(Desc.Polys[PolyIndex].MaterialUrl, Polys, PolyIndex);
+		}
+	}
+
 	Model->Modify();
-	Model->BuildBound();
+	if (bHasPolys)
+	{
+		Model->Bounds = Geometry.Bounds;
+	}
 
 	Brush->BrushComponent->Brush = Brush->Brush;
-	Brush->PostEditImport();
-	Brush->PostEditChange();
+	SpawnedBrushesToNotify.Add(Brush);
 
-	// Track brush import order so we can preserve CSG order
+	// Track brush import order so we can preserve CSG order, the tag is set before the editor is notified of the brush
+	Brush->Tags.Add(*FString::Printf(TEXT("ImportedBrushOrder=%d"), BrushOrder));
 	ImportedBrushes.Add(Brush);
-	BrushOrderCounter++;
+	ImportedBrushOrders.Add(BrushOrder);
+}
+
+void T3DLevelParser::AddPolygonMaterial(const FString &MaterialUrl, UPolys * Polys, int32 Index)
+{
+	int32 * pGroupIndex = PolygonMaterialGroupIndices.Find(MaterialUrl);
+	if (pGroupIndex == NULL)
+	{
+		FRequirement Requirement;
+		if (!ParseRessourceUrl(FString::Printf(TEXT("Material'%s'"), *MaterialUrl), Requirement))
+		{
+			UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to parse ressource url : Material'%s'"), *MaterialUrl);
+			PolygonMaterialGroupIndices.Add(MaterialUrl, INDEX_NONE);
+			return;
+		}
+
+		const int32 GroupIndex = PolygonMaterialGroups.AddDefaulted();
+		PolygonMaterialGroups[GroupIndex].Material = NULL;
+		PolygonMaterialGroups[GroupIndex].bResolved = false;
+		PolygonMaterialGroupIndices.Add(MaterialUrl, GroupIndex);
+		PolygonMaterialGroups[GroupIndex].Targets.Add({ Polys, Index });
+		AddRequirement(Requirement, UObjectDelegate::CreateRaw(this, &T3DLevelParser::SetPolygonMaterialGroup, GroupIndex));
+		return;
+	}
+
+	if (*pGroupIndex == INDEX_NONE)
+		return;
+
+	FPolygonMaterialGroup &Group = PolygonMaterialGroups[*pGroupIndex];
+	if (Group.bResolved)
+	{
+		Polys->Element[Index].Material = Group.Material;
+	}
+	else
+	{
+		Group.Targets.Add({ Polys, Index });
+	}
+}
+
+void T3DLevelParser::NotifySpawnedBrushes()
+{
+	for (ABrush * Brush : SpawnedBrushesToNotify)
+	{
+		Brush->PostEditImport();
+		Brush->PostEditChange();
+	}
+	SpawnedBrushesToNotify.Reset();
 }
 
 void T3DLevelParser::ApplyImportedBrushOrder()
 {
-	if (ImportedBrushes.Num() == 0)
+	// Order tags are set by SpawnBrush, every label change goes through the editor notifications of the actor
+	if (ImportedBrushes.Num() == 0 || !Settings->bLabelBrushesWithImportOrder)
 		return;
 
-	// Apply a sortable prefix to Actor labels and add a tag containing the numeric order.
+	UDK_IMPORT_PROFILE_SCOPE(LabelBrushes);
+	FString Label;
 	for (int32 Index = 0; Index < ImportedBrushes.Num(); ++Index)
 	{
-		TWeakObjectPtr<ABrush> WeakBrush = ImportedBrushes[Index];
-		if (!WeakBrush.IsValid())
+		ABrush * Brush = ImportedBrushes[Index].Get();
+		if (Brush == NULL)
 			continue;
 
-		ABrush* Brush = WeakBrush.Get();
 		// Prefix actor label with a zero-padded index so UE's World Outliner preserves order
-		FString OrigLabel = Brush->GetActorLabel();
-		FString Prefix = FString::Printf(TEXT("[%03d] "), Index + 1);
-		Brush->SetActorLabel(Prefix + OrigLabel, false);
-
-		// Add an Actor Tag storing import order (useful programmatically)
-		FString OrderTag = FString::Printf(TEXT("ImportedBrushOrder=%d"), Index + 1);
-		Brush->Tags.AddUnique(*OrderTag);
+		Label = FString::Printf(TEXT("[%03d] "), ImportedBrushOrders[Index]);
+		Label += Brush->GetActorLabel();
+		Brush->SetActorLabel(Label, false);
 	}
 }
 
-void T3DLevelParser::WriteBrushManifest(const FString& OutFileName)
+void T3DLevelParser::BakeBrushes()
 {
-	if (ImportedBrushes.Num() == 0)
+	if (ImportedBrushes.Num() == 0 || World == NULL)
 		return;
 
-	TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&FString());
-	FString OutString;
-	Writer->WriteObjectStart();
-	Writer->WriteValue(TEXT("GeneratedOn"), FDateTime::UtcNow().ToString());
-	Writer->WriteArrayStart(TEXT("Brushes"));
+	UDK_IMPORT_PROFILE_SCOPE(BakeBrushes);
+	TArray<AActor*> BakedActors;
+	FUDKBrushBaker BrushBaker(World, FString::Printf(TEXT("/Game/UDK/%s/BakedBrushes"), *Package), TmpPath / TEXT("BakedBrushesCache.json"), Settings->BrushBakeCellSize);
+	BrushBaker.Bake(ImportedBrushes, BakedActors);
 
-	for (int32 Index = 0; Index < ImportedBrushes.Num(); ++Index)
+	// Baked actors replace the brushes, they are rebuilt by every run
+	if (Settings->bIncrementalReimport)
 	{
-		TWeakObjectPtr<ABrush> WeakBrush = ImportedBrushes[Index];
-		if (!WeakBrush.IsValid())
-			continue;
+		ImportManifest.Add(TEXT("BakedBrushes"), 0, BakedActors);
+	}
+}
 
-		ABrush* Brush = WeakBrush.Get();
-		Writer->WriteObjectStart();
-		Writer->WriteValue(TEXT("Order"), Index + 1);
-		Writer->WriteValue(TEXT("ActorLabel"), Brush->GetActorLabel());
-
-	Writer->WriteValue(TEXT("BrushType"), Brush->BrushType == Brush_Subtract ? TEXT("Subtract") : TEXT("Add"));
-	FVector Scale = Brush->GetActorScale3D();
-	Writer->WriteObjectStart(TEXT("Scale"));
-	Writer->WriteValue(TEXT("X"), Scale.X);
-	Writer->WriteValue(TEXT("Y"), Scale.Y);
-	Writer->WriteValue(TEXT("Z"), Scale.Z);
-	Writer->WriteObjectEnd();
-
-		// Transform
-		FVector Loc = Brush->GetActorLocation();
-		FRotator Rot = Brush->GetActorRotation();
-		Writer->WriteObjectStart(TEXT("Transform"));
-		Writer->WriteValue(TEXT("Location"), FString::Printf(TEXT("%f,%f,%f"), Loc.X, Loc.Y, Loc.Z));
-		Writer->WriteValue(TEXT("Rotation"), FString::Printf(TEXT("%f,%f,%f"), Rot.Pitch, Rot.Yaw, Rot.Roll));
-		Writer->WriteObjectEnd();
-
-		// Polys
-		UModel* Model = Brush->Brush;
-		Writer->WriteArrayStart(TEXT("Polys"));
-		if (Model && Model->Polys)
-		{
-			for (int32 P = 0; P < Model->Polys->Element.Num(); ++P)
-			{
-				const FPoly& Poly = Model->Polys->Element[P];
-				Writer->WriteObjectStart();
-				Writer->WriteValue(TEXT("Material"), Poly.Material ? Poly.Material->GetPathName() : TEXT(""));
-				Writer->WriteArrayStart(TEXT("Vertices"));
-				for (int32 V = 0; V < Poly.Vertices.Num(); ++V)
-				{
-					const FVector& Vtx = Poly.Vertices[V];
-					Writer->WriteValue(FString::Printf(TEXT("%f,%f,%f"), Vtx.X, Vtx.Y, Vtx.Z));
-				}
-				Writer->WriteArrayEnd();
-				Writer->WriteObjectEnd();
-			}
-		}
-		Writer->WriteArrayEnd(); // Polys
+void T3DLevelParser::WriteBrushManifest(const FString& OutFileName, FUDKBrushManifestWriter::EFormat Format)
+{
+	if (ImportedBrushes.Num() == 0)
+		return;
 
-		Writer->WriteObjectEnd(); // Brush
+	// Brushes are streamed to the file, the manifest of BSP heavy maps is never held in memory
+	FUDKBrushManifestWriter Writer;
+	if (!Writer.Open(OutFileName, Format))
+	{
+		UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to write brush manifest %s"), *OutFileName);
+		return;
 	}
 
-	Writer->WriteArrayEnd(); // Brushes
-	Writer->WriteObjectEnd();
-	Writer->Close();
-
-	// We created writer to string, but TJsonWriterFactory above writes into the string buffer; retrieve it
-	// Recreate writer to write into OutString directly
-	TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer2 = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&OutString);
-	// Simple but dirty: reuse same structure by writing minimally again
-	Writer2->WriteObjectStart();
-	Writer2->WriteValue(TEXT("GeneratedOn"), FDateTime::UtcNow().ToString());
-	Writer2->WriteArrayStart(TEXT("Brushes"));
 	for (int32 Index = 0; Index < ImportedBrushes.Num(); ++Index)
 	{
-		TWeakObjectPtr<ABrush> WeakBrush = ImportedBrushes[Index];
-		if (!WeakBrush.IsValid())
-			continue;
-		ABrush* Brush = WeakBrush.Get();
-		Writer2->WriteObjectStart();
-		Writer2->WriteValue(TEXT("Order"), Index + 1);
-		Writer2->WriteValue(TEXT("ActorLabel"), Brush->GetActorLabel());
-	Writer2->WriteValue(TEXT("BrushType"), Brush->BrushType == Brush_Subtract ? TEXT("Subtract") : TEXT("Add"));
-	FVector Scale = Brush->GetActorScale3D();
-	Writer2->WriteObjectStart(TEXT("Scale"));
-	Writer2->WriteValue(TEXT("X"), Scale.X);
-	Writer2->WriteValue(TEXT("Y"), Scale.Y);
-	Writer2->WriteValue(TEXT("Z"), Scale.Z);
-	Writer2->WriteObjectEnd();
-	FVector Loc = Brush->GetActorLocation();
-		FRotator Rot = Brush->GetActorRotation();
-		Writer2->WriteObjectStart(TEXT("Transform"));
-		Writer2->WriteValue(TEXT("Location"), FString::Printf(TEXT("%f,%f,%f"), Loc.X, Loc.Y, Loc.Z));
-		Writer2->WriteValue(TEXT("Rotation"), FString::Printf(TEXT("%f,%f,%f"), Rot.Pitch, Rot.Yaw, Rot.Roll));
-		Writer2->WriteObjectEnd();
-		UModel* Model = Brush->Brush;
-		Writer2->WriteArrayStart(TEXT("Polys"));
-		if (Model && Model->Polys)
-		{
-			for (int32 P = 0; P < Model->Polys->Element.Num(); ++P)
-			{
-				const FPoly& Poly = Model->Polys->Element[P];
-				Writer2->WriteObjectStart();
-				Writer2->WriteValue(TEXT("Material"), Poly.Material ? Poly.Material->GetPathName() : TEXT(""));
-				Writer2->WriteArrayStart(TEXT("Vertices"));
-				for (int32 V = 0; V < Poly.Vertices.Num(); ++V)
-				{
-					const FVector& Vtx = Poly.Vertices[V];
-					Writer2->WriteValue(FString::Printf(TEXT("%f,%f,%f"), Vtx.X, Vtx.Y, Vtx.Z));
-				}
-				Writer2->WriteArrayEnd();
-				Writer2->WriteObjectEnd();
-			}
+		if (ImportedBrushes[Index].IsValid())
+		{
+			Writer.AddBrush(ImportedBrushOrders[Index], ImportedBrushes[Index].Get());
 		}
-		Writer2->WriteArrayEnd();
-		Writer2->WriteObjectEnd();
 	}
-	Writer2->WriteArrayEnd();
-	Writer2->WriteObjectEnd();
-	Writer2->Close();
 
-	// Save to disk
-	FFileHelper::SaveStringToFile(OutString, *OutFileName);
+	if (!Writer.Close())
+	{
+		UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to write brush manifest %s"), *OutFileName);
+	}
 }
 
-void T3DLevelParser::ImportPolyList(UPolys * Polys)
+void T3DLevelParser::ParsePolyList(TArray<FT3DParsedLevel::FPolyDesc> &Polys)
 {
+	auto StartsWith = [](const FT3DRange &Range, const TCHAR * Prefix)
+	{
+		const int32 PrefixLen = FCString::Strlen(Prefix);
+		return Range.Len() >= PrefixLen && FCString::Strnicmp(Range.Begin, Prefix, PrefixLen) == 0;
+	};
+
+	// The list is read in place from the shared lines, only the "Begin Polygon" lines are copied into Line
+	PolyListBuffer.Reset();
 	FString Texture;
-	while (NextLine() && !Line.StartsWith(TEXT("End PolyList")))
+	bool bInPolygon = false;
+	while (Lines.IsValid() && LineIndex < Lines->Num())
 	{
-		if (Line.StartsWith(TEXT("Begin Polygon ")))
+		const FT3DRange PolyLine = T3DCore::Trim(ToRange((*Lines)[LineIndex++]));
+		if (StartsWith(PolyLine, TEXT("End PolyList")))
 		{
-			bool GotBase = false;
-			FPoly Poly;
-			if (GetOneValueAfter(TEXT(" Texture="), Texture))
+			Line = ToString(PolyLine);
+			break;
+		}
+
+		if (bInPolygon)
+		{
+			double Vector[3];
+			switch (T3DCore::ParsePolyLine(PolyLine.Begin, Vector))
 			{
-				AddRequirement(FString::Printf(TEXT("Material'%s'"), *Texture), UObjectDelegate::CreateRaw(this, &T3DLevelParser::SetPolygonTexture, Polys, Polys->Element.Num()));
+			case T3DCore::EPolyLine::Origin:
+				PolyListBuffer.SetBase(FVector(Vector[0], Vector[1], Vector[2]));
+				break;
+			case T3DCore::EPolyLine::Vertex:
+				PolyListBuffer.AddVertex(FVector(Vector[0], Vector[1], Vector[2]));
+				break;
+			case T3DCore::EPolyLine::TextureU:
+				PolyListBuffer.SetTextureU(FVector(Vector[0], Vector[1], Vector[2]));
+				break;
+			case T3DCore::EPolyLine::TextureV:
+				PolyListBuffer.SetTextureV(FVector(Vector[0], Vector[1], Vector[2]));
+				break;
+			case T3DCore::EPolyLine::Normal:
+				PolyListBuffer.SetNormal(FVector(Vector[0], Vector[1], Vector[2]));
+				break;
+			default:
+				bInPolygon = !StartsWith(PolyLine, TEXT("End Polygon"));
+				break;
 			}
-			FParse::Value(*Line, TEXT("LINK="), Poly.iLink);
-			Poly.PolyFlags &= ~PF_NoImport;
-
-			while (NextLine() && !Line.StartsWith(TEXT("End Polygon")))
+		}
+		else if (StartsWith(PolyLine, TEXT("Begin Polygon ")))
+		{
+			Line = ToString(PolyLine);
+			if (!GetOneValueAfter(TEXT(" Texture="), Texture))
 			{
-				const TCHAR* Str = *Line;
-				if (FParse::Command(&Str, TEXT("ORIGIN")))
-				{
-					GotBase = true;
-					ParseFVector(Str, Poly.Base);
-				}
-				else if (FParse::Command(&Str, TEXT("VERTEX")))
-				{
-					FVector TempVertex;
-					ParseFVector(Str, TempVertex);
-					new(Poly.Vertices) FVector(TempVertex);
-				}
-				else if (FParse::Command(&Str, TEXT("TEXTUREU")))
-				{
-					ParseFVector(Str, Poly.TextureU);
-				}
-				else if (FParse::Command(&Str, TEXT("TEXTUREV")))
-				{
-					ParseFVector(Str, Poly.TextureV);
-				}
-				else if (FParse::Command(&Str, TEXT("NORMAL")))
-				{
-					ParseFVector(Str, Poly.Normal);
-				}
+				Texture.Empty();
 			}
-			if (!GotBase)
-				Poly.Base = Poly.Vertices[0];
-			if (Poly.Finalize(NULL, 1) == 0)
-				new(Polys->Element)FPoly(Poly);
+			int32 Link = INDEX_NONE;
+			FParse::Value(*Line, TEXT("LINK="), Link);
+			PolyListBuffer.BeginPoly(Texture, Link);
+			bInPolygon = true;
 		}
 	}
+
+	// Polygons are finalized together once the list is read, then appended to the brush
+	PolyListBuffer.FinalizeTo(Polys);
 }
 
-void T3DLevelParser::ImportPointLight()
+void T3DLevelParser::ParsePointLight(FT3DParsedLevel::FLightDesc &Desc)
 {
 	FString Value, Class;
-	APointLight* PointLight = SpawnActor<APointLight>();
+	Desc.bSpotLight = false;
+	Desc.Location = FVector::ZeroVector;
+	Desc.Rotation = FRotator::ZeroRotator;
+	Desc.Layer = NAME_None;
+	Desc.Properties = 0;
+	Desc.Radius = Desc.Brightness = Desc.InnerConeAngle = Desc.OuterConeAngle = 0.0f;
+	Desc.LightColor = FColor::White;
 
 	while (NextLine() && !IsEndObject())
 	{
@@ -733,17 +1653,18 @@ void T3DLevelParser::ImportPointLight()
 				{
 					if (GetProperty(TEXT("Radius="), Value))
 					{
-						PointLight->PointLightComponent->AttenuationRadius = FCString::Atof(*Value);
+						Desc.Radius = FCString::Atof(*Value);
+						Desc.Properties |= FT3DParsedLevel::FLightDesc::Radius;
 					}
 					else if (GetProperty(TEXT("Brightness="), Value))
 					{
-						PointLight->PointLightComponent->Intensity = FCString::Atof(*Value) * IntensityMultiplier;
+						Desc.Brightness = FCString::Atof(*Value);
+						Desc.Properties |= FT3DParsedLevel::FLightDesc::Brightness;
 					}
 					else if (GetProperty(TEXT("LightColor="), Value))
 					{
-						FColor Color;
-						Color.InitFromString(Value);
-						PointLight->PointLightComponent->LightColor = Color;
+						Desc.LightColor.InitFromString(Value);
+						Desc.Properties |= FT3DParsedLevel::FLightDesc::LightColor;
 					}
 				}
 			}
@@ -752,20 +1673,24 @@ void T3DLevelParser::ImportPointLight()
 				JumpToEnd();
 			}
 		}
-		else if (IsActorLocation(PointLight) || IsActorRotation(PointLight) || IsActorProperty(PointLight))
+		else if (IsActorLocation(Desc.Location) || IsActorRotation(Desc.Rotation) || IsActorProperty(Desc.Layer))
 		{
 			continue;
 		}
 	}
-	PointLight->PostEditChange();
 }
 
-void T3DLevelParser::ImportSpotLight()
+void T3DLevelParser::ParseSpotLight(FT3DParsedLevel::FLightDesc &Desc)
 {
 	FVector DrawScale3D(1.0,1.0,1.0);
 	FRotator Rotator(0.0, 0.0, 0.0);
-	FString Value, Class, Name;
-	ASpotLight* SpotLight = SpawnActor<ASpotLight>();
+	FString Value, Class;
+	Desc.bSpotLight = true;
+	Desc.Location = FVector::ZeroVector;
+	Desc.Layer = NAME_None;
+	Desc.Properties = 0;
+	Desc.Radius = Desc.Brightness = Desc.InnerConeAngle = Desc.OuterConeAngle = 0.0f;
+	Desc.LightColor = FColor::White;
 
 	while (NextLine() && !IsEndObject())
 	{
@@ -777,25 +1702,28 @@ void T3DLevelParser::ImportSpotLight()
 				{
 					if (GetProperty(TEXT("Radius="), Value))
 					{
-						SpotLight->SpotLightComponent->AttenuationRadius = FCString::Atof(*Value);
+						Desc.Radius = FCString::Atof(*Value);
+						Desc.Properties |= FT3DParsedLevel::FLightDesc::Radius;
 					}
 					else if (GetProperty(TEXT("InnerConeAngle="), Value))
 					{
-						SpotLight->SpotLightComponent->InnerConeAngle = FCString::Atof(*Value);
+						Desc.InnerConeAngle = FCString::Atof(*Value);
+						Desc.Properties |= FT3DParsedLevel::FLightDesc::InnerConeAngle;
 					}
 					else if (GetProperty(TEXT("OuterConeAngle="), Value))
 					{
-						SpotLight->SpotLightComponent->OuterConeAngle = FCString::Atof(*Value);
+						Desc.OuterConeAngle = FCString::Atof(*Value);
+						Desc.Properties |= FT3DParsedLevel::FLightDesc::OuterConeAngle;
 					}
 					else if (GetProperty(TEXT("Brightness="), Value))
 					{
-						SpotLight->SpotLightComponent->Intensity = FCString::Atof(*Value) * IntensityMultiplier;
+						Desc.Brightness = FCString::Atof(*Value);
+						Desc.Properties |= FT3DParsedLevel::FLightDesc::Brightness;
 					}
 					else if (GetProperty(TEXT("LightColor="), Value))
 					{
-						FColor Color;
-						Color.InitFromString(Value);
-						SpotLight->SpotLightComponent->LightColor = Color;
+						Desc.LightColor.InitFromString(Value);
+						Desc.Properties |= FT3DParsedLevel::FLightDesc::LightColor;
 					}
 				}
 			}
@@ -804,7 +1732,7 @@ void T3DLevelParser::ImportSpotLight()
 				JumpToEnd();
 			}
 		}
-		else if (IsActorLocation(SpotLight) || IsActorProperty(SpotLight))
+		else if (IsActorLocation(Desc.Location) || IsActorProperty(Desc.Layer))
 		{
 			continue;
 		}
@@ -819,17 +1747,73 @@ void T3DLevelParser::ImportSpotLight()
 	}
 
 	// Because there is people that does this in UDK...
-	SpotLight->SetActorRotation((DrawScale3D.X * Rotator.Vector()).Rotation());
-	SpotLight->PostEditChange();
+	Desc.Rotation = (DrawScale3D.X * Rotator.Vector()).Rotation();
+}
+
+void T3DLevelParser::SpawnLight(const FT3DParsedLevel::FLightDesc &Desc)
+{
+	ALight * Light;
+	ULightComponent * LightComponent;
+	if (Desc.bSpotLight)
+	{
+		ASpotLight * SpotLight = SpawnActor<ASpotLight>(GetSpawnLevel(Desc.Location));
+		if (Desc.Properties & FT3DParsedLevel::FLightDesc::Radius)
+			SpotLight->SpotLightComponent->AttenuationRadius = Desc.Radius;
+		if (Desc.Properties & FT3DParsedLevel::FLightDesc::InnerConeAngle)
+			SpotLight->SpotLightComponent->InnerConeAngle = Desc.InnerConeAngle;
+		if (Desc.Properties & FT3DParsedLevel::FLightDesc::OuterConeAngle)
+			SpotLight->SpotLightComponent->OuterConeAngle = Desc.OuterConeAngle;
+		Light = SpotLight;
+		LightComponent = SpotLight->SpotLightComponent;
+	}
+	else
+	{
+		APointLight * PointLight = SpawnActor<APointLight>(GetSpawnLevel(Desc.Location));
+		if (Desc.Properties & FT3DParsedLevel::FLightDesc::Radius)
+			PointLight->PointLightComponent->AttenuationRadius = Desc.Radius;
+		Light = PointLight;
+		LightComponent = PointLight->PointLightComponent;
+	}
+
+	if (Desc.Properties & FT3DParsedLevel::FLightDesc::Brightness)
+		LightComponent->Intensity = Desc.Brightness * IntensityMultiplier;
+	if (Desc.Properties & FT3DParsedLevel::FLightDesc::LightColor)
+		LightComponent->LightColor = Desc.LightColor;
+
+	Light->SetActorLocation(Desc.Location);
+	Light->SetActorRotation(Desc.Rotation);
+	if (Desc.Layer != NAME_None)
+	{
+		AddActorToLayer(Light, Desc.Layer);
+	}
+	Light->PostEditChange();
 }
 
-void T3DLevelParser::ImportStaticMeshActor()
+void T3DLevelParser::ImportStaticMeshActor(const FStaticMeshActorDesc &Desc)
+{
+	if (Settings->bConsolidateStaticMeshActors)
+	{
+		AddStaticMeshInstance(Desc);
+	}
+	else
+	{
+		SpawnStaticMeshActor(Desc);
+	}
+}
+
+void T3DLevelParser::ParseStaticMeshActor(FStaticMeshActorDesc &Desc)
 {
 	FString Value, Class;
 	FVector PrePivot;
+	int32 MaterialIdx;
 	bool bPrePivotFound = false;
-	AStaticMeshActor * StaticMeshActor = SpawnActor<AStaticMeshActor>();
-	
+
+	Desc.bBlockRigidBody = true;
+	Desc.Location = FVector::ZeroVector;
+	Desc.Rotation = FRotator::ZeroRotator;
+	Desc.Scale3D = FVector(1.0f, 1.0f, 1.0f);
+	Desc.Layer = NAME_None;
+
 	while (NextLine() && !IsEndObject())
 	{
 		if (IsBeginObject(Class))
@@ -840,7 +1824,17 @@ void T3DLevelParser::ImportStaticMeshActor()
 				{
 					if (GetProperty(TEXT("StaticMesh="), Value))
 					{
-						AddRequirement(Value, UObjectDelegate::CreateRaw(this, &T3DLevelParser::SetStaticMesh, StaticMeshActor->StaticMeshComponent.Get()));
+						Desc.StaticMeshUrl = Value;
+					}
+					else if (IsParameter(TEXT("Materials"), MaterialIdx, Value))
+					{
+						if (MaterialIdx >= Desc.MaterialUrls.Num())
+							Desc.MaterialUrls.SetNum(MaterialIdx + 1);
+						Desc.MaterialUrls[MaterialIdx] = Value;
+					}
+					else if (GetProperty(TEXT("BlockRigidBody="), Value))
+					{
+						Desc.bBlockRigidBody = Value.ToBool();
 					}
 				}
 			}
@@ -849,7 +1843,7 @@ void T3DLevelParser::ImportStaticMeshActor()
 				JumpToEnd();
 			}
 		}
-		else if (IsActorLocation(StaticMeshActor) || IsActorRotation(StaticMeshActor) || IsActorScale(StaticMeshActor) || IsActorProperty(StaticMeshActor))
+		else if (IsActorLocation(Desc.Location) || IsActorRotation(Desc.Rotation) || IsActorScale(Desc.Scale3D) || IsActorProperty(Desc.Layer))
 		{
 			continue;
 		}
@@ -858,16 +1852,130 @@ void T3DLevelParser::ImportStaticMeshActor()
 			ensure(PrePivot.InitFromString(Value));
 			bPrePivotFound = true;
 		}
+		else if (GetProperty(TEXT("CollisionType="), Value))
+		{
+			Desc.CollisionType = Value;
+		}
 	}
 
 	if (bPrePivotFound)
 	{
-		PrePivot = StaticMeshActor->GetActorRotation().RotateVector(PrePivot);
-		StaticMeshActor->SetActorLocation(StaticMeshActor->GetActorLocation() - PrePivot);
+		Desc.Location -= Desc.Rotation.RotateVector(PrePivot);
+	}
+}
+
+void T3DLevelParser::SpawnStaticMeshActor(const FStaticMeshActorDesc &Desc)
+{
+	AStaticMeshActor * StaticMeshActor = SpawnActor<AStaticMeshActor>(GetSpawnLevel(Desc.Location));
+	StaticMeshActor->SetActorTransform(FTransform(Desc.Rotation, Desc.Location, Desc.Scale3D));
+	if (Desc.Layer != NAME_None)
+	{
+		AddActorToLayer(StaticMeshActor, Desc.Layer);
 	}
+
+	ApplyStaticMeshComponentDesc(Desc, StaticMeshActor->StaticMeshComponent.Get());
 	StaticMeshActor->PostEditChange();
 }
 
+void T3DLevelParser::ApplyStaticMeshComponentDesc(const FStaticMeshActorDesc &Desc, UStaticMeshComponent * StaticMeshComponent)
+{
+	if (!Desc.StaticMeshUrl.IsEmpty())
+	{
+		AddRequirement(Desc.StaticMeshUrl, UObjectDelegate::CreateRaw(this, &T3DLevelParser::SetStaticMesh, StaticMeshComponent));
+	}
+
+	for (int32 MaterialIdx = 0; MaterialIdx < Desc.MaterialUrls.Num(); ++MaterialIdx)
+	{
+		if (!Desc.MaterialUrls[MaterialIdx].IsEmpty())
+		{
+			AddRequirement(Desc.MaterialUrls[MaterialIdx], UObjectDelegate::CreateRaw(this, &T3DLevelParser::SetStaticMeshComponentMaterial, StaticMeshComponent, MaterialIdx));
+		}
+	}
+
+	if (Desc.CollisionType == TEXT("COLLIDE_NoCollision"))
+	{
+		StaticMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	}
+	else if (!Desc.bBlockRigidBody)
+	{
+		StaticMeshComponent->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	}
+}
+
+void T3DLevelParser::AddStaticMeshInstance(const FStaticMeshActorDesc &Desc)
+{
+	FIntVector Cell(0, 0, 0);
+	if (Settings->InstancingCellSize > 0.0f)
+	{
+		Cell.X = FMath::FloorToInt(Desc.Location.X / Settings->InstancingCellSize);
+		Cell.Y = FMath::FloorToInt(Desc.Location.Y / Settings->InstancingCellSize);
+		Cell.Z = FMath::FloorToInt(Desc.Location.Z / Settings->InstancingCellSize);
+	}
+
+	// A group is spawned into a single sub-level
+	const FIntPoint SubLevelCell = SubLevelSharder.IsValid() ? SubLevelSharder->GetCellFor(Desc.Location) : FIntPoint(0, 0);
+
+	const FString GroupKey = FString::Printf(TEXT("%s|%s|%s|%d|%s|%d,%d,%d|%d,%d"),
+		*Desc.StaticMeshUrl,
+		*FString::Join(Desc.MaterialUrls, TEXT(",")),
+		*Desc.CollisionType,
+		Desc.bBlockRigidBody ? 1 : 0,
+		*Desc.Layer.ToString(),
+		Cell.X, Cell.Y, Cell.Z,
+		SubLevelCell.X, SubLevelCell.Y);
+
+	int32 * pGroupIndex = StaticMeshInstanceGroupIndices.Find(GroupKey);
+	if (pGroupIndex == NULL)
+	{
+		pGroupIndex = &StaticMeshInstanceGroupIndices.Add(GroupKey, StaticMeshInstanceGroups.Num());
+		FStaticMeshInstanceGroup &Group = StaticMeshInstanceGroups[StaticMeshInstanceGroups.AddDefaulted()];
+		Group.Desc = Desc;
+	}
+
+	StaticMeshInstanceGroups[*pGroupIndex].Instances.Add(FTransform(Desc.Rotation, Desc.Location, Desc.Scale3D));
+}
+
+void T3DLevelParser::SpawnStaticMeshInstanceGroups()
+{
+	for (int32 GroupIdx = 0; GroupIdx < StaticMeshInstanceGroups.Num(); ++GroupIdx)
+	{
+		const FStaticMeshInstanceGroup &Group = StaticMeshInstanceGroups[GroupIdx];
+
+		// Not worth an instanced component
+		if (Group.Instances.Num() == 1)
+		{
+			SpawnStaticMeshActor(Group.Desc);
+			continue;
+		}
+
+		// Instances are stored in world space, the actor stays at the origin, in the sub-level of its first instance
+		AActor * Actor = SpawnActor<AActor>(GetSpawnLevel(Group.Instances[0].GetLocation()));
+		UHierarchicalInstancedStaticMeshComponent * InstancedComponent = NewObject<UHierarchicalInstancedStaticMeshComponent>(Actor, NAME_None, RF_Transactional);
+		InstancedComponent->SetMobility(EComponentMobility::Static);
+		Actor->SetRootComponent(InstancedComponent);
+		Actor->AddInstanceComponent(InstancedComponent);
+		InstancedComponent->RegisterComponent();
+		InstancedComponent->AddInstances(Group.Instances, false);
+
+		FRequirement Requirement;
+		if (ParseRessourceUrl(Group.Desc.StaticMeshUrl, Requirement))
+		{
+			Actor->SetActorLabel(FString::Printf(TEXT("%s_Instances"), *Requirement.Name), false);
+		}
+
+		if (Group.Desc.Layer != NAME_None)
+		{
+			AddActorToLayer(Actor, Group.Desc.Layer);
+		}
+
+		ApplyStaticMeshComponentDesc(Group.Desc, InstancedComponent);
+		Actor->PostEditChange();
+	}
+
+	StaticMeshInstanceGroupIndices.Empty();
+	StaticMeshInstanceGroups.Empty();
+}
+
 USoundCue * T3DLevelParser::ImportSoundCue()
 {
 	USoundCue * SoundCue = 0;
@@ -888,9 +1996,20 @@ USoundCue * T3DLevelParser::ImportSoundCue()
 	return SoundCue;
 }
 
-void T3DLevelParser::SetPolygonTexture(UObject * Object, UPolys * Polys, int32 index)
+void T3DLevelParser::SetPolygonMaterialGroup(UObject * Object, int32 GroupIndex)
 {
-	Polys->Element[index].Material = Cast<UMaterialInterface>(Object);
+	// Groups are released once the level requirements are imported
+	if (!PolygonMaterialGroups.IsValidIndex(GroupIndex))
+		return;
+
+	FPolygonMaterialGroup &Group = PolygonMaterialGroups[GroupIndex];
+	Group.Material = Cast<UMaterialInterface>(Object);
+	Group.bResolved = true;
+	for (const FPolygonMaterialGroup::FTarget &Target : Group.Targets)
+	{
+		Target.Polys->Element[Target.Index].Material = Group.Material;
+	}
+	Group.Targets.Empty();
 }
 
 void T3DLevelParser::SetStaticMesh(UObject * Object, UStaticMeshComponent * StaticMeshComponent)
@@ -905,6 +2024,11 @@ void T3DLevelParser::SetStaticMesh(UObject * Object, UStaticMeshComponent * Stat
 	StaticMeshComponent->PostEditChangeProperty(PropertyChangedEvent);
 }
 
+void T3DLevelParser::SetStaticMeshComponentMaterial(UObject * Object, UStaticMeshComponent * StaticMeshComponent, int32 MaterialIdx)
+{
+	StaticMeshComponent->SetMaterial(MaterialIdx, Cast<UMaterialInterface>(Object));
+}
+
 void T3DLevelParser::SetSoundCueFirstNode(UObject * Object, USoundCue * SoundCue)
 {
 	SoundCue->FirstNode = Cast<USoundNode>(Object);
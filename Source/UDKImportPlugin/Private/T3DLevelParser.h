@@ -1,9 +1,22 @@
 #pragma once
 
+#include "Async/Future.h"
+#include "Containers/Queue.h"
 #include "T3DParser.h"
+#include "T3DParsedLevel.h"
+#include "T3DParsedMaterial.h"
+#include "T3DPolyListBuffer.h"
+#include "T3DMaterialParser.h"
+#include "T3DCore/T3DBoundedMPSCQueue.h"
+#include "UDKBrushManifest.h"
+#include "UDKImportManifest.h"
+#include "UDKImportedAssetIndex.h"
+#include "UDKSubLevelSharder.h"
 
-class T3DMaterialParser;
 class T3DMaterialInstanceConstantParser;
+class UUDKImportPluginSettings;
+class FUDKImportFilter;
+class FUDKImportPipeline;
 
 class T3DLevelParser : public T3DParser
 {
@@ -11,11 +24,20 @@ class T3DLevelParser : public T3DParser
 	friend class T3DMaterialInstanceConstantParser;
 public:
 	T3DLevelParser(const FString &UdkPath, const FString &TmpPath);
+	/** @param Settings - Settings of the import, taken on the game thread by the owning parser */
+	T3DLevelParser(const FString &UdkPath, const FString &TmpPath, const UUDKImportPluginSettings * Settings);
+	~T3DLevelParser();
 	void ImportLevel(const FString &Level);
 	void ImportStaticMesh(const FString &StaticMesh);
 	void ImportMaterial(const FString &Material);
 	void ImportMaterialInstanceConstant(const FString &MaterialInstanceConstant);
 
+	/** Add the stages of the matching Import function to Pipeline, to run it asynchronously */
+	void AddLevelImportStages(FUDKImportPipeline &Pipeline, const FString &Level);
+	void AddStaticMeshImportStages(FUDKImportPipeline &Pipeline, const FString &StaticMesh);
+	void AddMaterialImportStages(FUDKImportPipeline &Pipeline, const FString &Material);
+	void AddMaterialInstanceConstantImportStages(FUDKImportPipeline &Pipeline, const FString &MaterialInstanceConstant);
+
 private:
 	// Export tools
 	struct EExportType
@@ -32,42 +54,195 @@ private:
 	FString ExportFolderFor(EExportType::Type Type);
 	FString RessourceTypeFor(EExportType::Type Type);
 	void ImportRessource(const FString &Ressource, EExportType::Type Type);
+	void AddRessourceImportStages(FUDKImportPipeline &Pipeline, const FString &Ressource, EExportType::Type Type);
+	/** Export Package unless it already is, safe to call from several threads at once */
 	bool ExportPackage(const FString &Package, EExportType::Type Type, FString & ExportFolder);
+	/** One lock per export folder, so that a package is only exported once when several threads require it */
+	FCriticalSection ExportFolderLocksGuard;
+	TMap<FString, TSharedPtr<FCriticalSection, ESPMode::ThreadSafe> > ExportFolderLocks;
 	void ExportPackageToRequirements(const FString &Package, EExportType::Type Type);
 
 	/// Ressources requirements
-	void ResolveRequirements();
-	void ExportStaticMeshRequirements();
+	void AddResolveRequirementsStages(FUDKImportPipeline &Pipeline);
+	void ExportStaticMeshRequirements(const TArray<FRequirement> &AssetRequirements);
 	void ExportStaticMeshRequirements(const FString &StaticMeshesParams);
-	void ExportMaterialInstanceConstantAssets();
-	void ExportMaterialAssets();
-	void ExportTextureAssets();
-	void ExportStaticMeshAssets();
+	void ParseStaticMeshRequirements();
+	/** Export the packages of AssetRequirements one after the other */
+	void ExportRequiredPackages(const TArray<FRequirement> &AssetRequirements, EExportType::Type ExportType);
+	/** Export the packages of the instances, then the ones of their parent instances, read from the exported files */
+	void ExportMaterialInstanceConstantPackages(const TArray<FRequirement> &AssetRequirements);
+	void ImportRequiredAssets();
+	/** Import the pending requirements until EndTime, @return true once they are all processed */
+	bool ExportMaterialInstanceConstantAssets(double EndTime);
+	bool ExportMaterialAssets(double EndTime);
+	void ExportTextureAssets(const TArray<FRequirement> &AssetRequirements);
+	void ExportStaticMeshAssets(const TArray<FRequirement> &AssetRequirements);
 	void PostEditChangeFor(const FString &Type);
 
+	/** Output of the UDK material exports of static meshes, parsed on the game thread */
+	TArray<FString> StaticMeshRequirementsOutputs;
+
+	/** See UUDKImportPluginSettings::MemoryBudgetMB, memory used after the last collection it triggered */
+	uint64 MemoryAfterLastCollection;
+	void EnforceMemoryBudget();
+
+	/** Requirements imported over several frames by the sliced stages */
+	TArray<FRequirement> PendingRequirements;
+	int32 NextPendingRequirement;
+	bool bFixedPendingRequirement;
+	void CollectPendingRequirements(const FString &Type);
+
+	/** Pending materials parsed on worker threads, only their objects are created by ExportMaterialAssets */
+	TArray<FT3DParsedMaterial> ParsedMaterials;
+	void ParseMaterials();
+	FT3DMaterialReflectionCache MaterialReflectionCache;
+
+	/** Copies of the requirements handled by worker stages running alongside game thread stages */
+	TArray<FRequirement> StaticMeshAssetRequirements, InstanceTextureAssetRequirements, TextureAssetRequirements;
+	/** Requirements already copied by CollectRequirements, each one is only handled once */
+	TSet<FString> CollectedRequirementUrls;
+	void CollectRequirements(const FString &TypePrefix, TArray<FRequirement> &OutRequirements);
+	void GroupRequirementsByPackage(const TArray<FRequirement> &AssetRequirements, const FString &TypePrefix, TMap<FString, TArray<const FRequirement*> > &OutPackages);
+
+	/** Assets under /Game/UDK, built when the resolve stages are added and completed by the import */
+	FUDKImportedAssetIndex ImportedAssets;
+
+	/// Import of the exported assets, package by package as soon as the export stages produce them
+	struct FExportedPackageAssets
+	{
+		FString DestinationPath;
+		TArray<FString> Files;
+	};
+	TQueue<FExportedPackageAssets, EQueueMode::Mpsc> ExportedPackageAssets;
+	/** Static meshes, material instance textures and the other textures */
+	static const int32 AssetExportStageCount = 3;
+	FThreadSafeCounter PendingAssetExportStages;
+	void QueueAssetImport(const FString &DestinationPath, const TArray<FString> &Files);
+	/** Import the queued packages until EndTime, @return true once every export stage is done and its packages imported */
+	bool ImportExportedAssets(double EndTime);
+
 	/// Actor creation
 	UWorld * World;
+	const UUDKImportPluginSettings * Settings;
+	void FindWorld();
+	/** @param Level - Level receiving the actor, NULL for the current level of World */
 	template<class T>
-	T * SpawnActor();
+	T * SpawnActor(ULevel * Level = NULL);
+	/** Sub-levels receiving the actors when SubLevelCellSize is set, see FUDKSubLevelSharder */
+	TUniquePtr<FUDKSubLevelSharder> SubLevelSharder;
+	ULevel * GetSpawnLevel(const FVector &Location);
+
+	/** Actors spawned while importing the current block */
+	TArray<AActor*> BlockActors;
+
+	/** Blocks imported by this run, see FUDKImportManifest */
+	FUDKImportManifest ImportManifest;
+
+	/// Level parsing into descriptors
+	typedef FT3DParsedLevel::FStaticMeshActorDesc FStaticMeshActorDesc;
+	FT3DParsedLevel ParsedLevel;
+	bool LoadParsedLevel();
+	void ScanLevel(const FUDKImportFilter &ImportFilter);
+	void ParseBlock(const FT3DParsedLevel::FActorBlock &Block, int32 BeginLine, FT3DParsedLevel &Level);
+	void SaveParsedLevel();
+	bool bParsedFromCache;
+
+	/// Parallel parsing, parse tasks hand the index of each parsed block to the applier through ParsedBlockQueue
+	static const uint32 ParsedBlockQueueCapacity;
+	/** First line of every block scanned by ScanLevel, INDEX_NONE for the blocks that are not parsed */
+	TArray<int32> BlockBeginLines;
+	/** Line following every block, its lines are released once it is parsed */
+	TArray<int32> BlockEndLines;
+	TUniquePtr<T3DCore::TBoundedMPSCQueue<int32> > ParsedBlockQueue;
+	FThreadSafeCounter NextBlockToParse;
+	FThreadSafeBool bAbortParse;
+	TArray<TFuture<void> > ParseTasks;
+	void StartParseTasks();
+	void ParseBlocks();
+	void WaitForParseTasks();
+	void ParseBrush(FT3DParsedLevel::FBrushDesc &Desc);
+	void ParsePolyList(TArray<FT3DParsedLevel::FPolyDesc> &Polys);
+	/** Reused by every brush parsed by this parser */
+	FT3DPolyListBuffer PolyListBuffer;
+	void ParsePointLight(FT3DParsedLevel::FLightDesc &Desc);
+	void ParseSpotLight(FT3DParsedLevel::FLightDesc &Desc);
+	void ParseStaticMeshActor(FStaticMeshActorDesc &Desc);
+	/** Polygons and bounds of a brush, built by the parse tasks so that SpawnBrush only creates its objects */
+	struct FBrushGeometry
+	{
+		TArray<FPoly> Polys;
+		FBoxSphereBounds Bounds;
+	};
+	/** By brush descriptor index */
+	TArray<FBrushGeometry> BrushGeometries;
+	static void BuildBrushGeometry(const FT3DParsedLevel::FBrushDesc &Desc, FBrushGeometry &Geometry);
 
 	/// Actor Importation
-	void ImportLevel();
-	void ImportBrush();
-	void ImportPolyList(UPolys * Polys);
-	void ImportStaticMeshActor();
-	void ImportPointLight();
-	void ImportSpotLight();
+	/** Spawning is split so that it can run over several frames, see ImportParsedBlocks */
+	void BeginImportParsedLevel();
+	/** Import the blocks handed over by the parse tasks until EndTime, @return true once every block is imported */
+	bool ImportParsedBlocks(double EndTime);
+	void ImportParsedBlock(const FT3DParsedLevel::FActorBlock &Block, bool bIncremental);
+	void EndImportParsedLevel();
+	int32 ImportedBlockCount, SkippedActorCount, UnchangedActorCount;
+	/** Brush blocks parsed before the brushes preceding them, by BrushOrder */
+	TMap<int32, int32> DeferredBrushBlocks;
+	int32 NextBrushOrder;
+	/** Set once a brush is spawned again, the brushes following it are spawned again too to keep their CSG order */
+	bool bRespawnBrushes;
+	FUDKImportManifest PreviousManifest;
+	void SpawnBrush(const FT3DParsedLevel::FBrushDesc &Desc, FBrushGeometry &Geometry, int32 BrushOrder);
+	/** Polygons of every brush using a same material, which is a single requirement for all of them */
+	struct FPolygonMaterialGroup
+	{
+		struct FTarget
+		{
+			UPolys * Polys;
+			int32 Index;
+		};
+		TArray<FTarget> Targets;
+		/** Set once the requirement is fixed, the polygons added afterwards get it right away */
+		UMaterialInterface * Material;
+		bool bResolved;
+	};
+	/** By material url as found in the T3D */
+	TMap<FString, int32> PolygonMaterialGroupIndices;
+	TArray<FPolygonMaterialGroup> PolygonMaterialGroups;
+	void AddPolygonMaterial(const FString &MaterialUrl, UPolys * Polys, int32 Index);
+	/** Brushes spawned by the current slice, their editor notifications are sent together at its end */
+	TArray<ABrush*> SpawnedBrushesToNotify;
+	void NotifySpawnedBrushes();
+	void SpawnLight(const FT3DParsedLevel::FLightDesc &Desc);
+	void ImportStaticMeshActor(const FStaticMeshActorDesc &Desc);
+	void SpawnStaticMeshActor(const FStaticMeshActorDesc &Desc);
+	void ApplyStaticMeshComponentDesc(const FStaticMeshActorDesc &Desc, UStaticMeshComponent * StaticMeshComponent);
 	USoundCue * ImportSoundCue();
 
-	/** After parsing, apply import-time metadata for brushes (labels/tags) so CSG order can be reconstructed */
+	/// StaticMeshActor consolidation into hierarchical instanced static meshes
+	struct FStaticMeshInstanceGroup
+	{
+		/** First descriptor of the group, every member shares its mesh, materials, collision and layer */
+		FStaticMeshActorDesc Desc;
+		TArray<FTransform> Instances;
+	};
+	TMap<FString, int32> StaticMeshInstanceGroupIndices;
+	TArray<FStaticMeshInstanceGroup> StaticMeshInstanceGroups;
+	void AddStaticMeshInstance(const FStaticMeshActorDesc &Desc);
+	void SpawnStaticMeshInstanceGroups();
+
+	/** After spawning, prefix the labels of imported brushes with their CSG order when the settings ask for it */
 	void ApplyImportedBrushOrder();
 
-	/** Write a JSON manifest describing imported brushes (rich metadata) */
-	void WriteBrushManifest(const FString& OutFileName);
+	/** Write a manifest describing imported brushes (rich metadata), see FUDKBrushManifestWriter */
+	void WriteBrushManifest(const FString& OutFileName, FUDKBrushManifestWriter::EFormat Format);
+
+	/** Replace imported brushes by static meshes baked from their CSG result */
+	void BakeBrushes();
 
 	/// Available ressource actions
 	void SetStaticMesh(UObject * Object, UStaticMeshComponent * StaticMeshComponent);
-	void SetPolygonTexture(UObject * Object, UPolys * Polys, int32 index);
+	void SetStaticMeshComponentMaterial(UObject * Object, UStaticMeshComponent * StaticMeshComponent, int32 MaterialIdx);
+	void SetPolygonMaterialGroup(UObject * Object, int32 GroupIndex);
 	void SetSoundCueFirstNode(UObject * Object, USoundCue * SoundCue);
 	void SetStaticMeshMaterial(UObject * Material, FString StaticMeshUrl, int32 MaterialIdx);
 	void SetStaticMeshMaterialResolved(UObject * Object, UObject * Material, int32 MaterialIdx);
@@ -76,9 +251,9 @@ private:
 	void SetTextureParameterValue(UObject * Object, UMaterialInstanceConstant * MaterialInstanceConstant, int32 ParameterIndex);
 
 private:
-	/** Counter to track brush creation order during parsing */
-	int32 BrushOrderCounter;
-
 	/** Brushes created during import recorded in parse order */
 	TArray<TWeakObjectPtr<ABrush>> ImportedBrushes;
+
+	/** Position of each imported brush amongst every brush of the level */
+	TArray<int32> ImportedBrushOrders;
 };
@@ -2,7 +2,7 @@
 #include "T3DMaterialInstanceConstantParser.h"
 #include "T3DLevelParser.h"
 
-T3DMaterialInstanceConstantParser::T3DMaterialInstanceConstantParser(T3DLevelParser * ParentParser, const FString &Package) : T3DParser(ParentParser->UdkPath, ParentParser->TmpPath)
+T3DMaterialInstanceConstantParser::T3DMaterialInstanceConstantParser(T3DLevelParser * ParentParser, const FString &Package) : T3DParser(ParentParser->UdkPath, ParentParser->TmpPath, ParentParser->Settings)
 {
 	this->LevelParser = ParentParser;
 	this->Package = Package;
@@ -109,30 +109,3 @@ UMaterialInstanceConstant*  T3DMaterialInstanceConstantParser::ImportMaterialIns
 
 	return MaterialInstanceConstant;
 }
-
-bool T3DMaterialInstanceConstantParser::IsParameter(const FString &Key, int32 &index, FString &Value)
-{
-	const TCHAR* Stream = *Line;
-
-	if (FParse::Command(&Stream, *Key) && *Stream == TCHAR('('))
-	{
-		++Stream;
-		index = FCString::Atoi(Stream);
-		while (FChar::IsAlnum(*Stream))
-		{
-			++Stream;
-		}
-		if (*Stream == TCHAR(')'))
-		{
-			++Stream;
-			if (*Stream == TCHAR('='))
-			{
-				++Stream;
-				Value = Stream;
-				return true;
-			}
-		}
-	}
-
-	return false;
-}
@@ -1,9 +1,64 @@
 #include "UDKImportPluginPrivatePCH.h"
 #include "T3DMaterialParser.h"
 #include "T3DLevelParser.h"
+#include "UDKImportProfiler.h"
 #include "Materials/MaterialFunction.h"
 
-T3DMaterialParser::T3DMaterialParser(T3DLevelParser * ParentParser, const FString &Package) : T3DParser(ParentParser->UdkPath, ParentParser->TmpPath)
+UClass * FT3DMaterialReflectionCache::FindExpressionClass(const FString &ClassName)
+{
+	UClass ** CachedClass = ExpressionClasses.Find(ClassName);
+	FUDKImportProfiler::Get().AddCacheLookup(TEXT("MaterialExpressionClasses"), CachedClass != NULL);
+	if (CachedClass)
+		return *CachedClass;
+
+	UClass * Class;
+	if (ClassName == TEXT("MaterialExpressionFlipBookSample"))
+	{
+		Class = UMaterialExpressionTextureSample::StaticClass();
+	}
+	else
+	{
+		Class = (UClass*)StaticFindObject(UClass::StaticClass(), ANY_PACKAGE, *ClassName, true);
+	}
+
+	if (Class && !Class->IsChildOf(UMaterialExpression::StaticClass()))
+	{
+		Class = NULL;
+	}
+
+	ExpressionClasses.Add(ClassName, Class);
+	return Class;
+}
+
+const FT3DMaterialReflectionCache::FPropertyPlan & FT3DMaterialReflectionCache::FindPropertyPlan(UClass * Class, const FString &PropertyName)
+{
+	TMap<FString, FPropertyPlan> &ClassPlans = PropertyPlans.FindOrAdd(Class);
+	const FPropertyPlan * CachedPlan = ClassPlans.Find(PropertyName);
+	FUDKImportProfiler::Get().AddCacheLookup(TEXT("MaterialPropertyPlans"), CachedPlan != NULL);
+	if (CachedPlan)
+		return *CachedPlan;
+
+	FString FieldName = PropertyName;
+	if (Class->GetName() == TEXT("MaterialExpressionDesaturation") && PropertyName == TEXT("Percent"))
+	{
+		FieldName = TEXT("Fraction");
+	}
+
+	FPropertyPlan Plan;
+	Plan.Property = FindField<UProperty>(Class, *FieldName);
+	UStructProperty * StructProperty = Cast<UStructProperty>(Plan.Property);
+	Plan.bExpressionInput = StructProperty && StructProperty->Struct->GetName() == TEXT("ExpressionInput");
+
+	return ClassPlans.Add(PropertyName, Plan);
+}
+
+void FT3DMaterialReflectionCache::Empty()
+{
+	ExpressionClasses.Empty();
+	PropertyPlans.Empty();
+}
+
+T3DMaterialParser::T3DMaterialParser(T3DLevelParser * ParentParser, const FString &Package) : T3DParser(ParentParser->UdkPath, ParentParser->TmpPath, ParentParser->Settings)
 {
 	this->LevelParser = ParentParser;
 	this->Package = Package;
@@ -11,32 +66,128 @@ T3DMaterialParser::T3DMaterialParser(T3DLevelParser * ParentParser, const FStrin
 }
 
 UMaterial* T3DMaterialParser::ImportMaterialT3DFile(const FString &FileName)
+{
+	FT3DParsedMaterial ParsedMaterial;
+	if (ParseMaterialT3DFile(FileName, ParsedMaterial))
+	{
+		return BuildMaterial(ParsedMaterial);
+	}
+
+	return NULL;
+}
+
+bool T3DMaterialParser::ParseMaterialT3DFile(const FString &FileName, FT3DParsedMaterial &ParsedMaterial)
 {
 	FString MaterialT3D;
 	if (FFileHelper::LoadFileToString(MaterialT3D, *FileName))
 	{
 		ResetParser(MaterialT3D);
 		MaterialT3D.Empty();
-		return ImportMaterial();
+		return ParseMaterial(ParsedMaterial);
 	}
 
-	return NULL;
+	return false;
 }
 
-UMaterial*  T3DMaterialParser::ImportMaterial()
+bool T3DMaterialParser::ParseMaterial(FT3DParsedMaterial &ParsedMaterial)
 {
 	FString ClassName, Name, Value;
-	UClass * Class;
 
-	ensure(NextLine());
-	ensure(IsBeginObject(ClassName));
-	ensure(ClassName == TEXT("Material"));
-	ensure(GetOneValueAfter(TEXT(" Name="), Name));
+	if (!NextLine() || !IsBeginObject(ClassName) || ClassName != TEXT("Material") || !GetOneValueAfter(TEXT(" Name="), ParsedMaterial.Name))
+	{
+		return false;
+	}
+
+	while (NextLine() && !IsEndObject())
+	{
+		if (IsBeginObject(ClassName))
+		{
+			FT3DParsedMaterial::FExpressionDesc &Desc = ParsedMaterial.Expressions[ParsedMaterial.Expressions.AddDefaulted()];
+			Desc.ClassName = ClassName;
+			ensure(GetOneValueAfter(TEXT(" Name="), Desc.Name));
+			ParseMaterialExpression(Desc);
+		}
+		else if (IsProperty(Name, Value))
+		{
+			FT3DParsedMaterial::FPropertyDesc &Property = ParsedMaterial.Properties[ParsedMaterial.Properties.AddDefaulted()];
+			Property.Name = Name;
+			Property.Value = Value;
+			Property.Line = Line;
+		}
+	}
+
+	return true;
+}
+
+void T3DMaterialParser::ParseMaterialExpression(FT3DParsedMaterial::FExpressionDesc &Desc)
+{
+	Desc.FlipBookHorizontalImages = 0.0f;
+	Desc.FlipBookVerticalImages = 0.0f;
+
+	FString Value, PropertyName;
+	while (NextLine() && IgnoreSubs() && !IsEndObject())
+	{
+		if (GetProperty(TEXT("Texture="), Value))
+		{
+			Desc.TextureUrl = Value;
+		}
+		else if (IsProperty(PropertyName, Value) 
+			&& PropertyName != TEXT("Material")
+			&& PropertyName != TEXT("ExpressionGUID")
+			&& PropertyName != TEXT("ObjectArchetype"))
+		{
+			FT3DParsedMaterial::FPropertyDesc &Property = Desc.Properties[Desc.Properties.AddDefaulted()];
+			Property.Name = PropertyName;
+			Property.Value = Value;
+			Property.Line = Line;
+		}
+	}
+
+	if (Desc.ClassName == TEXT("MaterialExpressionFlipBookSample"))
+	{
+		ParseMaterialExpressionFlipBookSample(Desc);
+	}
+}
+
+void T3DMaterialParser::ParseMaterialExpressionFlipBookSample(FT3DParsedMaterial::FExpressionDesc &Desc)
+{
+	// Textures that are not exported yet are exported by T3DLevelParser::ParseMaterials, then read again
+	FString TexturePackage;
+	ReadFlipBookTextureInfo(Desc, TexturePackage);
+}
+
+bool T3DMaterialParser::ReadFlipBookTextureInfo(FT3DParsedMaterial::FExpressionDesc &Desc, FString &TexturePackage)
+{
+	FRequirement TextureRequirement;
+	if (!ParseRessourceUrl(Desc.TextureUrl, TextureRequirement))
+		return true;
+	TexturePackage = TextureRequirement.Package;
+
+	// The number of images is only found in the T3D export of the texture
+	const FString FileName = LevelParser->ExportFolderFor(T3DLevelParser::EExportType::Texture2DInfo) / TextureRequirement.Package / (TextureRequirement.Name + TEXT(".T3D"));
+	if (!FFileHelper::LoadFileToString(Line, *FileName))
+		return false;
+
+	FString Value;
+	if (GetOneValueAfter(TEXT("HorizontalImages="), Value))
+	{
+		Desc.FlipBookHorizontalImages = FCString::Atof(*Value);
+	}
+	if (GetOneValueAfter(TEXT("VerticalImages="), Value))
+	{
+		Desc.FlipBookVerticalImages = FCString::Atof(*Value);
+	}
+	return true;
+}
+
+UMaterial*  T3DMaterialParser::BuildMaterial(const FT3DParsedMaterial &ParsedMaterial)
+{
+	check(IsInGameThread());
 
 	FString BasePackageName = FString::Printf(TEXT("/Game/UDK/%s/Materials"), *Package);
 	FAssetToolsModule& AssetToolsModule = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools");
 	UMaterialFactoryNew* MaterialFactory = ConstructObject<UMaterialFactoryNew>(UMaterialFactoryNew::StaticClass());
-	Material = (UMaterial*)AssetToolsModule.Get().CreateAsset(Name, BasePackageName, UMaterial::StaticClass(), MaterialFactory);
+	Material = (UMaterial*)AssetToolsModule.Get().CreateAsset(ParsedMaterial.Name, BasePackageName, UMaterial::StaticClass(), MaterialFactory);
 	if (Material == NULL)
 	{
 		return NULL;
@@ -44,81 +195,70 @@ UMaterial*  T3DMaterialParser::ImportMaterial()
 
 	Material->Modify();
 
-	while (NextLine() && !IsEndObject())
+	for (const FT3DParsedMaterial::FExpressionDesc &Desc : ParsedMaterial.Expressions)
 	{
-		if (IsBeginObject(ClassName))
+		UClass * Class = LevelParser->MaterialReflectionCache.FindExpressionClass(Desc.ClassName);
+		if (Class)
 		{
-			if (ClassName == TEXT("MaterialExpressionFlipBookSample"))
+			UMaterialExpression* MaterialExpression = ImportMaterialExpression(Class, Desc);
+			UMaterialExpressionComment * MaterialExpressionComment = Cast<UMaterialExpressionComment>(MaterialExpression);
+			if (MaterialExpressionComment)
 			{
-				Class = UMaterialExpressionTextureSample::StaticClass();
+				Material->EditorComments.Add(MaterialExpressionComment);
+				MaterialExpressionComment->MaterialExpressionEditorX -= MaterialExpressionComment->SizeX;
 			}
 			else
 			{
-				Class = (UClass*)StaticFindObject(UClass::StaticClass(), ANY_PACKAGE, *ClassName, true);
+				Material->Expressions.Add(MaterialExpression);
 			}
+			FixRequirement(FString::Printf(TEXT("%s'%s'"), *Desc.ClassName, *Desc.Name), MaterialExpression);
 
-			if (Class)
+			if (Desc.ClassName == TEXT("MaterialExpressionFlipBookSample"))
 			{
-				ensure(GetOneValueAfter(TEXT(" Name="), Name));
-				FRequirement TextureRequirement;
-				UMaterialExpression* MaterialExpression = ImportMaterialExpression(Class, TextureRequirement);
-				UMaterialExpressionComment * MaterialExpressionComment = Cast<UMaterialExpressionComment>(MaterialExpression);
-				if (MaterialExpressionComment)
-				{
-					Material->EditorComments.Add(MaterialExpressionComment);
-					MaterialExpressionComment->MaterialExpressionEditorX -= MaterialExpressionComment->SizeX;
-					FixRequirement(FString::Printf(TEXT("%s'%s'"), *ClassName, *Name), MaterialExpression);
-				}
-				else if (MaterialExpression)
-				{
-					Material->Expressions.Add(MaterialExpression);
-					FixRequirement(FString::Printf(TEXT("%s'%s'"), *ClassName, *Name), MaterialExpression);
-				}
-
-				if (ClassName == TEXT("MaterialExpressionFlipBookSample"))
-				{
-					ImportMaterialExpressionFlipBookSample((UMaterialExpressionTextureSample *)MaterialExpression, TextureRequirement);
-				}
-			}
-			else
-			{
-				JumpToEnd();
+				ImportMaterialExpressionFlipBookSample((UMaterialExpressionTextureSample *)MaterialExpression, Desc);
 			}
 		}
-		else if (GetProperty(TEXT("DiffuseColor="), Value))
+	}
+
+	for (const FT3DParsedMaterial::FPropertyDesc &Property : ParsedMaterial.Properties)
+	{
+		// Inputs are parsed from the whole line
+		Line = Property.Line;
+
+		if (Property.Name == TEXT("DiffuseColor"))
 		{
 			ImportExpression(&Material->BaseColor);
 		}
-		else if (GetProperty(TEXT("SpecularColor="), Value))
+		else if (Property.Name == TEXT("SpecularColor"))
 		{
 			ImportExpression(&Material->Specular);
 		}
-		else if (GetProperty(TEXT("SpecularPower="), Value))
+		else if (Property.Name == TEXT("SpecularPower"))
 		{
 			// TODO
 		}
-		else if (GetProperty(TEXT("Normal="), Value))
+		else if (Property.Name == TEXT("Normal"))
 		{
 			ImportExpression(&Material->Normal);
 		}
-		else if (GetProperty(TEXT("EmissiveColor="), Value))
+		else if (Property.Name == TEXT("EmissiveColor"))
 		{
 			ImportExpression(&Material->EmissiveColor);
 		}
-		else if (GetProperty(TEXT("Opacity="), Value))
+		else if (Property.Name == TEXT("Opacity"))
 		{
 			ImportExpression(&Material->Opacity);
 		}
-		else if (GetProperty(TEXT("OpacityMask="), Value))
+		else if (Property.Name == TEXT("OpacityMask"))
 		{
 			ImportExpression(&Material->OpacityMask);
 		}
-		else if (IsProperty(Name, Value))
+		else
 		{
-			UProperty* Property = FindField<UProperty>(UMaterial::StaticClass(), *Name);
-			if (Property)
+			UProperty* MaterialProperty = LevelParser->MaterialReflectionCache.FindPropertyPlan(UMaterial::StaticClass(), Property.Name).Property;
+			if (MaterialProperty)
 			{
-				Property->ImportText(*Value, Property->ContainerPtrToValuePtr<uint8>(Material), 0, Material);
+				MaterialProperty->ImportText(*Property.Value, MaterialProperty->ContainerPtrToValuePtr<uint8>(Material), 0, Material);
 			}
 		}
 	}
@@ -128,67 +268,59 @@ UMaterial*  T3DMaterialParser::ImportMaterial()
 	return Material;
 }
 
-UMaterialExpression* T3DMaterialParser::ImportMaterialExpression(UClass * Class, FRequirement &TextureRequirement)
+UMaterialExpression* T3DMaterialParser::ImportMaterialExpression(UClass * Class, const FT3DParsedMaterial::FExpressionDesc &Desc)
 {
-	if (!Class->IsChildOf(UMaterialExpression::StaticClass()))
-		return NULL;
 	UMaterialExpression* MaterialExpression = ConstructObject<UMaterialExpression>(Class, Material);
 
-	FString Value, Name, PropertyName, Type, PackageName;
-	while (NextLine() && IgnoreSubs() && !IsEndObject())
+	if (!Desc.TextureUrl.IsEmpty())
 	{
-		if (GetProperty(TEXT("Texture="), Value))
+		FRequirement TextureRequirement;
+		if (ParseRessourceUrl(Desc.TextureUrl, TextureRequirement))
 		{
-			if (ParseRessourceUrl(Value, TextureRequirement))
-			{
-				LevelParser->AddRequirement(TextureRequirement, UObjectDelegate::CreateRaw(LevelParser, &T3DLevelParser::SetTexture, (UMaterialExpressionTextureBase*)MaterialExpression));
-			}
-			else
-			{
-				UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to parse ressource url : %s"), *Value);
-			}
+			LevelParser->AddRequirement(TextureRequirement, UObjectDelegate::CreateRaw(LevelParser, &T3DLevelParser::SetTexture, (UMaterialExpressionTextureBase*)MaterialExpression));
 		}
-		else if (IsProperty(PropertyName, Value) 
-			&& PropertyName != TEXT("Material")
-			&& PropertyName != TEXT("ExpressionGUID")
-			&& PropertyName != TEXT("ObjectArchetype"))
+		else
 		{
-			if (Class->GetName() == TEXT("MaterialExpressionDesaturation") && PropertyName == TEXT("Percent"))
-			{
-				PropertyName = TEXT("Fraction");
-			}
-			else if (Class == UMaterialExpressionConstant4Vector::StaticClass())
-			{
-				if (PropertyName == TEXT("A"))
-					((UMaterialExpressionConstant4Vector*)MaterialExpression)->Constant.A = FCString::Atof(*Value);
-				else if (PropertyName == TEXT("B"))
-					((UMaterialExpressionConstant4Vector*)MaterialExpression)->Constant.B = FCString::Atof(*Value);
-				else if (PropertyName == TEXT("G"))
-					((UMaterialExpressionConstant4Vector*)MaterialExpression)->Constant.G = FCString::Atof(*Value);
-				else if (PropertyName == TEXT("R"))
-					((UMaterialExpressionConstant4Vector*)MaterialExpression)->Constant.R = FCString::Atof(*Value);
-			}
-			else if (Class == UMaterialExpressionConstant3Vector::StaticClass())
-			{
-				if (PropertyName == TEXT("B"))
-					((UMaterialExpressionConstant3Vector*)MaterialExpression)->Constant.B = FCString::Atof(*Value);
-				else if (PropertyName == TEXT("G"))
-					((UMaterialExpressionConstant3Vector*)MaterialExpression)->Constant.G = FCString::Atof(*Value);
-				else if (PropertyName == TEXT("R"))
-					((UMaterialExpressionConstant3Vector*)MaterialExpression)->Constant.R = FCString::Atof(*Value);
-			}
+			UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to parse ressource url : %s"), *Desc.TextureUrl);
+		}
+	}
 
-			UProperty* Property = FindField<UProperty>(Class, *PropertyName);
-			UStructProperty * StructProperty = Cast<UStructProperty>(Property);
-			if (StructProperty && StructProperty->Struct->GetName() == TEXT("ExpressionInput"))
-			{
-				FExpressionInput * ExpressionInput = Property->ContainerPtrToValuePtr<FExpressionInput>(MaterialExpression);
-				ImportExpression(ExpressionInput);
-			}
-			else if (Property)
-			{
-				Property->ImportText(*Value, Property->ContainerPtrToValuePtr<uint8>(MaterialExpression), 0, MaterialExpression);
-			}
+	for (const FT3DParsedMaterial::FPropertyDesc &PropertyDesc : Desc.Properties)
+	{
+		const FString &PropertyName = PropertyDesc.Name;
+		const FString &Value = PropertyDesc.Value;
+		Line = PropertyDesc.Line;
+
+		if (Class == UMaterialExpressionConstant4Vector::StaticClass())
+		{
+			if (PropertyName == TEXT("A"))
+				((UMaterialExpressionConstant4Vector*)MaterialExpression)->Constant.A = FCString::Atof(*Value);
+			else if (PropertyName == TEXT("B"))
+				((UMaterialExpressionConstant4Vector*)MaterialExpression)->Constant.B = FCString::Atof(*Value);
+			else if (PropertyName == TEXT("G"))
+				((UMaterialExpressionConstant4Vector*)MaterialExpression)->Constant.G = FCString::Atof(*Value);
+			else if (PropertyName == TEXT("R"))
+				((UMaterialExpressionConstant4Vector*)MaterialExpression)->Constant.R = FCString::Atof(*Value);
+		}
+		else if (Class == UMaterialExpressionConstant3Vector::StaticClass())
+		{
+			if (PropertyName == TEXT("B"))
+				((UMaterialExpressionConstant3Vector*)MaterialExpression)->Constant.B = FCString::Atof(*Value);
+			else if (PropertyName == TEXT("G"))
+				((UMaterialExpressionConstant3Vector*)MaterialExpression)->Constant.G = FCString::Atof(*Value);
+			else if (PropertyName == TEXT("R"))
+				((UMaterialExpressionConstant3Vector*)MaterialExpression)->Constant.R = FCString::Atof(*Value);
+		}
+
+		const FT3DMaterialReflectionCache::FPropertyPlan &Plan = LevelParser->MaterialReflectionCache.FindPropertyPlan(Class, PropertyName);
+		if (Plan.bExpressionInput)
+		{
+			FExpressionInput * ExpressionInput = Plan.Property->ContainerPtrToValuePtr<FExpressionInput>(MaterialExpression);
+			ImportExpression(ExpressionInput);
+		}
+		else if (Plan.Property)
+		{
+			Plan.Property->ImportText(*Value, Plan.Property->ContainerPtrToValuePtr<uint8>(MaterialExpression), 0, MaterialExpression);
 		}
 	}
 	MaterialExpression->Material = Material;
@@ -197,7 +329,7 @@ UMaterialExpression* T3DMaterialParser::ImportMaterialExpression(UClass * Class,
 	return MaterialExpression;
 }
 
-void T3DMaterialParser::ImportMaterialExpressionFlipBookSample(UMaterialExpressionTextureSample * Expression, FRequirement &TextureRequirement)
+void T3DMaterialParser::ImportMaterialExpressionFlipBookSample(UMaterialExpressionTextureSample * Expression, const FT3DParsedMaterial::FExpressionDesc &Desc)
 {
 	UMaterialExpressionMaterialFunctionCall * MEFunction = ConstructObject<UMaterialExpressionMaterialFunctionCall>(UMaterialExpressionMaterialFunctionCall::StaticClass(), Material);
 	UMaterialExpressionConstant * MECRows = ConstructObject<UMaterialExpressionConstant>(UMaterialExpressionConstant::StaticClass(), Material);
@@ -223,21 +355,8 @@ void T3DMaterialParser::ImportMaterialExpressionFlipBookSample(UMaterialExpressi
 		MEFunction->FunctionInputs[4].Input.Expression = Expression->Coordinates.Expression;
 	}
 
-	FString ExportFolder;
-	FString FileName = TextureRequirement.Name + TEXT(".T3D");
-	LevelParser->ExportPackage(TextureRequirement.Package, T3DLevelParser::EExportType::Texture2DInfo, ExportFolder);
-	if (FFileHelper::LoadFileToString(Line, *(ExportFolder / FileName)))
-	{
-		FString Value;
-		if (GetOneValueAfter(TEXT("HorizontalImages="), Value))
-		{
-			MECCols->R = FCString::Atof(*Value);
-		}
-		if (GetOneValueAfter(TEXT("VerticalImages="), Value))
-		{
-			MECRows->R = FCString::Atof(*Value);
-		}
-	}
+	MECCols->R = Desc.FlipBookHorizontalImages;
+	MECRows->R = Desc.FlipBookVerticalImages;
 
 	Expression->Coordinates.OutputIndex = 2;
 	Expression->Coordinates.Expression = MEFunction;
@@ -1,24 +1,65 @@
 #pragma once
 
 #include "T3DParser.h"
+#include "T3DParsedMaterial.h"
 
 class T3DLevelParser;
 
+/**
+ * Reflection lookups of the material imports, shared by the materials of an import so that each class
+ * and property is only searched once. Game thread only.
+ */
+class FT3DMaterialReflectionCache
+{
+public:
+	/** How to import a property of an expression class, resolved once per class and property name */
+	struct FPropertyPlan
+	{
+		UProperty * Property;
+		/** Property is an FExpressionInput, linked to another expression rather than imported as text */
+		bool bExpressionInput;
+	};
+
+	/** @return the class of an expression in a UDK export, NULL if there is no such class */
+	UClass * FindExpressionClass(const FString &ClassName);
+	/** @return the plan to import a property, its Property is NULL if the class has no such property */
+	const FPropertyPlan & FindPropertyPlan(UClass * Class, const FString &PropertyName);
+	void Empty();
+
+private:
+	TMap<FString, UClass*> ExpressionClasses;
+	TMap<UClass*, TMap<FString, FPropertyPlan> > PropertyPlans;
+};
+
 class T3DMaterialParser : public T3DParser
 {
 public:
 	T3DMaterialParser(T3DLevelParser * ParentParser, const FString &Package);
 	UMaterial * ImportMaterialT3DFile(const FString &FileName);
 
+	/** Parse the material without creating any object, can be called from worker threads */
+	bool ParseMaterialT3DFile(const FString &FileName, FT3DParsedMaterial &ParsedMaterial);
+	/** Create the material and its expressions from a parsed material, on the game thread */
+	UMaterial * BuildMaterial(const FT3DParsedMaterial &ParsedMaterial);
+	/**
+	 * Read the number of images of a FlipBook sample from the T3D export of its texture, never runs UDK
+	 * @param TexturePackage - Package of the texture, to export it when it isn't yet
+	 * @return false if the texture isn't exported
+	 */
+	bool ReadFlipBookTextureInfo(FT3DParsedMaterial::FExpressionDesc &Desc, FString &TexturePackage);
+
 private:
 	T3DLevelParser * LevelParser;
 	
 	// T3D Parsing
-	UMaterial * ImportMaterial();
+	bool ParseMaterial(FT3DParsedMaterial &ParsedMaterial);
+	void ParseMaterialExpression(FT3DParsedMaterial::FExpressionDesc &Desc);
+	void ParseMaterialExpressionFlipBookSample(FT3DParsedMaterial::FExpressionDesc &Desc);
 	UMaterial * Material;
 
-	UMaterialExpression* ImportMaterialExpression(UClass * Class, FRequirement &TextureRequirement);
+	// Objects creation
+	UMaterialExpression* ImportMaterialExpression(UClass * Class, const FT3DParsedMaterial::FExpressionDesc &Desc);
 	void ImportExpression(FExpressionInput * ExpressionInput);
-	void ImportMaterialExpressionFlipBookSample(UMaterialExpressionTextureSample * Expression, FRequirement &TextureRequirement);
+	void ImportMaterialExpressionFlipBookSample(UMaterialExpressionTextureSample * Expression, const FT3DParsedMaterial::FExpressionDesc &Desc);
 	void SetExpression(UObject * Object, FExpressionInput * ExpressionInput);
 };
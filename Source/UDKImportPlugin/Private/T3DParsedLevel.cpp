@@ -0,0 +1,321 @@
+#include "UDKImportPluginPrivatePCH.h"
+#include "T3DParsedLevel.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/LargeMemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "T3DParser.h"
+
+namespace
+{
+	const uint32 T3DBMagic = 0x42443354; // "T3DB"
+	const int32 T3DBVersion = 1;
+
+	/** Every string of the level is stored once, descriptors reference them by index */
+	class FT3DStringTable
+	{
+	public:
+		TArray<FString> Strings;
+		TMap<FString, int32> Indices;
+
+		void Serialize(FArchive &Ar, FString &String)
+		{
+			int32 Index = INDEX_NONE;
+			if (Ar.IsSaving())
+			{
+				const int32 * pIndex = Indices.Find(String);
+				Index = pIndex ? *pIndex : Indices.Add(String, Strings.Add(String));
+			}
+
+			Ar << Index;
+
+			if (Ar.IsLoading())
+			{
+				if (Strings.IsValidIndex(Index))
+				{
+					String = Strings[Index];
+				}
+				else
+				{
+					String.Empty();
+					Ar.SetError();
+				}
+			}
+		}
+
+		void Serialize(FArchive &Ar, FName &Name)
+		{
+			FString String;
+			if (Ar.IsSaving() && Name != NAME_None)
+			{
+				String = Name.ToString();
+			}
+
+			Serialize(Ar, String);
+
+			if (Ar.IsLoading())
+			{
+				Name = String.IsEmpty() ? NAME_None : FName(*String);
+			}
+		}
+	};
+
+	/** Vectors are stored in single precision whatever the engine uses */
+	void SerializeVector(FArchive &Ar, FVector &Vector)
+	{
+		float X = Vector.X, Y = Vector.Y, Z = Vector.Z;
+		Ar << X << Y << Z;
+		Vector = FVector(X, Y, Z);
+	}
+
+	void SerializeRotator(FArchive &Ar, FRotator &Rotator)
+	{
+		float Pitch = Rotator.Pitch, Yaw = Rotator.Yaw, Roll = Rotator.Roll;
+		Ar << Pitch << Yaw << Roll;
+		Rotator = FRotator(Pitch, Yaw, Roll);
+	}
+
+	template<typename T>
+	void SerializeArray(FArchive &Ar, FT3DStringTable &StringTable, TArray<T> &Array, void (*SerializeElement)(FArchive &, FT3DStringTable &, T &))
+	{
+		int32 Num = Array.Num();
+		Ar << Num;
+		if (Ar.IsLoading())
+		{
+			// Don't trust a count that can't fit in what remains of the cache
+			if (Num < 0 || Num > Ar.TotalSize() - Ar.Tell())
+			{
+				Ar.SetError();
+				return;
+			}
+			Array.SetNum(Num);
+		}
+
+		for (int32 Index = 0; Index < Num && !Ar.IsError(); ++Index)
+		{
+			SerializeElement(Ar, StringTable, Array[Index]);
+		}
+	}
+
+	void SerializeString(FArchive &Ar, FT3DStringTable &StringTable, FString &String)
+	{
+		StringTable.Serialize(Ar, String);
+	}
+
+	/** Strings of the table itself, their length is checked against what remains of the cache before reading them */
+	void SerializeTableString(FArchive &Ar, FT3DStringTable &StringTable, FString &String)
+	{
+		if (Ar.IsLoading())
+		{
+			const int64 Start = Ar.Tell();
+			int32 SaveNum = 0;
+			Ar << SaveNum;
+			// A negative length is a count of UTF-16 characters
+			const int64 Size = SaveNum < 0 ? -(int64)SaveNum * (int64)sizeof(UTF16CHAR) : (int64)SaveNum;
+			if (Ar.IsError() || Size > Ar.TotalSize() - Ar.Tell())
+			{
+				Ar.SetError();
+				return;
+			}
+			Ar.Seek(Start);
+		}
+		Ar << String;
+	}
+
+	void SerializeVertex(FArchive &Ar, FT3DStringTable &StringTable, FVector &Vertex)
+	{
+		SerializeVector(Ar, Vertex);
+	}
+
+	void SerializeStaticMeshActor(FArchive &Ar, FT3DStringTable &StringTable, FT3DParsedLevel::FStaticMeshActorDesc &Desc)
+	{
+		StringTable.Serialize(Ar, Desc.StaticMeshUrl);
+		SerializeArray(Ar, StringTable, Desc.MaterialUrls, &SerializeString);
+		StringTable.Serialize(Ar, Desc.CollisionType);
+		Ar << Desc.bBlockRigidBody;
+		SerializeVector(Ar, Desc.Location);
+		SerializeRotator(Ar, Desc.Rotation);
+		SerializeVector(Ar, Desc.Scale3D);
+		StringTable.Serialize(Ar, Desc.Layer);
+	}
+
+	void SerializePoly(FArchive &Ar, FT3DStringTable &StringTable, FT3DParsedLevel::FPolyDesc &Desc)
+	{
+		StringTable.Serialize(Ar, Desc.MaterialUrl);
+		SerializeVector(Ar, Desc.Base);
+		SerializeVector(Ar, Desc.Normal);
+		SerializeVector(Ar, Desc.TextureU);
+		SerializeVector(Ar, Desc.TextureV);
+		SerializeArray(Ar, StringTable, Desc.Vertices, &SerializeVertex);
+		Ar << Desc.iLink;
+		Ar << Desc.PolyFlags;
+	}
+
+	void SerializeBrush(FArchive &Ar, FT3DStringTable &StringTable, FT3DParsedLevel::FBrushDesc &Desc)
+	{
+		Ar << Desc.bSubtract;
+		SerializeVector(Ar, Desc.Location);
+		StringTable.Serialize(Ar, Desc.Layer);
+		SerializeArray(Ar, StringTable, Desc.Polys, &SerializePoly);
+	}
+
+	void SerializeLight(FArchive &Ar, FT3DStringTable &StringTable, FT3DParsedLevel::FLightDesc &Desc)
+	{
+		Ar << Desc.bSpotLight;
+		SerializeVector(Ar, Desc.Location);
+		SerializeRotator(Ar, Desc.Rotation);
+		StringTable.Serialize(Ar, Desc.Layer);
+		Ar << Desc.Properties;
+		Ar << Desc.Radius << Desc.Brightness << Desc.InnerConeAngle << Desc.OuterConeAngle;
+		Ar << Desc.LightColor;
+	}
+
+	void SerializeActorBlock(FArchive &Ar, FT3DStringTable &StringTable, FT3DParsedLevel::FActorBlock &Block)
+	{
+		StringTable.Serialize(Ar, Block.Class);
+		StringTable.Serialize(Ar, Block.Name);
+		Ar << Block.Hash;
+		Ar << Block.BrushOrder;
+		Ar << Block.Type;
+		Ar << Block.DescIndex;
+	}
+
+	void SerializeLevel(FArchive &Ar, FT3DStringTable &StringTable, FT3DParsedLevel &Level)
+	{
+		SerializeArray(Ar, StringTable, Level.Blocks, &SerializeActorBlock);
+		SerializeArray(Ar, StringTable, Level.StaticMeshActors, &SerializeStaticMeshActor);
+		SerializeArray(Ar, StringTable, Level.Brushes, &SerializeBrush);
+		SerializeArray(Ar, StringTable, Level.Lights, &SerializeLight);
+	}
+
+	/** @return true if every block references an existing descriptor */
+	bool HasValidDescIndices(const FT3DParsedLevel &Level)
+	{
+		for (const FT3DParsedLevel::FActorBlock &Block : Level.Blocks)
+		{
+			switch (Block.Type)
+			{
+			case FT3DParsedLevel::FActorBlock::Unsupported:
+			case FT3DParsedLevel::FActorBlock::Rejected:
+				break;
+			case FT3DParsedLevel::FActorBlock::StaticMeshActor:
+				if (!Level.StaticMeshActors.IsValidIndex(Block.DescIndex))
+					return false;
+				break;
+			case FT3DParsedLevel::FActorBlock::Brush:
+				if (!Level.Brushes.IsValidIndex(Block.DescIndex))
+					return false;
+				break;
+			case FT3DParsedLevel::FActorBlock::Light:
+				if (!Level.Lights.IsValidIndex(Block.DescIndex))
+					return false;
+				break;
+			default:
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+bool FT3DParsedLevel::LoadCache(const FString &FileName, const FMD5Hash &ExpectedSourceHash, const FString &ExpectedFilterSignature)
+{
+	Reset();
+
+	// The cache is read in place from a mapping of the file when the platform supports it
+	IPlatformFile &PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.FileExists(*FileName))
+		return false;
+
+#if ENGINE_MAJOR_VERSION > 5 || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4)
+	FOpenMappedResult MappedResult = PlatformFile.OpenMappedEx(*FileName);
+	TUniquePtr<IMappedFileHandle> MappedFile(MappedResult.HasValue() ? MappedResult.StealValue() : nullptr);
+#else
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*FileName));
+#endif
+	TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile ? MappedFile->MapRegion() : NULL);
+
+	TArray<uint8> FileData;
+	const uint8 * Data;
+	int64 Size;
+	if (MappedRegion)
+	{
+		Data = MappedRegion->GetMappedPtr();
+		Size = MappedRegion->GetMappedSize();
+	}
+	else
+	{
+		if (!FFileHelper::LoadFileToArray(FileData, *FileName, FILEREAD_Silent))
+			return false;
+		Data = FileData.GetData();
+		Size = FileData.Num();
+	}
+
+	FLargeMemoryReader Reader(Data, Size);
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic << Version;
+	if (Reader.IsError() || Magic != T3DBMagic || Version != T3DBVersion)
+		return false;
+
+	Reader << SourceHash;
+	Reader << FilterSignature;
+	if (Reader.IsError() || SourceHash != ExpectedSourceHash || FilterSignature != ExpectedFilterSignature)
+	{
+		Reset();
+		return false;
+	}
+
+	FT3DStringTable StringTable;
+	SerializeArray(Reader, StringTable, StringTable.Strings, &SerializeTableString);
+	if (!Reader.IsError())
+	{
+		SerializeLevel(Reader, StringTable, *this);
+	}
+
+	if (Reader.IsError() || !HasValidDescIndices(*this))
+	{
+		UE_LOG(UDKImportPluginLog, Warning, TEXT("Ignoring corrupted parsed level cache : %s"), *FileName);
+		Reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool FT3DParsedLevel::SaveCache(const FString &FileName) const
+{
+	// The string table is only complete once the descriptors are written, they are written first
+	FT3DStringTable StringTable;
+	TArray<uint8> Body;
+	{
+		FMemoryWriter BodyWriter(Body);
+		SerializeLevel(BodyWriter, StringTable, const_cast<FT3DParsedLevel&>(*this));
+	}
+
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	uint32 Magic = T3DBMagic;
+	int32 Version = T3DBVersion;
+	FMD5Hash Hash = SourceHash;
+	FString Signature = FilterSignature;
+	Writer << Magic << Version;
+	Writer << Hash;
+	Writer << Signature;
+	Writer << StringTable.Strings;
+	Writer.Serialize(Body.GetData(), Body.Num());
+
+	return FFileHelper::SaveArrayToFile(Data, *FileName);
+}
+
+void FT3DParsedLevel::Reset()
+{
+	Blocks.Empty();
+	StaticMeshActors.Empty();
+	Brushes.Empty();
+	Lights.Empty();
+	SourceHash = FMD5Hash();
+	FilterSignature.Empty();
+}
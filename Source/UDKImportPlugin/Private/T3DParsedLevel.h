@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Misc/SecureHash.h"
+
+/**
+ * Result of parsing the T3D export of a UDK level, independent of the world it gets imported into.
+ * Holds one entry per top-level actor block and the descriptors of the supported actors that
+ * passed the import filter.
+ * It can be saved to a compact binary cache (.t3db) keyed on the hash of the T3D export, so that
+ * importing an unchanged level again, or into another project, skips the text parse.
+ */
+class FT3DParsedLevel
+{
+public:
+	struct FStaticMeshActorDesc
+	{
+		FString StaticMeshUrl;
+		TArray<FString> MaterialUrls;
+		FString CollisionType;
+		bool bBlockRigidBody;
+		FVector Location;
+		FRotator Rotation;
+		FVector Scale3D;
+		FName Layer;
+	};
+
+	/** Finalized brush polygon */
+	struct FPolyDesc
+	{
+		/** Material url as found in the T3D, without its "Material'...'" wrapper */
+		FString MaterialUrl;
+		FVector Base, Normal, TextureU, TextureV;
+		TArray<FVector> Vertices;
+		int32 iLink;
+		uint32 PolyFlags;
+	};
+
+	struct FBrushDesc
+	{
+		bool bSubtract;
+		FVector Location;
+		FName Layer;
+		TArray<FPolyDesc> Polys;
+	};
+
+	struct FLightDesc
+	{
+		/** Light component properties found in the T3D, the others keep the engine defaults */
+		enum EProperty
+		{
+			Radius = 1,
+			Brightness = 2,
+			LightColor = 4,
+			InnerConeAngle = 8,
+			OuterConeAngle = 16
+		};
+
+		bool bSpotLight;
+		FVector Location;
+		FRotator Rotation;
+		FName Layer;
+		uint32 Properties;
+		float Radius, Brightness, InnerConeAngle, OuterConeAngle;
+		FColor LightColor;
+	};
+
+	struct FActorBlock
+	{
+		enum EType
+		{
+			/** Class not handled by the importer */
+			Unsupported,
+			/** Rejected by the import filter, not parsed */
+			Rejected,
+			StaticMeshActor,
+			Brush,
+			Light
+		};
+
+		FString Class, Name;
+		/** CRC of the block lines, see T3DParser::FObjectBlock */
+		uint32 Hash;
+		/** Position amongst every brush block of the level, 0 for other classes */
+		int32 BrushOrder;
+		uint8 Type;
+		/** Index of the descriptor in the array matching Type */
+		int32 DescIndex;
+	};
+
+	TArray<FActorBlock> Blocks;
+	TArray<FStaticMeshActorDesc> StaticMeshActors;
+	TArray<FBrushDesc> Brushes;
+	TArray<FLightDesc> Lights;
+
+	/** Hash of the T3D file the level was parsed from */
+	FMD5Hash SourceHash;
+	/** Import filter the level was parsed with, see FUDKImportFilter::GetSignature */
+	FString FilterSignature;
+
+	/** Load the cache saved in FileName, fails if it was not parsed from the same T3D file with the same filter */
+	bool LoadCache(const FString &FileName, const FMD5Hash &ExpectedSourceHash, const FString &ExpectedFilterSignature);
+	bool SaveCache(const FString &FileName) const;
+
+	void Reset();
+};
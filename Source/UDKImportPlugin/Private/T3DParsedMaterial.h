@@ -0,0 +1,32 @@
+#pragma once
+
+/**
+ * Result of parsing the T3D export of a UDK material, without any UObject or reflection lookup so that
+ * materials can be parsed on worker threads. Expression classes and properties are only resolved when
+ * the material is built on the game thread, see T3DMaterialParser::BuildMaterial.
+ */
+class FT3DParsedMaterial
+{
+public:
+	struct FPropertyDesc
+	{
+		FString Name, Value;
+		/** Whole line of the property, expression inputs are parsed from it */
+		FString Line;
+	};
+
+	struct FExpressionDesc
+	{
+		FString ClassName, Name;
+		/** Url of the texture of texture expressions, empty for the others */
+		FString TextureUrl;
+		TArray<FPropertyDesc> Properties;
+		/** Images of the texture of FlipBook samples, read from its export, 0 when unknown */
+		float FlipBookHorizontalImages, FlipBookVerticalImages;
+	};
+
+	FString Name;
+	TArray<FExpressionDesc> Expressions;
+	/** Properties of the material itself, including its inputs */
+	TArray<FPropertyDesc> Properties;
+};
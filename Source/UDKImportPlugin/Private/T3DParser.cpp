@@ -1,16 +1,64 @@
 #include "UDKImportPluginPrivatePCH.h"
 #include "T3DParser.h"
 #include "Layers/ILayers.h"
+#include "UDKBulkImportScope.h"
+#include "UDKImportPluginSettings.h"
+#include "UDKImportProfiler.h"
 
 DEFINE_LOG_CATEGORY(UDKImportPluginLog);
 
 float T3DParser::UnrRotToDeg = 0.00549316540360483;
 float T3DParser::IntensityMultiplier = 5000;
 
-T3DParser::T3DParser(const FString &UdkPath, const FString &TmpPath)
+T3DParser::T3DParser(const FString &UdkPath, const FString &TmpPath, const UUDKImportPluginSettings * Settings)
 {
 	this->UdkPath = UdkPath;
 	this->TmpPath = TmpPath;
+	// An executable override lets the exports run without UDK, such as on build machines with Tools/MockUDK
+	this->UDKExecutable = Settings->UDKExecutablePath.FilePath.IsEmpty() ? UdkPath / TEXT("Binaries/Win32/UDK.com") : Settings->UDKExecutablePath.FilePath;
+	this->UDKArguments = Settings->UDKExecutableArguments;
+	this->FBXConverter = Settings->FBXConverterPath.FilePath;
+	this->FBXConverterArguments = Settings->FBXConverterArguments;
+	this->StatusNumerator = 0;
+	this->StatusDenominator = 1;
+	this->ProgressReporter = NULL;
+}
+
+void T3DParser::SetProgressReporter(FUDKImportProgressReporter * ProgressReporter)
+{
+	this->ProgressReporter = ProgressReporter;
+}
+
+void T3DParser::UpdateStatus(const FText &Message)
+{
+	// Stages running concurrently may report at the same time
+	FPlatformAtomics::InterlockedIncrement(&StatusNumerator);
+	if (ProgressReporter)
+	{
+		ProgressReporter->UpdateProgress(Message, FMath::Clamp((float)StatusNumerator / StatusDenominator, 0.0f, 1.0f));
+	}
+	else if (IsInGameThread())
+	{
+		GWarn->StatusUpdate(StatusNumerator, StatusDenominator, Message);
+	}
+}
+
+void T3DParser::UpdateStepProgress(const FText &Message, float StepProgress)
+{
+	const float Progress = (StatusNumerator - 1 + FMath::Clamp(StepProgress, 0.0f, 1.0f)) / StatusDenominator;
+	if (ProgressReporter)
+	{
+		ProgressReporter->UpdateProgress(Message, FMath::Clamp(Progress, 0.0f, 1.0f));
+	}
+	else if (IsInGameThread())
+	{
+		GWarn->StatusUpdate(FMath::RoundToInt(Progress * 1000.0f), 1000, Message);
+	}
+}
+
+bool T3DParser::IsCancelled() const
+{
+	return ProgressReporter && ProgressReporter->IsCancelled();
 }
 
 inline bool IsWhitespace(TCHAR c) 
@@ -22,30 +70,19 @@ void T3DParser::ResetParser(const FString &Content)
 {
 	LineIndex = 0;
 	ParserLevel = 0;
-	Content.ParseIntoArray(&Lines, TEXT("\n"), true);
+	TSharedPtr<TArray<FString>, ESPMode::ThreadSafe> NewLines = MakeShareable(new TArray<FString>());
+	T3DCore::ForEachLine(ToRange(Content), [&NewLines](const FT3DRange &ContentLine)
+	{
+		NewLines->Add(ToString(ContentLine));
+	});
+	Lines = NewLines;
 }
 
 bool T3DParser::NextLine()
 {
-	if (LineIndex < Lines.Num())
+	if (Lines.IsValid() && LineIndex < Lines->Num())
 	{
-		int32 Start, End;
-		const FString &String = Lines[LineIndex];
-		Start = 0;
-		End = String.Len();
-
-		// Trimming
-		while (Start < End && IsWhitespace(String[Start]))
-		{
-			++Start;
-		}
-
-		while (End > Start && IsWhitespace(String[End-1]))
-		{
-			--End;
-		}
-
-		Line = String.Mid(Start, End - Start);
+		Line = ToString(T3DCore::Trim(ToRange((*Lines)[LineIndex])));
 		++LineIndex;
 		return true;
 	}
@@ -94,6 +131,88 @@ void T3DParser::JumpToEnd()
 	}
 }
 
+bool T3DParser::ScanObjectBlock(FObjectBlock &Block)
+{
+	// The current line is the "Begin Object" one, only the lines of the object itself are looked at
+	GetOneValueAfter(TEXT(" Class="), Block.Class);
+	GetOneValueAfter(TEXT(" Name="), Block.Name);
+	Block.Layer = NAME_None;
+	Block.Location = FVector::ZeroVector;
+	Block.BeginLine = LineIndex - 1;
+	Block.Hash = FCrc::StrCrc32(*Line);
+
+	int32 Level = 1;
+	for (int32 Index = LineIndex; Index < Lines->Num(); ++Index)
+	{
+		const TCHAR * Str = *(*Lines)[Index];
+		Block.Hash = FCrc::StrCrc32(Str, Block.Hash);
+		while (IsWhitespace(*Str))
+		{
+			++Str;
+		}
+
+		if (FCString::Strncmp(Str, TEXT("Begin "), 6) == 0)
+		{
+			++Level;
+		}
+		else if (FCString::Strncmp(Str, TEXT("End "), 4) == 0)
+		{
+			if (--Level == 0)
+			{
+				Block.EndLine = Index + 1;
+				return true;
+			}
+		}
+		else if (Level == 1)
+		{
+			if (FCString::Strncmp(Str, TEXT("Location="), 9) == 0)
+			{
+				Block.Location.InitFromString(Str + 9);
+			}
+			else if (FCString::Strncmp(Str, TEXT("Layer="), 6) == 0)
+			{
+				Block.Layer = FName(*FString(Str + 6).TrimEnd());
+			}
+		}
+	}
+
+	Block.EndLine = Lines->Num();
+	return false;
+}
+
+bool T3DParser::DelimitObjectBlock(FObjectBlock &Block)
+{
+	GetOneValueAfter(TEXT(" Class="), Block.Class);
+	GetOneValueAfter(TEXT(" Name="), Block.Name);
+	Block.Layer = NAME_None;
+	Block.Location = FVector::ZeroVector;
+	Block.BeginLine = LineIndex - 1;
+	Block.Hash = 0;
+
+	int32 Level = 1;
+	for (int32 Index = LineIndex; Index < Lines->Num(); ++Index)
+	{
+		const TCHAR * Str = *(*Lines)[Index];
+		while (IsWhitespace(*Str))
+		{
+			++Str;
+		}
+
+		if (FCString::Strncmp(Str, TEXT("Begin "), 6) == 0)
+		{
+			++Level;
+		}
+		else if (FCString::Strncmp(Str, TEXT("End "), 4) == 0 && --Level == 0)
+		{
+			Block.EndLine = Index + 1;
+			return true;
+		}
+	}
+
+	Block.EndLine = Lines->Num();
+	return false;
+}
+
 bool T3DParser::IsBeginObject(FString &Class)
 {
 	if (Line.StartsWith(TEXT("Begin Object "), ESearchCase::CaseSensitive))
@@ -111,48 +230,10 @@ bool T3DParser::IsEndObject()
 
 bool T3DParser::GetOneValueAfter(const FString &Key, FString &Value, int32 maxindex)
 {
-	int32 start = Line.Find(Key, ESearchCase::CaseSensitive, ESearchDir::FromStart, 0);
-	if (start != -1 && start <= maxindex)
+	FT3DRange ValueRange;
+	if (T3DCore::FindValueAfter(ToRange(Line), ToRange(Key), maxindex, ValueRange))
 	{
-		start += Key.Len();
-
-		const TCHAR * Buffer = *Line + start;
-		if (*Buffer == TCHAR('"'))
-		{
-			++start;
-			++Buffer;
-			bool Escaping = false;
-			while (*Buffer && (*Buffer != TCHAR('"') || Escaping))
-			{
-				if (Escaping)
-					Escaping = false;
-				else if (*Buffer == TCHAR('\\'))
-					Escaping = true;
-				++Buffer;
-			}
-		}
-		else if(*Buffer == TCHAR('('))
-		{
-			++Buffer;
-			int Level = 1;
-			while (*Buffer && Level != 0)
-			{
-				if (*Buffer == TCHAR('('))
-					++Level;
-				else if (*Buffer == TCHAR(')'))
-					--Level;
-				++Buffer;
-			}
-		}
-		else
-		{
-			while (*Buffer && *Buffer != TCHAR(' ') && *Buffer != TCHAR(',') && *Buffer != TCHAR(')'))
-			{
-				++Buffer;
-			}
-		}
-		Value = Line.Mid(start, Buffer - *Line - start);
-
+		Value = ToString(ValueRange);
 		return true;
 	}
 	return false;
@@ -171,25 +252,7 @@ void T3DParser::AddRequirement(const FString &UDKRequiredObjectName, UObjectDele
 
 void T3DParser::AddRequirement(const FRequirement &Requirement, UObjectDelegate Action)
 {
-	UObject ** pObject = FixedRequirements.Find(Requirement);
-	if (pObject != NULL)
-	{
-		Action.ExecuteIfBound(*pObject);
-	}
-	else
-	{
-		TArray<UObjectDelegate> * pActions = Requirements.Find(Requirement);
-		if (pActions != NULL)
-		{
-			pActions->Add(Action);
-		}
-		else
-		{
-			TArray<UObjectDelegate> Actions;
-			Actions.Add(Action);
-			Requirements.Add(Requirement, Actions);
-		}
-	}
+	Requirements.Add(Requirement, FRequirementAction(Action));
 }
 
 void T3DParser::FixRequirement(const FString &UDKRequiredObjectName, UObject * Object)
@@ -208,17 +271,7 @@ void T3DParser::FixRequirement(const FRequirement &Requirement, UObject * Object
 	if (Object == NULL)
 		return;
 
-	FixedRequirements.Add(FRequirement(Requirement), Object);
-
-	TArray<UObjectDelegate> * pActions = Requirements.Find(Requirement);
-	if (pActions != NULL)
-	{
-		for (auto IterActions = pActions->CreateConstIterator(); IterActions; ++IterActions)
-		{
-			IterActions->ExecuteIfBound(Object);
-		}
-		Requirements.Remove(Requirement);
-	}
+	Requirements.Fix(Requirement, Object);
 }
 
 bool T3DParser::FindRequirement(const FString &UDKRequiredObjectName, UObject * &Object)
@@ -234,7 +287,7 @@ bool T3DParser::FindRequirement(const FString &UDKRequiredObjectName, UObject *
 
 bool T3DParser::FindRequirement(const FRequirement &Requirement, UObject * &Object)
 {
-	UObject ** pObject = FixedRequirements.Find(Requirement);
+	UObject * const * pObject = Requirements.Find(Requirement);
 	if (pObject != NULL)
 	{
 		Object = *pObject;
@@ -246,11 +299,10 @@ bool T3DParser::FindRequirement(const FRequirement &Requirement, UObject * &Obje
 
 void T3DParser::PrintMissingRequirements()
 {
-	for (auto Iter = Requirements.CreateConstIterator(); Iter; ++Iter)
+	Requirements.ForEachPending([](const FRequirement &Requirement)
 	{
-		const FRequirement &Requirement = Iter.Key();
 		UE_LOG(UDKImportPluginLog, Warning, TEXT("Missing requirements : %s"), *Requirement.Url);
-	}
+	});
 }
 
 bool T3DParser::ParseUDKRotation(const FString &InSourceString, FRotator &Rotator)
@@ -271,96 +323,162 @@ bool T3DParser::ParseUDKRotation(const FString &InSourceString, FRotator &Rotato
 
 bool T3DParser::ParseFVector(const TCHAR* Stream, FVector& Value)
 {
-	Value = FVector::ZeroVector;
+	double Vector[3];
+	const bool bSuccess = T3DCore::ParseVector(Stream, Vector);
+	Value = FVector(Vector[0], Vector[1], Vector[2]);
+	return bSuccess;
+}
 
-	Value.X = FCString::Atof(Stream);
-	Stream = FCString::Strchr(Stream, ',');
-	if (!Stream)
+bool T3DParser::IsProperty(FString &PropertyName, FString &Value)
+{
+	FT3DRange NameRange, ValueRange;
+	if (T3DCore::SplitProperty(ToRange(Line), NameRange, ValueRange))
 	{
-		return false;
+		PropertyName = ToString(NameRange);
+		Value = ToString(ValueRange);
+		return true;
 	}
 
-	Stream++;
-	Value.Y = FCString::Atof(Stream);
-	Stream = FCString::Strchr(Stream, ',');
-	if (!Stream)
+	return false;
+}
+
+bool T3DParser::IsParameter(const FString &Key, int32 &index, FString &Value)
+{
+	const TCHAR* Stream = *Line;
+
+	if (FParse::Command(&Stream, *Key) && *Stream == TCHAR('('))
 	{
-		return false;
+		++Stream;
+		index = FCString::Atoi(Stream);
+		while (FChar::IsAlnum(*Stream))
+		{
+			++Stream;
+		}
+		if (*Stream == TCHAR(')'))
+		{
+			++Stream;
+			if (*Stream == TCHAR('='))
+			{
+				++Stream;
+				Value = Stream;
+				return true;
+			}
+		}
 	}
 
-	Stream++;
-	Value.Z = FCString::Atof(Stream);
+	return false;
+}
 
-	return true;
+bool T3DParser::IsActorLocation(AActor * Actor)
+{
+	FVector Location;
+	if (IsActorLocation(Location))
+	{
+		Actor->SetActorLocation(Location);
+		return true;
+	}
+
+	return false;
 }
 
-bool T3DParser::IsProperty(FString &PropertyName, FString &Value)
+bool T3DParser::IsActorRotation(AActor * Actor)
 {
-	int32 Index;
-	if (Line.FindChar('=', Index) && Index > 0)
+	FRotator Rotator;
+	if (IsActorRotation(Rotator))
 	{
-		PropertyName = Line.Mid(0, Index);
-		Value = Line.Mid(Index + 1);
+		Actor->SetActorRotation(Rotator);
 		return true;
 	}
 
 	return false;
 }
 
-bool T3DParser::IsActorLocation(AActor * Actor)
+bool T3DParser::IsActorScale(AActor * Actor)
+{
+	FVector Scale3D = Actor->GetActorScale();
+	if (IsActorScale(Scale3D))
+	{
+		Actor->SetActorScale3D(Scale3D);
+		return true;
+	}
+
+	return false;
+}
+
+bool T3DParser::IsActorProperty(AActor * Actor)
+{
+	FName Layer;
+	if (IsActorProperty(Layer))
+	{
+		AddActorToLayer(Actor, Layer);
+		return true;
+	}
+
+	return false;
+}
+
+void T3DParser::AddActorToLayer(AActor * Actor, const FName &Layer)
+{
+	FUDKBulkImportScope * BulkImportScope = FUDKBulkImportScope::Get();
+	if (BulkImportScope)
+	{
+		BulkImportScope->AddActorToLayer(Actor, Layer);
+	}
+	else
+	{
+		GEditor->Layers->AddActorToLayer(Actor, Layer);
+	}
+}
+
+bool T3DParser::IsActorLocation(FVector &Location)
 {
 	FString Value;
 	if (GetProperty(TEXT("Location="), Value))
 	{
-		FVector Location;
 		ensure(Location.InitFromString(Value));
-		Actor->SetActorLocation(Location);
 		return true;
 	}
 
 	return false;
 }
 
-bool T3DParser::IsActorRotation(AActor * Actor)
+bool T3DParser::IsActorRotation(FRotator &Rotation)
 {
 	FString Value;
 	if (GetProperty(TEXT("Rotation="), Value))
 	{
-		FRotator Rotator;
-		ensure(ParseUDKRotation(Value, Rotator));
-		Actor->SetActorRotation(Rotator);
+		ensure(ParseUDKRotation(Value, Rotation));
 		return true;
 	}
 
 	return false;
 }
 
-bool T3DParser::IsActorScale(AActor * Actor)
+bool T3DParser::IsActorScale(FVector &Scale3D)
 {
 	FString Value;
 	if (GetProperty(TEXT("DrawScale="), Value))
 	{
-		float DrawScale = FCString::Atof(*Value);
-		Actor->SetActorScale3D(Actor->GetActorScale() * DrawScale);
+		Scale3D *= FCString::Atof(*Value);
 		return true;
 	}
 	else if (GetProperty(TEXT("DrawScale3D="), Value))
 	{
 		FVector DrawScale3D;
 		ensure(DrawScale3D.InitFromString(Value));
-		Actor->SetActorScale3D(Actor->GetActorScale() * DrawScale3D);
+		Scale3D *= DrawScale3D;
 		return true;
 	}
 
 	return false;
 }
 
-bool T3DParser::IsActorProperty(AActor * Actor)
+bool T3DParser::IsActorProperty(FName &Layer)
 {
 	FString Value;
 	if (GetProperty(TEXT("Layer="), Value))
 	{
-		GEditor->Layers->AddActorToLayer(Actor, FName(*Value));
+		Layer = FName(*Value);
 		return true;
 	}
 
@@ -375,25 +493,67 @@ int32 T3DParser::RunUDK(const FString &CommandLine)
 
 int32 T3DParser::RunUDK(const FString &CommandLine, FString &Output)
 {
-	FString StdErr;
-	int32 exitCode;
+	UDK_IMPORT_PROFILE_SCOPE(RunUDK);
+	FUDKImportProfiler::Get().AddCount(TEXT("UDKProcesses"));
+
+	void * PipeRead = NULL;
+	void * PipeWrite = NULL;
+	if (!FPlatformProcess::CreatePipe(PipeRead, PipeWrite))
+		return -1;
+
+	const FString Arguments = UDKArguments.IsEmpty() ? CommandLine : UDKArguments + TEXT(" ") + CommandLine;
+
+	FProcHandle Process = FPlatformProcess::CreateProc(*UDKExecutable, *Arguments, false, true, true, NULL, 0, NULL, PipeWrite);
+	if (!Process.IsValid())
+	{
+		FPlatformProcess::ClosePipe(PipeRead, PipeWrite);
+		return -1;
+	}
+
+	// UDK exports can take minutes, the import can be cancelled meanwhile
+	int32 ExitCode = -1;
+	bool bCancelled = false;
+	while (FPlatformProcess::IsProcRunning(Process))
+	{
+		Output += FPlatformProcess::ReadPipe(PipeRead);
+		if (IsCancelled())
+		{
+			FPlatformProcess::TerminateProc(Process, true);
+			bCancelled = true;
+			break;
+		}
+		FPlatformProcess::Sleep(0.05f);
+	}
+	Output += FPlatformProcess::ReadPipe(PipeRead);
 
-	if (FPlatformProcess::ExecProcess(*(UdkPath / TEXT("Binaries/Win32/UDK.com")), *CommandLine, &exitCode, &Output, &StdErr))
+	if (!bCancelled && !FPlatformProcess::GetProcReturnCode(Process, &ExitCode))
 	{
-		return exitCode;
+		ExitCode = -1;
 	}
 
-	return -1;
+	FPlatformProcess::CloseProc(Process);
+	FPlatformProcess::ClosePipe(PipeRead, PipeWrite);
+	return ExitCode;
 }
 
 bool T3DParser::ConvertOBJToFBX(const FString &ObjFileName, const FString &FBXFilename)
 {
-	const FString CommandLine = FString::Printf(TEXT("\"%s\" \"%s\""), *ObjFileName, *FBXFilename);
-	const FString Program = TEXT("C:\\Program Files (x86)\\Autodesk\\FBX\\FBX Converter\\2013.3\\bin\\FbxConverter.exe");
+	UDK_IMPORT_PROFILE_SCOPE(ConvertOBJToFBX);
+	if (FBXConverter.IsEmpty())
+	{
+		UE_LOG(UDKImportPluginLog, Warning, TEXT("No FBX Converter Path is set, unable to convert %s"), *ObjFileName);
+		return false;
+	}
+
+	FString CommandLine = FString::Printf(TEXT("\"%s\" \"%s\""), *ObjFileName, *FBXFilename);
+	if (!FBXConverterArguments.IsEmpty())
+	{
+		CommandLine = FBXConverterArguments + TEXT(" ") + CommandLine;
+	}
 	FString StdOut, StdErr;
 	int32 exitCode;
 
-	if (FPlatformProcess::ExecProcess(*Program, *CommandLine, &exitCode, &StdOut, &StdErr))
+	if (FPlatformProcess::ExecProcess(*FBXConverter, *CommandLine, &exitCode, &StdOut, &StdErr))
 	{
 		return exitCode == 0;
 	}
@@ -403,46 +563,22 @@ bool T3DParser::ConvertOBJToFBX(const FString &ObjFileName, const FString &FBXFi
 
 void T3DParser::ParseRessourceUrl(const FString &Url, FString &Package, FString &Name)
 {
-	int32 PackageIndex, NameIndex;
-
-	PackageIndex = Url.Find(".", ESearchCase::CaseSensitive, ESearchDir::FromStart);
-
-	if (PackageIndex == -1)
-	{
-		Package = Url;
-		Name = FString();
-	}
-	else
-	{
-		Package = Url.Mid(0, PackageIndex);
-		NameIndex = Url.Find(".", ESearchCase::CaseSensitive, ESearchDir::FromEnd);
-		Name = Url.Mid(NameIndex + 1);
-	}
+	FT3DRange PackageRange, NameRange;
+	T3DCore::SplitPackagePath(ToRange(Url), PackageRange, NameRange);
+	Package = ToString(PackageRange);
+	Name = ToString(NameRange);
 }
 
 bool T3DParser::ParseRessourceUrl(const FString &Url, FString &Type, FString &Package, FString &Name)
 {
-	int32 Index, PackageIndex, NameIndex;
-
-	if (!Url.FindChar('\'', Index) || !Url.EndsWith(TEXT("'")))
+	FT3DRange TypeRange, PackageRange, NameRange;
+	bool bHasPackage;
+	if (!T3DCore::ParseRessourceUrl(ToRange(Url), TypeRange, bHasPackage, PackageRange, NameRange))
 		return false;
 
-	Type = Url.Mid(0, Index);
-	++Index;
-	PackageIndex = Url.Find(".", ESearchCase::CaseSensitive, ESearchDir::FromStart, Index);
-
-	if (PackageIndex == -1)
-	{
-		// Package Name is the current Package
-		Package = this->Package;
-		Name = Url.Mid(Index, Url.Len() - Index - 1);
-	}
-	else
-	{
-		Package = Url.Mid(Index, PackageIndex - Index);
-		NameIndex = Url.Find(".", ESearchCase::CaseSensitive, ESearchDir::FromEnd);
-		Name = Url.Mid(NameIndex + 1, Url.Len() - NameIndex - 2);
-	}
-
+	Type = ToString(TypeRange);
+	// Package Name is the current Package when the url has none
+	Package = bHasPackage ? ToString(PackageRange) : this->Package;
+	Name = ToString(NameRange);
 	return true;
 }
@@ -1,10 +1,19 @@
 #pragma once
 
+#include "UDKImportProgressReporter.h"
+#include "T3DCore/T3DCore.h"
+#include "T3DCore/T3DRequirementGraph.h"
+
 #define LOCTEXT_NAMESPACE "UDKImportPlugin"
 
+class UUDKImportPluginSettings;
+
 DECLARE_LOG_CATEGORY_EXTERN(UDKImportPluginLog, Log, All);
 DECLARE_DELEGATE_OneParam(UObjectDelegate, UObject*);
 
+/** Range of an FString, as parsed by the engine independent T3D core */
+typedef T3DCore::TRange<TCHAR> FT3DRange;
+
 class T3DParser
 {
 public:
@@ -12,22 +21,60 @@ public:
 	{
 		FString Type, Package, Name, OriginalUrl, Url;
 	};
+
+	/** Hashes requirements for the requirement graph the same way GetTypeHash does */
+	struct FRequirementHasher
+	{
+		size_t operator()(const FRequirement &Requirement) const;
+	};
+
+	/** Action run by the requirement graph once its requirement is fixed */
+	struct FRequirementAction
+	{
+		UObjectDelegate Delegate;
+
+		explicit FRequirementAction(const UObjectDelegate &Delegate) : Delegate(Delegate) {}
+		void operator()(UObject * Object) const { Delegate.ExecuteIfBound(Object); }
+	};
+
+	typedef T3DCore::TRequirementGraph<FRequirement, FRequirementAction, UObject*, FRequirementHasher> FRequirementGraph;
+
+	/** Summary of an object block gathered without tokenizing it */
+	struct FObjectBlock
+	{
+		FString Class, Name;
+		FName Layer;
+		FVector Location;
+		/** Index of the "Begin Object" line and of the line following "End Object" */
+		int32 BeginLine, EndLine;
+		/** CRC of every line of the block */
+		uint32 Hash;
+	};
 protected:
 	static float UnrRotToDeg;
 	static float IntensityMultiplier;
 
-	T3DParser(const FString &UdkPath, const FString &TmpPath);
+	/** Settings are only read here, parsers are also created on worker threads */
+	T3DParser(const FString &UdkPath, const FString &TmpPath, const UUDKImportPluginSettings * Settings);
 
+	/// Progress
 	int32 StatusNumerator, StatusDenominator;
+	FUDKImportProgressReporter * ProgressReporter;
+	/** Move to the next import step, reported to ProgressReporter or to the slow task when there is none */
+	void UpdateStatus(const FText &Message);
+	/** Report the progress made within the current import step, from 0 to 1 */
+	void UpdateStepProgress(const FText &Message, float StepProgress);
+	bool IsCancelled() const;
 
 	/// UDK
 	FString UdkPath, TmpPath;
+	/** Programs run for the exports and conversions, with the arguments put before their command line */
+	FString UDKExecutable, UDKArguments, FBXConverter, FBXConverterArguments;
 	int32 RunUDK(const FString &CommandLine);
 	int32 RunUDK(const FString &CommandLine, FString &output);
 
 	/// Ressources requirements
-	TMap<FRequirement, TArray<UObjectDelegate> > Requirements;
-	TMap<FRequirement, UObject*> FixedRequirements;
+	FRequirementGraph Requirements;
 	bool ConvertOBJToFBX(const FString &ObjFileName, const FString &FBXFilename);
 	void AddRequirement(const FString &UDKRequiredObjectName, UObjectDelegate Action);
 	void FixRequirement(const FString &UDKRequiredObjectName, UObject * Object);
@@ -39,22 +86,34 @@ protected:
 
 	/// Line parsing
 	int32 LineIndex, ParserLevel;
-	TArray<FString> Lines;
+	/** Shared by the parsers of a same file, each one keeping its own position. Lines are only emptied by
+	 *  the parser reading them, once it no longer needs them, see T3DLevelParser::ParseBlocks */
+	TSharedPtr<TArray<FString>, ESPMode::ThreadSafe> Lines;
 	FString Line, Package;
 	void ResetParser(const FString &Content);
 	bool NextLine();
 	bool IgnoreSubs();
 	bool IgnoreSubObjects();
 	void JumpToEnd();
+	/** Find the end of the object block starting at the current line, with its class, name, layer, location and hash */
+	bool ScanObjectBlock(FObjectBlock &Block);
+	/** Only find the end of the object block starting at the current line, with its class and name */
+	bool DelimitObjectBlock(FObjectBlock &Block);
 
 	/// Line content parsing
 	bool IsBeginObject(FString &Class);
 	bool IsEndObject();
 	bool IsProperty(FString &PropertyName, FString &Value);
+	bool IsParameter(const FString &Key, int32 &index, FString &Value);
 	bool IsActorLocation(AActor * Actor);
 	bool IsActorRotation(AActor * Actor);
 	bool IsActorScale(AActor * Actor);
 	bool IsActorProperty(AActor * Actor);
+	bool IsActorLocation(FVector &Location);
+	bool IsActorRotation(FRotator &Rotation);
+	bool IsActorScale(FVector &Scale3D);
+	bool IsActorProperty(FName &Layer);
+	void AddActorToLayer(AActor * Actor, const FName &Layer);
 
 	/// Value parsing
 	bool GetOneValueAfter(const FString &Key, FString &Value, int32 maxindex = MAX_int32);
@@ -64,6 +123,14 @@ protected:
 	void ParseRessourceUrl(const FString &Url, FString &Package, FString &Name);
 	bool ParseRessourceUrl(const FString &Url, FString &Type, FString &Package, FString &Name);
 	bool ParseRessourceUrl(const FString &Url, FRequirement &Requirement);
+
+	/// T3D core adapter
+	static FT3DRange ToRange(const FString &String);
+	static FString ToString(const FT3DRange &Range);
+
+public:
+	/** Reporter notified of the import progress, and polled for cancellation between batches */
+	void SetProgressReporter(FUDKImportProgressReporter * ProgressReporter);
 };
 
 FORCEINLINE uint32 GetTypeHash(const T3DParser::FRequirement& R)
@@ -76,6 +143,11 @@ FORCEINLINE bool operator==(const T3DParser::FRequirement& A, const T3DParser::F
 	return A.Url == B.Url;
 }
 
+FORCEINLINE size_t T3DParser::FRequirementHasher::operator()(const FRequirement &Requirement) const
+{
+	return GetTypeHash(Requirement);
+}
+
 FORCEINLINE bool T3DParser::ParseRessourceUrl(const FString &Url, FRequirement &Requirement)
 {
 	Requirement.OriginalUrl = Url;
@@ -87,6 +159,16 @@ FORCEINLINE bool T3DParser::ParseRessourceUrl(const FString &Url, FRequirement &
 	return false;
 }
 
+FORCEINLINE FT3DRange T3DParser::ToRange(const FString &String)
+{
+	return FT3DRange(*String, *String + String.Len());
+}
+
+FORCEINLINE FString T3DParser::ToString(const FT3DRange &Range)
+{
+	return FString((int32)Range.Len(), Range.Begin);
+}
+
 FORCEINLINE bool T3DParser::GetProperty(const FString &Key, FString &Value)
 {
 	return GetOneValueAfter(Key, Value, 0);
@@ -0,0 +1,145 @@
+#include "UDKImportPluginPrivatePCH.h"
+#include "T3DPolyListBuffer.h"
+
+void FT3DPolyListBuffer::Reset()
+{
+	// Allocations are kept for the next block
+	Materials.Reset();
+	MaterialIndices.Reset();
+	Links.Reset();
+	bHasBase.Reset();
+	Bases.Reset();
+	Normals.Reset();
+	TextureUs.Reset();
+	TextureVs.Reset();
+	Vertices.Reset();
+	FirstVertices.Reset();
+	VertexCounts.Reset();
+}
+
+void FT3DPolyListBuffer::BeginPoly(const FString &MaterialUrl, int32 Link)
+{
+	// Consecutive polygons mostly share their material
+	int32 MaterialIndex = Materials.Num() > 0 && Materials.Last() == MaterialUrl ? Materials.Num() - 1 : Materials.Find(MaterialUrl);
+	if (MaterialIndex == INDEX_NONE)
+	{
+		MaterialIndex = Materials.Add(MaterialUrl);
+	}
+
+	MaterialIndices.Add(MaterialIndex);
+	Links.Add(Link);
+	bHasBase.Add(false);
+	Bases.Add(FVector::ZeroVector);
+	Normals.Add(FVector::ZeroVector);
+	TextureUs.Add(FVector::ZeroVector);
+	TextureVs.Add(FVector::ZeroVector);
+	FirstVertices.Add(Vertices.Num());
+	VertexCounts.Add(0);
+}
+
+void FT3DPolyListBuffer::SetBase(const FVector &Base)
+{
+	Bases.Last() = Base;
+	bHasBase.Last() = true;
+}
+
+void FT3DPolyListBuffer::SetNormal(const FVector &Normal)
+{
+	Normals.Last() = Normal;
+}
+
+void FT3DPolyListBuffer::SetTextureU(const FVector &TextureU)
+{
+	TextureUs.Last() = TextureU;
+}
+
+void FT3DPolyListBuffer::SetTextureV(const FVector &TextureV)
+{
+	TextureVs.Last() = TextureV;
+}
+
+void FT3DPolyListBuffer::AddVertex(const FVector &Vertex)
+{
+	Vertices.Add(Vertex);
+	++VertexCounts.Last();
+}
+
+bool FT3DPolyListBuffer::FinalizePoly(int32 PolyIndex)
+{
+	FVector * PolyVertices = Vertices.GetData() + FirstVertices[PolyIndex];
+	int32 &VertexCount = VertexCounts[PolyIndex];
+	if (VertexCount == 0)
+		return false;
+
+	if (!bHasBase[PolyIndex])
+	{
+		Bases[PolyIndex] = PolyVertices[0];
+	}
+
+	// FPoly::Fix, points matching the previous one are collapsed in place
+	int32 Kept = 0;
+	int32 Previous = VertexCount - 1;
+	for (int32 Index = 0; Index < VertexCount; ++Index)
+	{
+		if (!FVector::PointsAreSame(PolyVertices[Index], PolyVertices[Previous]))
+		{
+			if (Kept != Index)
+			{
+				PolyVertices[Kept] = PolyVertices[Index];
+			}
+			Previous = Kept;
+			++Kept;
+		}
+	}
+	VertexCount = Kept;
+	if (VertexCount < 3)
+		return false;
+
+	// FPoly::CalcNormal, only for the polygons exported without their normal
+	FVector &Normal = Normals[PolyIndex];
+	if (Normal.IsZero())
+	{
+		for (int32 Index = 2; Index < VertexCount; ++Index)
+		{
+			Normal += (PolyVertices[Index - 1] - PolyVertices[0]) ^ (PolyVertices[Index] - PolyVertices[0]);
+		}
+		if (Normal.SizeSquared() < (float)THRESH_ZERO_NORM_SQUARED)
+			return false;
+		Normal.Normalize();
+	}
+
+	FVector &TextureU = TextureUs[PolyIndex];
+	FVector &TextureV = TextureVs[PolyIndex];
+	if (TextureU.IsZero() && TextureV.IsZero())
+	{
+		for (int32 Index = 1; Index < VertexCount; ++Index)
+		{
+			TextureU = ((PolyVertices[0] - PolyVertices[Index]) ^ Normal).GetSafeNormal();
+			TextureV = (Normal ^ TextureU).GetSafeNormal();
+			if (TextureU.SizeSquared() != 0 && TextureV.SizeSquared() != 0)
+				break;
+		}
+	}
+
+	return true;
+}
+
+void FT3DPolyListBuffer::FinalizeTo(TArray<FT3DParsedLevel::FPolyDesc> &Polys)
+{
+	Polys.Reserve(Polys.Num() + Num());
+	for (int32 PolyIndex = 0; PolyIndex < Num(); ++PolyIndex)
+	{
+		if (!FinalizePoly(PolyIndex))
+			continue;
+
+		FT3DParsedLevel::FPolyDesc &Desc = Polys[Polys.AddDefaulted()];
+		Desc.MaterialUrl = Materials[MaterialIndices[PolyIndex]];
+		Desc.Base = Bases[PolyIndex];
+		Desc.Normal = Normals[PolyIndex];
+		Desc.TextureU = TextureUs[PolyIndex];
+		Desc.TextureV = TextureVs[PolyIndex];
+		Desc.Vertices.Append(Vertices.GetData() + FirstVertices[PolyIndex], VertexCounts[PolyIndex]);
+		Desc.iLink = Links[PolyIndex];
+		Desc.PolyFlags = PF_DefaultFlags & ~PF_NoImport;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "T3DParsedLevel.h"
+
+/**
+ * Polygons of a "Begin PolyList" block as structure of arrays, filled in a single pass over the lines of
+ * the block and finalized as a batch with the rules of FPoly::Finalize. A parser keeps one buffer for
+ * every brush it parses, so that the polygons of large BSP levels don't allocate per line or per vertex.
+ */
+class FT3DPolyListBuffer
+{
+public:
+	void Reset();
+
+	/** Start a polygon, the following Set and AddVertex calls apply to it */
+	void BeginPoly(const FString &MaterialUrl, int32 Link);
+	void SetBase(const FVector &Base);
+	void SetNormal(const FVector &Normal);
+	void SetTextureU(const FVector &TextureU);
+	void SetTextureV(const FVector &TextureV);
+	void AddVertex(const FVector &Vertex);
+
+	/** Finalize every polygon, like FPoly::Finalize, then append the valid ones to Polys */
+	void FinalizeTo(TArray<FT3DParsedLevel::FPolyDesc> &Polys);
+
+	int32 Num() const { return Links.Num(); }
+
+private:
+	/** @return false if the polygon is degenerate and FPoly::Finalize would reject it */
+	bool FinalizePoly(int32 PolyIndex);
+
+	/** Materials of the block, polygons reference them by index */
+	TArray<FString> Materials;
+	TArray<int32> MaterialIndices;
+	TArray<int32> Links;
+	TArray<uint8> bHasBase;
+	TArray<FVector> Bases, Normals, TextureUs, TextureVs;
+	/** Vertices of every polygon, one after the other */
+	TArray<FVector> Vertices;
+	TArray<int32> FirstVertices, VertexCounts;
+};
@@ -0,0 +1,469 @@
+#include "UDKImportPluginPrivatePCH.h"
+#include "UDKBrushBaker.h"
+#include "Async/ParallelFor.h"
+#include "AssetRegistryModule.h"
+#include "Engine/Polys.h"
+#include "Engine/StaticMeshActor.h"
+#include "FileHelpers.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "T3DParser.h"
+
+namespace
+{
+	/** Polygons can only be merged when they share material, plane and texture mapping */
+	struct FMergeKey
+	{
+		UMaterialInterface * Material;
+		int32 Quantized[12];
+
+		FMergeKey(const FPoly &Poly)
+		{
+			Material = Poly.Material;
+			const FVector &Normal = Poly.Normal;
+			Quantized[0] = FMath::RoundToInt(Normal.X * 1024.0f);
+			Quantized[1] = FMath::RoundToInt(Normal.Y * 1024.0f);
+			Quantized[2] = FMath::RoundToInt(Normal.Z * 1024.0f);
+			Quantized[3] = FMath::RoundToInt((Poly.Vertices[0] | Normal) * 16.0f);
+			Quantized[4] = FMath::RoundToInt(Poly.TextureU.X * 4096.0f);
+			Quantized[5] = FMath::RoundToInt(Poly.TextureU.Y * 4096.0f);
+			Quantized[6] = FMath::RoundToInt(Poly.TextureU.Z * 4096.0f);
+			Quantized[7] = FMath::RoundToInt(Poly.TextureV.X * 4096.0f);
+			Quantized[8] = FMath::RoundToInt(Poly.TextureV.Y * 4096.0f);
+			Quantized[9] = FMath::RoundToInt(Poly.TextureV.Z * 4096.0f);
+			// Texture offsets, UV = P|TextureU - Base|TextureU
+			Quantized[10] = FMath::RoundToInt((Poly.Base | Poly.TextureU) * 16.0f);
+			Quantized[11] = FMath::RoundToInt((Poly.Base | Poly.TextureV) * 16.0f);
+		}
+
+		bool operator==(const FMergeKey &Other) const
+		{
+			return Material == Other.Material && FMemory::Memcmp(Quantized, Other.Quantized, sizeof(Quantized)) == 0;
+		}
+
+		friend uint32 GetTypeHash(const FMergeKey &Key)
+		{
+			return FCrc::MemCrc32(Key.Quantized, sizeof(Key.Quantized), PointerHash(Key.Material));
+		}
+	};
+
+	const float VertexTolerance = 0.01f;
+
+	/** Directed edge between two vertices snapped to VertexTolerance, shared edges run in opposite directions */
+	struct FMergeEdge
+	{
+		FIntVector From, To;
+
+		FMergeEdge(const FVector &From, const FVector &To) : From(Snap(From)), To(Snap(To)) {}
+
+		FMergeEdge Reversed() const
+		{
+			FMergeEdge Edge = *this;
+			Swap(Edge.From, Edge.To);
+			return Edge;
+		}
+
+		static FIntVector Snap(const FVector &Vertex)
+		{
+			return FIntVector(FMath::RoundToInt(Vertex.X / VertexTolerance), FMath::RoundToInt(Vertex.Y / VertexTolerance), FMath::RoundToInt(Vertex.Z / VertexTolerance));
+		}
+
+		bool operator==(const FMergeEdge &Other) const
+		{
+			return From == Other.From && To == Other.To;
+		}
+
+		friend uint32 GetTypeHash(const FMergeEdge &Edge)
+		{
+			return HashCombine(GetTypeHash(Edge.From), GetTypeHash(Edge.To));
+		}
+	};
+
+	void AddMergeEdges(TMap<FMergeEdge, int32> &Edges, const FPoly &Poly, int32 PolyIndex)
+	{
+		for (int32 Index = 0; Index < Poly.Vertices.Num(); ++Index)
+		{
+			Edges.Add(FMergeEdge(Poly.Vertices[Index], Poly.Vertices[(Index + 1) % Poly.Vertices.Num()]), PolyIndex);
+		}
+	}
+
+	void RemoveMergeEdges(TMap<FMergeEdge, int32> &Edges, const FPoly &Poly, int32 PolyIndex)
+	{
+		for (int32 Index = 0; Index < Poly.Vertices.Num(); ++Index)
+		{
+			const FMergeEdge Edge(Poly.Vertices[Index], Poly.Vertices[(Index + 1) % Poly.Vertices.Num()]);
+			const int32 * pOwner = Edges.Find(Edge);
+			if (pOwner != NULL && *pOwner == PolyIndex)
+			{
+				Edges.Remove(Edge);
+			}
+		}
+	}
+
+	void RemoveCollinearVertices(TArray<FVector> &Vertices)
+	{
+		int32 Index = 0;
+		while (Vertices.Num() > 3 && Index < Vertices.Num())
+		{
+			const FVector &Prev = Vertices[(Index + Vertices.Num() - 1) % Vertices.Num()];
+			const FVector &Curr = Vertices[Index];
+			const FVector &Next = Vertices[(Index + 1) % Vertices.Num()];
+			const FVector In = (Curr - Prev).GetSafeNormal();
+			const FVector Out = (Next - Curr).GetSafeNormal();
+
+			if (In.IsNearlyZero() || Out.IsNearlyZero() || ((In ^ Out).SizeSquared() < KINDA_SMALL_NUMBER && (In | Out) > 0.0f))
+			{
+				Vertices.RemoveAt(Index);
+			}
+			else
+			{
+				++Index;
+			}
+		}
+	}
+
+	bool IsConvex(const TArray<FVector> &Vertices, const FVector &Normal)
+	{
+		int32 Sign = 0;
+		for (int32 Index = 0; Index < Vertices.Num(); ++Index)
+		{
+			const FVector &V0 = Vertices[Index];
+			const FVector &V1 = Vertices[(Index + 1) % Vertices.Num()];
+			const FVector &V2 = Vertices[(Index + 2) % Vertices.Num()];
+			const float Turn = ((V1 - V0) ^ (V2 - V1)) | Normal;
+			if (FMath::Abs(Turn) < KINDA_SMALL_NUMBER)
+				continue;
+
+			const int32 TurnSign = Turn > 0.0f ? 1 : -1;
+			if (Sign == 0)
+				Sign = TurnSign;
+			else if (Sign != TurnSign)
+				return false;
+		}
+		return true;
+	}
+}
+
+FUDKBrushBaker::FUDKBrushBaker(UWorld * World, const FString &PackagePath, const FString &CacheFileName, float CellSize)
+{
+	this->World = World;
+	this->PackagePath = PackagePath;
+	this->CacheFileName = CacheFileName;
+	this->CellSize = FMath::Max(CellSize, 1.0f);
+}
+
+void FUDKBrushBaker::Bake(const TArray<TWeakObjectPtr<ABrush> > &Brushes, TArray<AActor*> &OutActors)
+{
+	// Evaluate the CSG once, the baked meshes replace it afterward
+	GEditor->csgRebuild(World);
+
+	TArray<FPoly> WorldPolys;
+	GEditor->bspBuildFPolys(World->GetModel(), false, 0, &WorldPolys);
+	if (WorldPolys.Num() == 0)
+		return;
+
+	TMap<UMaterialInterface*, FString> MaterialNames;
+	TArray<FCell> Cells;
+	TMap<FIntVector, int32> CellIndices;
+	for (FPoly &Poly : WorldPolys)
+	{
+		if (Poly.Vertices.Num() < 3)
+			continue;
+
+		if (!MaterialNames.Contains(Poly.Material))
+		{
+			MaterialNames.Add(Poly.Material, Poly.Material ? Poly.Material->GetPathName() : FString());
+		}
+
+		FVector Centroid = FVector::ZeroVector;
+		for (const FVector &Vertex : Poly.Vertices)
+		{
+			Centroid += Vertex;
+		}
+		Centroid /= Poly.Vertices.Num();
+
+		const FIntVector Coord(
+			FMath::FloorToInt(Centroid.X / CellSize),
+			FMath::FloorToInt(Centroid.Y / CellSize),
+			FMath::FloorToInt(Centroid.Z / CellSize));
+
+		int32 * pCellIndex = CellIndices.Find(Coord);
+		if (pCellIndex == NULL)
+		{
+			pCellIndex = &CellIndices.Add(Coord, Cells.Num());
+			FCell &Cell = Cells[Cells.AddDefaulted()];
+			Cell.Coord = Coord;
+			Cell.Origin = (FVector(Coord.X, Coord.Y, Coord.Z) + 0.5f) * CellSize;
+			Cell.Hash = 0;
+			Cell.CachedMesh = NULL;
+		}
+		Cells[*pCellIndex].Polys.Add(MoveTemp(Poly));
+	}
+	WorldPolys.Empty();
+
+	ParallelFor(Cells.Num(), [&Cells, &MaterialNames](int32 CellIdx)
+	{
+		Cells[CellIdx].Hash = HashPolys(Cells[CellIdx].Polys, MaterialNames);
+	});
+
+	// Reuse the meshes of the cells that did not change since the previous run
+	TMap<FString, uint32> CachedHashes;
+	LoadCache(CachedHashes);
+	for (FCell &Cell : Cells)
+	{
+		const FString Name = MeshNameFor(Cell.Coord);
+		const uint32 * pHash = CachedHashes.Find(Name);
+		if (pHash != NULL && *pHash == Cell.Hash)
+		{
+			const FString ObjectPath = FString::Printf(TEXT("%s/%s.%s"), *PackagePath, *Name, *Name);
+			Cell.CachedMesh = LoadObject<UStaticMesh>(NULL, *ObjectPath, NULL, LOAD_NoWarn | LOAD_Quiet);
+		}
+	}
+
+	ParallelFor(Cells.Num(), [&Cells](int32 CellIdx)
+	{
+		FCell &Cell = Cells[CellIdx];
+		if (Cell.CachedMesh)
+			return;
+
+		MergeAndTriangulate(Cell.Polys);
+
+		// Meshes are pivoted on the center of their cell
+		for (FPoly &Poly : Cell.Polys)
+		{
+			Poly.Base -= Cell.Origin;
+			for (FVector &Vertex : Poly.Vertices)
+			{
+				Vertex -= Cell.Origin;
+			}
+		}
+	});
+
+	TArray<UPackage*> PackagesToSave;
+	for (FCell &Cell : Cells)
+	{
+		const FString Name = MeshNameFor(Cell.Coord);
+		UStaticMesh * StaticMesh = Cell.CachedMesh;
+		if (StaticMesh == NULL && Cell.Polys.Num() > 0)
+		{
+#if ENGINE_MAJOR_VERSION >= 5
+			UPackage * Package = CreatePackage(*(PackagePath / Name));
+#else
+			UPackage * Package = CreatePackage(NULL, *(PackagePath / Name));
+#endif
+			UModel * Model = NewObject<UModel>(GetTransientPackage());
+			Model->Initialize(NULL, true);
+			static_cast<TArray<FPoly>&>(Model->Polys->Element) = MoveTemp(Cell.Polys);
+
+			StaticMesh = CreateStaticMeshFromBrush(Package, FName(*Name), NULL, Model);
+			if (StaticMesh)
+			{
+				FAssetRegistryModule::AssetCreated(StaticMesh);
+				Package->MarkPackageDirty();
+				PackagesToSave.Add(Package);
+			}
+			else
+			{
+				Cell.Hash = 0;
+				UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to bake brushes of cell %s"), *Name);
+			}
+		}
+
+		if (StaticMesh)
+		{
+			AStaticMeshActor * StaticMeshActor = World->SpawnActor<AStaticMeshActor>(Cell.Origin, FRotator::ZeroRotator);
+			StaticMeshActor->GetStaticMeshComponent()->SetStaticMesh(StaticMesh);
+			StaticMeshActor->SetActorLabel(Name, false);
+			OutActors.Add(StaticMeshActor);
+		}
+	}
+
+	if (PackagesToSave.Num() > 0)
+	{
+		UEditorLoadingAndSavingUtils::SavePackages(PackagesToSave, true);
+	}
+	SaveCache(Cells);
+
+	// The baked meshes replace the brushes, rebuild the BSP without them
+	for (const TWeakObjectPtr<ABrush> &Brush : Brushes)
+	{
+		if (Brush.IsValid())
+		{
+			World->EditorDestroyActor(Brush.Get(), true);
+		}
+	}
+	GEditor->csgRebuild(World);
+	World->GetCurrentLevel()->UpdateModelComponents();
+}
+
+void FUDKBrushBaker::MergeAndTriangulate(TArray<FPoly> &Polys)
+{
+	TMap<FMergeKey, TArray<FPoly> > Groups;
+	for (FPoly &Poly : Polys)
+	{
+		Groups.FindOrAdd(FMergeKey(Poly)).Add(MoveTemp(Poly));
+	}
+	Polys.Reset();
+
+	for (auto Iter = Groups.CreateIterator(); Iter; ++Iter)
+	{
+		TArray<FPoly> &Group = Iter.Value();
+
+		// Polygons are only tried against the neighbours found through their edges. A merged polygon goes
+		// back to the worklist since its new edges may allow further merges, each merge removes a polygon.
+		TMap<FMergeEdge, int32> Edges;
+		TArray<bool> Alive;
+		Alive.Init(true, Group.Num());
+		TArray<int32> Worklist;
+		for (int32 PolyIndex = 0; PolyIndex < Group.Num(); ++PolyIndex)
+		{
+			AddMergeEdges(Edges, Group[PolyIndex], PolyIndex);
+			Worklist.Add(PolyIndex);
+		}
+
+		while (Worklist.Num() > 0)
+		{
+			const int32 A = Worklist.Pop();
+			if (!Alive[A])
+				continue;
+
+			const int32 NumA = Group[A].Vertices.Num();
+			for (int32 Index = 0; Index < NumA; ++Index)
+			{
+				const FMergeEdge Edge(Group[A].Vertices[Index], Group[A].Vertices[(Index + 1) % NumA]);
+				const int32 * pB = Edges.Find(Edge.Reversed());
+				FPoly Merged;
+				if (pB == NULL || *pB == A || !Alive[*pB] || !MergeConvexPolys(Group[A], Group[*pB], Merged))
+					continue;
+
+				const int32 B = *pB;
+				RemoveMergeEdges(Edges, Group[A], A);
+				RemoveMergeEdges(Edges, Group[B], B);
+				Alive[B] = false;
+				Group[A] = MoveTemp(Merged);
+				AddMergeEdges(Edges, Group[A], A);
+				Worklist.Add(A);
+				break;
+			}
+		}
+
+		// Merged polygons stay convex, a fan is enough
+		for (int32 PolyIndex = 0; PolyIndex < Group.Num(); ++PolyIndex)
+		{
+			if (!Alive[PolyIndex])
+				continue;
+
+			const FPoly &Poly = Group[PolyIndex];
+			for (int32 Index = 1; Index + 1 < Poly.Vertices.Num(); ++Index)
+			{
+				FPoly &Triangle = Polys[Polys.Add(Poly)];
+				Triangle.Vertices.Reset(3);
+				Triangle.Vertices.Add(Poly.Vertices[0]);
+				Triangle.Vertices.Add(Poly.Vertices[Index]);
+				Triangle.Vertices.Add(Poly.Vertices[Index + 1]);
+			}
+		}
+	}
+}
+
+bool FUDKBrushBaker::MergeConvexPolys(const FPoly &A, const FPoly &B, FPoly &Merged)
+{
+	const int32 NumA = A.Vertices.Num();
+	const int32 NumB = B.Vertices.Num();
+
+	for (int32 IndexA = 0; IndexA < NumA; ++IndexA)
+	{
+		const FVector &A0 = A.Vertices[IndexA];
+		const FVector &A1 = A.Vertices[(IndexA + 1) % NumA];
+
+		for (int32 IndexB = 0; IndexB < NumB; ++IndexB)
+		{
+			// Shared edges run in opposite directions
+			if (!A0.Equals(B.Vertices[(IndexB + 1) % NumB], VertexTolerance) || !A1.Equals(B.Vertices[IndexB], VertexTolerance))
+				continue;
+
+			Merged = A;
+			Merged.Vertices.Reset(NumA + NumB - 2);
+			for (int32 Offset = 1; Offset <= NumA; ++Offset)
+			{
+				Merged.Vertices.Add(A.Vertices[(IndexA + Offset) % NumA]);
+			}
+			for (int32 Offset = 2; Offset < NumB; ++Offset)
+			{
+				Merged.Vertices.Add(B.Vertices[(IndexB + Offset) % NumB]);
+			}
+
+			RemoveCollinearVertices(Merged.Vertices);
+			return IsConvex(Merged.Vertices, A.Normal);
+		}
+	}
+
+	return false;
+}
+
+uint32 FUDKBrushBaker::HashPolys(const TArray<FPoly> &Polys, const TMap<UMaterialInterface*, FString> &MaterialNames)
+{
+	uint32 Hash = 0;
+	for (const FPoly &Poly : Polys)
+	{
+		Hash = FCrc::StrCrc32(*MaterialNames.FindChecked(Poly.Material), Hash);
+		Hash = FCrc::MemCrc32(Poly.Vertices.GetData(), Poly.Vertices.Num() * sizeof(FVector), Hash);
+		Hash = FCrc::MemCrc32(&Poly.TextureU, sizeof(FVector), Hash);
+		Hash = FCrc::MemCrc32(&Poly.TextureV, sizeof(FVector), Hash);
+		Hash = FCrc::MemCrc32(&Poly.Base, sizeof(FVector), Hash);
+	}
+	return Hash;
+}
+
+FString FUDKBrushBaker::MeshNameFor(const FIntVector &Coord) const
+{
+	return FString::Printf(TEXT("BakedBSP_%d_%d_%d"), Coord.X, Coord.Y, Coord.Z);
+}
+
+void FUDKBrushBaker::LoadCache(TMap<FString, uint32> &CellHashes) const
+{
+	FString CacheJson;
+	if (!FFileHelper::LoadFileToString(CacheJson, *CacheFileName))
+		return;
+
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<TCHAR> > Reader = TJsonReaderFactory<TCHAR>::Create(CacheJson);
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+		return;
+
+	// Cells of another size or from another folder can't be reused
+	// CellSize went through a JSON number, it is compared with a tolerance
+	if (!FMath::IsNearlyEqual(Root->GetNumberField(TEXT("CellSize")), (double)CellSize, 0.001) || Root->GetStringField(TEXT("PackagePath")) != PackagePath)
+		return;
+
+	const TSharedPtr<FJsonObject> * Cells;
+	if (Root->TryGetObjectField(TEXT("Cells"), Cells))
+	{
+		for (auto Iter = (*Cells)->Values.CreateConstIterator(); Iter; ++Iter)
+		{
+			CellHashes.Add(Iter.Key(), (uint32)FCString::Strtoui64(*Iter.Value()->AsString(), NULL, 10));
+		}
+	}
+}
+
+void FUDKBrushBaker::SaveCache(const TArray<FCell> &Cells) const
+{
+	FString CacheJson;
+	TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR> > > Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR> >::Create(&CacheJson);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("CellSize"), CellSize);
+	Writer->WriteValue(TEXT("PackagePath"), PackagePath);
+	Writer->WriteObjectStart(TEXT("Cells"));
+	for (const FCell &Cell : Cells)
+	{
+		if (Cell.Hash != 0)
+		{
+			Writer->WriteValue(MeshNameFor(Cell.Coord), FString::Printf(TEXT("%u"), Cell.Hash));
+		}
+	}
+	Writer->WriteObjectEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	FFileHelper::SaveStringToFile(CacheJson, *CacheFileName);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ * Bakes the CSG result of imported brushes into static meshes, one per spatial cell.
+ * CSG is evaluated once, the resulting polygons are bucketed per cell, coplanar polygons sharing
+ * material and texture mapping are merged and triangulated on worker threads, and each cell
+ * becomes a StaticMeshActor. Cells whose input polygons did not change since the previous run
+ * reuse the mesh saved by that run.
+ */
+class FUDKBrushBaker
+{
+public:
+	/**
+	 * @param World - World holding the brushes
+	 * @param PackagePath - Content folder receiving the baked meshes (ex: "/Game/UDK/MyLevel/BakedBrushes")
+	 * @param CacheFileName - File used to remember the cells baked by the previous runs
+	 * @param CellSize - Size of the cells in unreal units
+	 */
+	FUDKBrushBaker(UWorld * World, const FString &PackagePath, const FString &CacheFileName, float CellSize);
+
+	/** Bake Brushes into static meshes, then remove them from the world */
+	void Bake(const TArray<TWeakObjectPtr<ABrush> > &Brushes, TArray<AActor*> &OutActors);
+
+private:
+	struct FCell
+	{
+		FIntVector Coord;
+		FVector Origin;
+		TArray<FPoly> Polys;
+		uint32 Hash;
+		UStaticMesh * CachedMesh;
+	};
+
+	/** Merge coplanar polygons sharing material and texture mapping, then triangulate them */
+	static void MergeAndTriangulate(TArray<FPoly> &Polys);
+	static bool MergeConvexPolys(const FPoly &A, const FPoly &B, FPoly &Merged);
+	static uint32 HashPolys(const TArray<FPoly> &Polys, const TMap<UMaterialInterface*, FString> &MaterialNames);
+
+	FString MeshNameFor(const FIntVector &Coord) const;
+	void LoadCache(TMap<FString, uint32> &CellHashes) const;
+	void SaveCache(const TArray<FCell> &Cells) const;
+
+	UWorld * World;
+	FString PackagePath;
+	FString CacheFileName;
+	float CellSize;
+};
@@ -0,0 +1,445 @@
+#include "UDKImportPluginPrivatePCH.h"
+#include "UDKBrushManifest.h"
+#include "Async/MappedFileHandle.h"
+#include "Engine/Brush.h"
+#include "Engine/Polys.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Model.h"
+#include "Serialization/LargeMemoryReader.h"
+
+namespace
+{
+	const uint32 UDKBrushManifestMagic = 0x4D424455; // "UDBM"
+	const int32 UDKBrushManifestVersion = 2;
+	/** JSON is written to the file by chunks of this size */
+	const int32 UDKBrushManifestFlushSize = 256 * 1024;
+
+	/** Start of the binary manifests, the offsets of the tables are only known once every brush is written */
+	struct FUDKBrushManifestHeader
+	{
+		uint32 Magic;
+		int32 Version;
+		int32 BrushCount;
+		int64 StringTableOffset;
+		int64 BrushIndexOffset;
+
+		void Serialize(FArchive &Ar)
+		{
+			Ar << Magic << Version << BrushCount << StringTableOffset << BrushIndexOffset;
+		}
+	};
+
+	/** Vectors are stored in double precision, locations of large maps don't fit in a float */
+	void SerializeBrushManifestVector(FArchive &Ar, double X, double Y, double Z)
+	{
+		Ar << X << Y << Z;
+	}
+
+	FVector ReadBrushManifestVector(FArchive &Ar)
+	{
+		double X = 0.0, Y = 0.0, Z = 0.0;
+		Ar << X << Y << Z;
+		return FVector(X, Y, Z);
+	}
+
+	/** Read a count of elements of at least ElementSize bytes each, @return false if they can't fit in what remains of the file */
+	bool ReadBrushManifestCount(FArchive &Ar, int64 ElementSize, int32 &Count)
+	{
+		Count = 0;
+		Ar << Count;
+		return !Ar.IsError() && Count >= 0 && Count <= (Ar.TotalSize() - Ar.Tell()) / ElementSize;
+	}
+
+	/** Read a string table, the length of every string is checked before it is read */
+	bool ReadBrushManifestStrings(FArchive &Ar, TArray<FString> &Strings)
+	{
+		int32 Count;
+		if (!ReadBrushManifestCount(Ar, sizeof(int32), Count))
+			return false;
+
+		Strings.SetNum(Count);
+		for (FString &String : Strings)
+		{
+			const int64 Start = Ar.Tell();
+			int32 SaveNum = 0;
+			Ar << SaveNum;
+			// A negative length is a count of UTF-16 characters
+			const int64 StringSize = SaveNum < 0 ? -(int64)SaveNum * (int64)sizeof(UTF16CHAR) : (int64)SaveNum;
+			if (Ar.IsError() || StringSize > Ar.TotalSize() - Ar.Tell())
+				return false;
+
+			Ar.Seek(Start);
+			Ar << String;
+		}
+		return !Ar.IsError();
+	}
+}
+
+FUDKBrushManifestWriter::FUDKBrushManifestWriter()
+{
+	this->Format = EFormat::Json;
+	this->BrushCount = 0;
+}
+
+FUDKBrushManifestWriter::~FUDKBrushManifestWriter()
+{
+	Close();
+}
+
+bool FUDKBrushManifestWriter::Open(const FString &FileName, EFormat Format)
+{
+	Close();
+
+	Archive.Reset(IFileManager::Get().CreateFileWriter(*FileName));
+	if (!Archive.IsValid())
+		return false;
+
+	this->Format = Format;
+	BrushCount = 0;
+	Buffer.Reset();
+	Strings.Reset();
+	StringIndices.Reset();
+	BrushOffsets.Reset();
+
+	if (Format == EFormat::Json)
+	{
+		Append("{\n\t\"GeneratedOn\": ");
+		AppendString(FDateTime::UtcNow().ToString());
+		Append(",\n\t\"Brushes\": [");
+	}
+	else
+	{
+		// Rewritten by Close
+		FUDKBrushManifestHeader Header = { UDKBrushManifestMagic, UDKBrushManifestVersion, 0, 0, 0 };
+		Header.Serialize(*Archive);
+	}
+
+	return !Archive->IsError();
+}
+
+void FUDKBrushManifestWriter::AddBrush(int32 Order, const ABrush * Brush)
+{
+	if (!Archive.IsValid() || Brush == NULL)
+		return;
+
+	if (Format == EFormat::Json)
+	{
+		AddJsonBrush(Order, Brush);
+	}
+	else
+	{
+		AddBinaryBrush(Order, Brush);
+	}
+	++BrushCount;
+}
+
+void FUDKBrushManifestWriter::AddJsonBrush(int32 Order, const ABrush * Brush)
+{
+	ANSICHAR Number[64];
+	FCStringAnsi::Snprintf(Number, sizeof(Number), "%d", Order);
+	Append(BrushCount > 0 ? ",\n\t\t{\n\t\t\t\"Order\": " : "\n\t\t{\n\t\t\t\"Order\": ");
+	Append(Number);
+	Append(",\n\t\t\t\"ActorLabel\": ");
+	AppendString(Brush->GetActorLabel());
+	Append(Brush->BrushType == Brush_Subtract ? ",\n\t\t\t\"BrushType\": \"Subtract\"" : ",\n\t\t\t\"BrushType\": \"Add\"");
+
+	const FVector Scale = Brush->GetActorScale3D();
+	FCStringAnsi::Snprintf(Number, sizeof(Number), "%.17g", (double)Scale.X);
+	Append(",\n\t\t\t\"Scale\": { \"X\": ");
+	Append(Number);
+	FCStringAnsi::Snprintf(Number, sizeof(Number), "%.17g", (double)Scale.Y);
+	Append(", \"Y\": ");
+	Append(Number);
+	FCStringAnsi::Snprintf(Number, sizeof(Number), "%.17g", (double)Scale.Z);
+	Append(", \"Z\": ");
+	Append(Number);
+
+	const FVector Location = Brush->GetActorLocation();
+	const FRotator Rotation = Brush->GetActorRotation();
+	Append(" },\n\t\t\t\"Transform\": { \"Location\": ");
+	AppendVector(Location.X, Location.Y, Location.Z);
+	Append(", \"Rotation\": ");
+	AppendVector(Rotation.Pitch, Rotation.Yaw, Rotation.Roll);
+	Append(" },\n\t\t\t\"Polys\": [");
+
+	const UModel * Model = Brush->Brush;
+	if (Model && Model->Polys)
+	{
+		const TArray<FPoly> &Polys = Model->Polys->Element;
+		for (int32 PolyIndex = 0; PolyIndex < Polys.Num(); ++PolyIndex)
+		{
+			const FPoly &Poly = Polys[PolyIndex];
+			Append(PolyIndex > 0 ? ",\n\t\t\t\t{ \"Material\": " : "\n\t\t\t\t{ \"Material\": ");
+			AppendString(Poly.Material ? Poly.Material->GetPathName() : FString());
+			Append(", \"Vertices\": [");
+			for (int32 VertexIndex = 0; VertexIndex < Poly.Vertices.Num(); ++VertexIndex)
+			{
+				Append(VertexIndex > 0 ? ", " : " ");
+				AppendVector(Poly.Vertices[VertexIndex].X, Poly.Vertices[VertexIndex].Y, Poly.Vertices[VertexIndex].Z);
+			}
+			Append(" ] }");
+		}
+		Append(Polys.Num() > 0 ? "\n\t\t\t]\n\t\t}" : "]\n\t\t}");
+	}
+	else
+	{
+		Append("]\n\t\t}");
+	}
+
+	FlushBuffer(false);
+}
+
+void FUDKBrushManifestWriter::AddBinaryBrush(int32 Order, const ABrush * Brush)
+{
+	FArchive &Ar = *Archive;
+	BrushOffsets.Add(Ar.Tell());
+
+	int32 BrushOrder = Order;
+	int32 ActorLabel = FindOrAddString(Brush->GetActorLabel());
+	uint8 bSubtract = Brush->BrushType == Brush_Subtract ? 1 : 0;
+	Ar << BrushOrder << ActorLabel << bSubtract;
+
+	const FVector Scale = Brush->GetActorScale3D();
+	const FVector Location = Brush->GetActorLocation();
+	const FRotator Rotation = Brush->GetActorRotation();
+	SerializeBrushManifestVector(Ar, Scale.X, Scale.Y, Scale.Z);
+	SerializeBrushManifestVector(Ar, Location.X, Location.Y, Location.Z);
+	SerializeBrushManifestVector(Ar, Rotation.Pitch, Rotation.Yaw, Rotation.Roll);
+
+	const UModel * Model = Brush->Brush;
+	int32 PolyCount = Model && Model->Polys ? Model->Polys->Element.Num() : 0;
+	Ar << PolyCount;
+	for (int32 PolyIndex = 0; PolyIndex < PolyCount; ++PolyIndex)
+	{
+		const FPoly &Poly = Model->Polys->Element[PolyIndex];
+		int32 Material = FindOrAddString(Poly.Material ? Poly.Material->GetPathName() : FString());
+		int32 VertexCount = Poly.Vertices.Num();
+		Ar << Material << VertexCount;
+		for (const auto &Vertex : Poly.Vertices)
+		{
+			SerializeBrushManifestVector(Ar, Vertex.X, Vertex.Y, Vertex.Z);
+		}
+	}
+}
+
+bool FUDKBrushManifestWriter::Close()
+{
+	if (!Archive.IsValid())
+		return false;
+
+	if (Format == EFormat::Json)
+	{
+		Append(BrushCount > 0 ? "\n\t]\n}\n" : "]\n}\n");
+		FlushBuffer(true);
+	}
+	else
+	{
+		FArchive &Ar = *Archive;
+		FUDKBrushManifestHeader Header = { UDKBrushManifestMagic, UDKBrushManifestVersion, BrushCount, 0, 0 };
+		Header.StringTableOffset = Ar.Tell();
+		Ar << Strings;
+		Header.BrushIndexOffset = Ar.Tell();
+		Ar << BrushOffsets;
+
+		Ar.Seek(0);
+		Header.Serialize(Ar);
+	}
+
+	const bool bSuccess = Archive->Close();
+	Archive.Reset();
+	Strings.Empty();
+	StringIndices.Empty();
+	BrushOffsets.Empty();
+	return bSuccess;
+}
+
+void FUDKBrushManifestWriter::Append(const ANSICHAR * Text)
+{
+	Buffer.Append(Text, FCStringAnsi::Strlen(Text));
+}
+
+void FUDKBrushManifestWriter::AppendString(const FString &String)
+{
+	Buffer.Add('"');
+	const FTCHARToUTF8 Utf8(*String);
+	const ANSICHAR * Text = (const ANSICHAR*)Utf8.Get();
+	for (int32 Index = 0; Index < Utf8.Length(); ++Index)
+	{
+		const ANSICHAR Char = Text[Index];
+		switch (Char)
+		{
+		case '"': Append("\\\""); break;
+		case '\\': Append("\\\\"); break;
+		case '\n': Append("\\n"); break;
+		case '\r': Append("\\r"); break;
+		case '\t': Append("\\t"); break;
+		default:
+			if ((uint8)Char < 0x20)
+			{
+				ANSICHAR Escaped[8];
+				FCStringAnsi::Snprintf(Escaped, sizeof(Escaped), "\\u%04x", (uint32)Char);
+				Append(Escaped);
+			}
+			else
+			{
+				Buffer.Add(Char);
+			}
+			break;
+		}
+	}
+	Buffer.Add('"');
+}
+
+void FUDKBrushManifestWriter::AppendVector(double X, double Y, double Z)
+{
+	// Same text as the vectors of the UDK exports, with every digit of a double
+	ANSICHAR Vector[192];
+	FCStringAnsi::Snprintf(Vector, sizeof(Vector), "\"%.17g,%.17g,%.17g\"", X, Y, Z);
+	Append(Vector);
+}
+
+void FUDKBrushManifestWriter::FlushBuffer(bool bForce)
+{
+	if (Buffer.Num() > 0 && (bForce || Buffer.Num() >= UDKBrushManifestFlushSize))
+	{
+		Archive->Serialize(Buffer.GetData(), Buffer.Num());
+		Buffer.Reset();
+	}
+}
+
+int32 FUDKBrushManifestWriter::FindOrAddString(const FString &String)
+{
+	const int32 * pIndex = StringIndices.Find(String);
+	return pIndex ? *pIndex : StringIndices.Add(String, Strings.Add(String));
+}
+
+FUDKBrushManifestReader::FUDKBrushManifestReader()
+{
+	this->Data = NULL;
+	this->Size = 0;
+}
+
+FUDKBrushManifestReader::~FUDKBrushManifestReader()
+{
+	// The region has to be released before its file
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+bool FUDKBrushManifestReader::Open(const FString &FileName)
+{
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	FileData.Empty();
+	Strings.Empty();
+	BrushOffsets.Empty();
+	Data = NULL;
+	Size = 0;
+
+	IPlatformFile &PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.FileExists(*FileName))
+		return false;
+
+#if ENGINE_MAJOR_VERSION > 5 || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4)
+	FOpenMappedResult MappedResult = PlatformFile.OpenMappedEx(*FileName);
+	MappedFile.Reset(MappedResult.HasValue() ? MappedResult.StealValue() : nullptr);
+#else
+	MappedFile.Reset(PlatformFile.OpenMapped(*FileName));
+#endif
+	MappedRegion.Reset(MappedFile ? MappedFile->MapRegion() : NULL);
+
+	if (MappedRegion)
+	{
+		Data = MappedRegion->GetMappedPtr();
+		Size = MappedRegion->GetMappedSize();
+	}
+	else
+	{
+		if (!FFileHelper::LoadFileToArray(FileData, *FileName, FILEREAD_Silent))
+			return false;
+		Data = FileData.GetData();
+		Size = FileData.Num();
+	}
+
+	FLargeMemoryReader Reader(Data, Size);
+	FUDKBrushManifestHeader Header = { 0, 0, 0, 0, 0 };
+	Header.Serialize(Reader);
+	if (Reader.IsError() || Header.Magic != UDKBrushManifestMagic || Header.Version != UDKBrushManifestVersion
+		|| Header.StringTableOffset < Reader.Tell() || Header.StringTableOffset > Size
+		|| Header.BrushIndexOffset < Header.StringTableOffset || Header.BrushIndexOffset > Size)
+		return false;
+
+	// Counts are checked against the size of the file before the tables are allocated
+	Reader.Seek(Header.StringTableOffset);
+	bool bValid = ReadBrushManifestStrings(Reader, Strings);
+	int32 BrushCount = 0;
+	if (bValid)
+	{
+		Reader.Seek(Header.BrushIndexOffset);
+		bValid = ReadBrushManifestCount(Reader, sizeof(int64), BrushCount) && BrushCount == Header.BrushCount;
+	}
+	if (bValid)
+	{
+		BrushOffsets.SetNum(BrushCount);
+		Reader.Serialize(BrushOffsets.GetData(), BrushCount * sizeof(int64));
+	}
+	if (!bValid || Reader.IsError())
+	{
+		UE_LOG(UDKImportPluginLog, Warning, TEXT("Ignoring corrupted brush manifest : %s"), *FileName);
+		Strings.Empty();
+		BrushOffsets.Empty();
+		return false;
+	}
+
+	return true;
+}
+
+int32 FUDKBrushManifestReader::GetBrushCount() const
+{
+	return BrushOffsets.Num();
+}
+
+bool FUDKBrushManifestReader::ReadBrush(int32 Index, FBrushRecord &OutBrush) const
+{
+	if (!BrushOffsets.IsValidIndex(Index) || BrushOffsets[Index] < 0 || BrushOffsets[Index] >= Size)
+		return false;
+
+	FLargeMemoryReader Reader(Data, Size);
+	Reader.Seek(BrushOffsets[Index]);
+
+	int32 ActorLabel = INDEX_NONE;
+	uint8 bSubtract = 0;
+	Reader << OutBrush.Order << ActorLabel << bSubtract;
+	OutBrush.ActorLabel = Strings.IsValidIndex(ActorLabel) ? Strings[ActorLabel] : FString();
+	OutBrush.bSubtract = bSubtract != 0;
+	OutBrush.Scale = ReadBrushManifestVector(Reader);
+	OutBrush.Location = ReadBrushManifestVector(Reader);
+	const FVector Rotation = ReadBrushManifestVector(Reader);
+	OutBrush.Rotation = FRotator(Rotation.X, Rotation.Y, Rotation.Z);
+
+	// Counts are checked against the remaining bytes, so that a corrupted file never allocates more than its size
+	int32 PolyCount = 0;
+	Reader << PolyCount;
+	if (Reader.IsError() || PolyCount < 0 || PolyCount > (Size - Reader.Tell()) / (int64)(2 * sizeof(int32)))
+		return false;
+
+	OutBrush.Polys.SetNum(PolyCount);
+	for (FPolyRecord &Poly : OutBrush.Polys)
+	{
+		int32 Material = INDEX_NONE;
+		int32 VertexCount = 0;
+		Reader << Material << VertexCount;
+		if (Reader.IsError() || VertexCount < 0 || VertexCount > (Size - Reader.Tell()) / (int64)(3 * sizeof(double)))
+			return false;
+
+		Poly.Material = Strings.IsValidIndex(Material) ? Strings[Material] : FString();
+		Poly.Vertices.Reset(VertexCount);
+		for (int32 VertexIndex = 0; VertexIndex < VertexCount; ++VertexIndex)
+		{
+			Poly.Vertices.Add(ReadBrushManifestVector(Reader));
+		}
+	}
+
+	return !Reader.IsError();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+class ABrush;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Writes the brushes of an import with their order, transform and polygons, for the tools working on
+ * the imported BSP. Brushes are streamed to the file one at a time, either as JSON or in a compact
+ * binary format read by FUDKBrushManifestReader.
+ */
+class FUDKBrushManifestWriter
+{
+public:
+	enum class EFormat
+	{
+		Json,
+		Binary
+	};
+
+	FUDKBrushManifestWriter();
+	~FUDKBrushManifestWriter();
+
+	bool Open(const FString &FileName, EFormat Format);
+	void AddBrush(int32 Order, const ABrush * Brush);
+	/** Finish the file, @return false if it could not be written entirely */
+	bool Close();
+
+private:
+	void AddJsonBrush(int32 Order, const ABrush * Brush);
+	void AddBinaryBrush(int32 Order, const ABrush * Brush);
+
+	/** JSON is formatted in Buffer, then flushed to the file once it is large enough */
+	void Append(const ANSICHAR * Text);
+	void AppendString(const FString &String);
+	void AppendVector(double X, double Y, double Z);
+	void FlushBuffer(bool bForce);
+
+	int32 FindOrAddString(const FString &String);
+
+	TUniquePtr<FArchive> Archive;
+	EFormat Format;
+	TArray<ANSICHAR> Buffer;
+	int32 BrushCount;
+
+	/// Binary format
+	TArray<FString> Strings;
+	TMap<FString, int32> StringIndices;
+	TArray<int64> BrushOffsets;
+};
+
+/**
+ * Reads the binary brush manifests of FUDKBrushManifestWriter in place from a mapping of the file,
+ * brushes are only decoded when requested.
+ */
+class FUDKBrushManifestReader
+{
+public:
+	struct FPolyRecord
+	{
+		FString Material;
+		TArray<FVector> Vertices;
+	};
+
+	struct FBrushRecord
+	{
+		int32 Order;
+		FString ActorLabel;
+		bool bSubtract;
+		FVector Scale, Location;
+		FRotator Rotation;
+		TArray<FPolyRecord> Polys;
+	};
+
+	FUDKBrushManifestReader();
+	~FUDKBrushManifestReader();
+
+	bool Open(const FString &FileName);
+	int32 GetBrushCount() const;
+	bool ReadBrush(int32 Index, FBrushRecord &OutBrush) const;
+
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	/** File content when it can't be mapped */
+	TArray<uint8> FileData;
+	const uint8 * Data;
+	int64 Size;
+
+	TArray<FString> Strings;
+	TArray<int64> BrushOffsets;
+};
@@ -0,0 +1,97 @@
+#include "UDKImportPluginPrivatePCH.h"
+#include "UDKBrushManifest.h"
+#include "Engine/Brush.h"
+#include "Engine/Polys.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Model.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FUDKBrushManifestRoundtripTest, "UDKImportPlugin.BrushManifest.BinaryRoundtrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/** Write brushes to a binary manifest, then read them back with FUDKBrushManifestReader */
+bool FUDKBrushManifestRoundtripTest::RunTest(const FString &Parameters)
+{
+	UWorld * World = UWorld::CreateWorld(EWorldType::Editor, false);
+	const FString FileName = FPaths::CreateTempFilename(*FPaths::ProjectIntermediateDir(), TEXT("BrushesManifest"), TEXT(".bin"));
+
+	// Far from the origin, so that a location stored in single precision would not read back
+	const FVector Location(1048576.125, -2097152.0625, 33.5);
+	const FVector Vertices[] = { FVector(0.0f, 0.0f, 0.0f), FVector(256.0f, 0.0f, 0.0f), FVector(256.0f, 256.0f, 0.0f) };
+
+	TArray<ABrush*> Brushes;
+	for (int32 Index = 0; Index < 2; ++Index)
+	{
+		ABrush * Brush = World->SpawnActor<ABrush>(Location, FRotator(0.0f, 90.0f * Index, 0.0f));
+		Brush->BrushType = Index == 0 ? Brush_Add : Brush_Subtract;
+		Brush->SetActorLabel(FString::Printf(TEXT("Brush%d"), Index));
+
+		UModel * Model = NewObject<UModel>(Brush);
+		Model->Initialize(Brush, true);
+		if (Model->Polys == NULL)
+		{
+			Model->Polys = NewObject<UPolys>(Model);
+		}
+		FPoly Poly;
+		Poly.Init();
+		Poly.Vertices.Append(Vertices, UE_ARRAY_COUNT(Vertices));
+		Model->Polys->Element.Add(Poly);
+		Brush->Brush = Model;
+		Brushes.Add(Brush);
+	}
+
+	FUDKBrushManifestWriter Writer;
+	TestTrue(TEXT("Manifest is opened"), Writer.Open(FileName, FUDKBrushManifestWriter::EFormat::Binary));
+	for (int32 Index = 0; Index < Brushes.Num(); ++Index)
+	{
+		Writer.AddBrush(Index + 1, Brushes[Index]);
+	}
+	TestTrue(TEXT("Manifest is written"), Writer.Close());
+
+	// The reader maps the file, it is released before the file gets truncated below
+	{
+		FUDKBrushManifestReader Reader;
+		if (TestTrue(TEXT("Manifest is read"), Reader.Open(FileName)) && TestEqual(TEXT("Brush count"), Reader.GetBrushCount(), Brushes.Num()))
+		{
+			for (int32 Index = 0; Index < Brushes.Num(); ++Index)
+			{
+				FUDKBrushManifestReader::FBrushRecord Record;
+				if (!TestTrue(TEXT("Brush is read"), Reader.ReadBrush(Index, Record)))
+					continue;
+
+				TestEqual(TEXT("Order"), Record.Order, Index + 1);
+				TestEqual(TEXT("ActorLabel"), Record.ActorLabel, Brushes[Index]->GetActorLabel());
+				TestEqual(TEXT("Subtract"), Record.bSubtract, Index != 0);
+				TestEqual(TEXT("Location"), Record.Location, Brushes[Index]->GetActorLocation());
+				TestTrue(TEXT("Rotation"), Record.Rotation.Equals(Brushes[Index]->GetActorRotation()));
+				if (TestEqual(TEXT("Poly count"), Record.Polys.Num(), 1) && TestEqual(TEXT("Vertex count"), Record.Polys[0].Vertices.Num(), (int32)UE_ARRAY_COUNT(Vertices)))
+				{
+					for (int32 VertexIndex = 0; VertexIndex < Record.Polys[0].Vertices.Num(); ++VertexIndex)
+					{
+						TestEqual(TEXT("Vertex"), Record.Polys[0].Vertices[VertexIndex], Vertices[VertexIndex]);
+					}
+				}
+			}
+		}
+	}
+
+	// A file cut in its tables is rejected without reading past its end
+	TArray<uint8> Data;
+	if (FFileHelper::LoadFileToArray(Data, *FileName) && Data.Num() > 4)
+	{
+		Data.SetNum(Data.Num() - 4);
+		FFileHelper::SaveArrayToFile(Data, *FileName);
+		FUDKBrushManifestReader Reader;
+		TestFalse(TEXT("Truncated manifest is rejected"), Reader.Open(FileName));
+	}
+
+	IFileManager::Get().Delete(*FileName);
+	World->DestroyWorld(false);
+	return true;
+}
+
+#endif
@@ -0,0 +1,99 @@
+#include "UDKImportPluginPrivatePCH.h"
+#include "UDKBulkImportScope.h"
+#include "Editor/Transactor.h"
+#include "LevelEditorViewport.h"
+#include "Layers/ILayers.h"
+
+FUDKBulkImportScope * FUDKBulkImportScope::Active = NULL;
+int32 FUDKBulkImportScope::Depth = 0;
+
+static const FText BulkImportRealtimeOverride = NSLOCTEXT("UDKImportPlugin", "BulkImportRealtimeOverride", "UDK Import");
+
+FUDKBulkImportScope::FUDKBulkImportScope()
+{
+	check(IsInGameThread());
+
+	if (Depth++ == 0)
+	{
+		Active = this;
+		Begin();
+	}
+}
+
+FUDKBulkImportScope::~FUDKBulkImportScope()
+{
+	if (--Depth == 0)
+	{
+		End();
+		Active = NULL;
+	}
+}
+
+FUDKBulkImportScope * FUDKBulkImportScope::Get()
+{
+	return Active;
+}
+
+void FUDKBulkImportScope::AddActorToLayer(AActor * Actor, const FName &Layer)
+{
+	PendingLayers.FindOrAdd(Layer).Add(Actor);
+}
+
+void FUDKBulkImportScope::Begin()
+{
+	// Imported objects are not undoable anyway, don't let Modify() fill the undo buffer
+	if (GEditor->Trans)
+	{
+		GEditor->Trans->DisableObjectSerialization();
+	}
+
+	for (FLevelEditorViewportClient * ViewportClient : GEditor->GetLevelViewportClients())
+	{
+		if (ViewportClient && ViewportClient->IsRealtime())
+		{
+			ViewportClient->AddRealtimeOverride(false, BulkImportRealtimeOverride);
+			PausedViewports.Add(ViewportClient);
+		}
+	}
+}
+
+void FUDKBulkImportScope::End()
+{
+	for (auto Iter = PendingLayers.CreateConstIterator(); Iter; ++Iter)
+	{
+		TArray<AActor*> Actors;
+		Actors.Reserve(Iter.Value().Num());
+		for (const TWeakObjectPtr<AActor> &Actor : Iter.Value())
+		{
+			if (Actor.IsValid())
+			{
+				Actors.Add(Actor.Get());
+			}
+		}
+
+		if (Actors.Num() > 0)
+		{
+			GEditor->Layers->AddActorsToLayer(Actors, Iter.Key());
+		}
+	}
+	PendingLayers.Empty();
+
+	if (GEditor->Trans)
+	{
+		GEditor->Trans->EnableObjectSerialization();
+	}
+
+	// Viewport clients may have been destroyed while importing
+	const TArray<FLevelEditorViewportClient*> &ViewportClients = GEditor->GetLevelViewportClients();
+	for (FLevelEditorViewportClient * ViewportClient : PausedViewports)
+	{
+		if (ViewportClients.Contains(ViewportClient))
+		{
+			ViewportClient->RemoveRealtimeOverride(BulkImportRealtimeOverride);
+		}
+	}
+	PausedViewports.Empty();
+
+	GEngine->BroadcastLevelActorListChanged();
+	GEditor->RedrawLevelEditingViewports(true);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+class FLevelEditorViewportClient;
+
+/**
+ * Scope wrapped around bulk imports (level parsing and requirement resolution).
+ * While the outermost scope is alive, undo recording is suspended, layer membership changes
+ * are queued and applied once per layer, and realtime viewports are paused.
+ * The outliner and viewports are refreshed once when the outermost scope ends.
+ * Scopes can be nested; only the outermost one does any work.
+ */
+class FUDKBulkImportScope
+{
+public:
+	FUDKBulkImportScope();
+	~FUDKBulkImportScope();
+
+	/** @return the outermost active scope, or NULL when no bulk import is running */
+	static FUDKBulkImportScope * Get();
+
+	/** Queue Actor to be added to Layer when the scope ends */
+	void AddActorToLayer(AActor * Actor, const FName &Layer);
+
+private:
+	FUDKBulkImportScope(const FUDKBulkImportScope &) = delete;
+	FUDKBulkImportScope & operator=(const FUDKBulkImportScope &) = delete;
+
+	void Begin();
+	void End();
+
+	/** Outermost scope and nesting depth */
+	static FUDKBulkImportScope * Active;
+	static int32 Depth;
+
+	/** Layer membership changes, grouped by layer */
+	TMap<FName, TArray<TWeakObjectPtr<AActor> > > PendingLayers;
+
+	/** Viewports that were switched out of realtime mode */
+	TArray<FLevelEditorViewportClient*> PausedViewports;
+};
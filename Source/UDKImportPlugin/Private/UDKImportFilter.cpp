@@ -0,0 +1,69 @@
+#include "UDKImportPluginPrivatePCH.h"
+#include "UDKImportFilter.h"
+#include "UDKImportPluginSettings.h"
+
+FUDKImportFilter::FUDKImportFilter(const UUDKImportPluginSettings * Settings)
+{
+	this->Settings = Settings;
+	this->bActive = !Settings->bImportStaticMeshes
+		|| !Settings->bImportLights
+		|| !Settings->bImportBrushes
+		|| Settings->ImportActorClasses.Num() > 0
+		|| Settings->ImportLayers.Num() > 0
+		|| Settings->bUseImportRegion;
+}
+
+bool FUDKImportFilter::IsActive() const
+{
+	return bActive;
+}
+
+bool FUDKImportFilter::Accept(const T3DParser::FObjectBlock &Block) const
+{
+	if (Block.Class.Equals(TEXT("StaticMeshActor")))
+	{
+		if (!Settings->bImportStaticMeshes)
+			return false;
+	}
+	else if (Block.Class.Equals(TEXT("PointLight")) || Block.Class.Equals(TEXT("SpotLight")))
+	{
+		if (!Settings->bImportLights)
+			return false;
+	}
+	else if (Block.Class.Equals(TEXT("Brush")))
+	{
+		if (!Settings->bImportBrushes)
+			return false;
+	}
+
+	if (Settings->ImportActorClasses.Num() > 0 && !Settings->ImportActorClasses.Contains(Block.Class))
+		return false;
+
+	if (Settings->ImportLayers.Num() > 0 && !Settings->ImportLayers.Contains(Block.Layer))
+		return false;
+
+	if (Settings->bUseImportRegion && !Settings->ImportRegion.IsInside(Block.Location))
+		return false;
+
+	return true;
+}
+
+FString FUDKImportFilter::GetSignature() const
+{
+	if (!bActive)
+		return FString();
+
+	TArray<FString> Layers;
+	for (const FName &Layer : Settings->ImportLayers)
+	{
+		Layers.Add(Layer.ToString());
+	}
+
+	return FString::Printf(TEXT("%d%d%d|%s|%s|%s"),
+		Settings->bImportStaticMeshes ? 1 : 0,
+		Settings->bImportLights ? 1 : 0,
+		Settings->bImportBrushes ? 1 : 0,
+		*FString::Join(Settings->ImportActorClasses, TEXT(",")),
+		*FString::Join(Layers, TEXT(",")),
+		Settings->bUseImportRegion ? *Settings->ImportRegion.ToString() : TEXT(""));
+}
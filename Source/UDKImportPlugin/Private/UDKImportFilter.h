@@ -0,0 +1,28 @@
+#pragma once
+
+#include "T3DParser.h"
+
+class UUDKImportPluginSettings;
+
+/**
+ * Decides which top-level actor blocks of a level are imported, from the asset filters of the
+ * plugin settings (actor types, classes, layers and region).
+ */
+class FUDKImportFilter
+{
+public:
+	FUDKImportFilter(const UUDKImportPluginSettings * Settings);
+
+	/** @return true when some blocks may be rejected, blocks don't need to be scanned otherwise */
+	bool IsActive() const;
+
+	/** @return true if the actor described by Block has to be imported */
+	bool Accept(const T3DParser::FObjectBlock &Block) const;
+
+	/** @return a string that changes whenever a filter setting changes, used to key parse caches */
+	FString GetSignature() const;
+
+private:
+	const UUDKImportPluginSettings * Settings;
+	bool bActive;
+};
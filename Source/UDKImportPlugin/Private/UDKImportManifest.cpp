@@ -0,0 +1,122 @@
+#include "UDKImportPluginPrivatePCH.h"
+#include "UDKImportManifest.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+bool FUDKImportManifest::FEntry::IsValid() const
+{
+	for (const TWeakObjectPtr<AActor> &Actor : Actors)
+	{
+		if (!Actor.IsValid())
+			return false;
+	}
+	return true;
+}
+
+bool FUDKImportManifest::Load(const FString &FileName, const FString &Level)
+{
+	Entries.Empty();
+
+	FString ManifestJson;
+	if (!FFileHelper::LoadFileToString(ManifestJson, *FileName))
+		return false;
+
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<TCHAR> > Reader = TJsonReaderFactory<TCHAR>::Create(ManifestJson);
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid() || Root->GetStringField(TEXT("Level")) != Level)
+		return false;
+
+	const TSharedPtr<FJsonObject> * Blocks;
+	if (!Root->TryGetObjectField(TEXT("Blocks"), Blocks))
+		return false;
+
+	for (auto Iter = (*Blocks)->Values.CreateConstIterator(); Iter; ++Iter)
+	{
+		const TSharedPtr<FJsonObject> Block = Iter.Value()->AsObject();
+		if (!Block.IsValid())
+			continue;
+
+		FEntry &Entry = Entries.Add(Iter.Key());
+		Entry.Hash = (uint32)FCString::Strtoui64(*Block->GetStringField(TEXT("Hash")), NULL, 10);
+		for (const TSharedPtr<FJsonValue> &ActorPath : Block->GetArrayField(TEXT("Actors")))
+		{
+			// Actors deleted by hand since the previous run resolve to NULL and invalidate the entry
+			Entry.Actors.Add(FindObject<AActor>(NULL, *ActorPath->AsString()));
+		}
+	}
+
+	return true;
+}
+
+void FUDKImportManifest::Save(const FString &FileName, const FString &Level) const
+{
+	FString ManifestJson;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR> > > Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR> >::Create(&ManifestJson);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("Level"), Level);
+	Writer->WriteValue(TEXT("GeneratedOn"), FDateTime::UtcNow().ToString());
+	Writer->WriteObjectStart(TEXT("Blocks"));
+	for (auto Iter = Entries.CreateConstIterator(); Iter; ++Iter)
+	{
+		const FEntry &Entry = Iter.Value();
+		Writer->WriteObjectStart(Iter.Key());
+		Writer->WriteValue(TEXT("Hash"), FString::Printf(TEXT("%u"), Entry.Hash));
+		Writer->WriteArrayStart(TEXT("Actors"));
+		for (const TWeakObjectPtr<AActor> &Actor : Entry.Actors)
+		{
+			if (Actor.IsValid())
+			{
+				Writer->WriteValue(Actor->GetPathName());
+			}
+		}
+		Writer->WriteArrayEnd();
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteObjectEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	FFileHelper::SaveStringToFile(ManifestJson, *FileName);
+}
+
+const FUDKImportManifest::FEntry * FUDKImportManifest::Find(const FString &Name) const
+{
+	return Entries.Find(Name);
+}
+
+void FUDKImportManifest::Add(const FString &Name, const FEntry &Entry)
+{
+	Entries.Add(Name, Entry);
+}
+
+void FUDKImportManifest::Add(const FString &Name, uint32 Hash, const TArray<AActor*> &Actors)
+{
+	FEntry &Entry = Entries.Add(Name);
+	Entry.Hash = Hash;
+	Entry.Actors.Append(Actors);
+}
+
+int32 FUDKImportManifest::DestroyActorsMissingFrom(const FUDKImportManifest &Other) const
+{
+	int32 Count = 0;
+	for (auto Iter = Entries.CreateConstIterator(); Iter; ++Iter)
+	{
+		if (!Other.Entries.Contains(Iter.Key()))
+		{
+			DestroyActors(Iter.Value());
+			++Count;
+		}
+	}
+	return Count;
+}
+
+void FUDKImportManifest::DestroyActors(const FEntry &Entry)
+{
+	for (const TWeakObjectPtr<AActor> &Actor : Entry.Actors)
+	{
+		if (Actor.IsValid())
+		{
+			Actor->GetWorld()->EditorDestroyActor(Actor.Get(), true);
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+/**
+ * Fingerprints of the actor blocks imported by the previous run of a level import, used to only
+ * re-import the blocks that changed in a new T3D export.
+ * Entries are keyed on the UDK object name of the block and remember the actors it produced.
+ */
+class FUDKImportManifest
+{
+public:
+	struct FEntry
+	{
+		/** CRC of the block lines */
+		uint32 Hash;
+		TArray<TWeakObjectPtr<AActor> > Actors;
+
+		/** @return true if every actor produced by the block is still in the world */
+		bool IsValid() const;
+	};
+
+	/** Load the manifest saved for Level, actors that can't be found anymore are left invalid */
+	bool Load(const FString &FileName, const FString &Level);
+	void Save(const FString &FileName, const FString &Level) const;
+
+	const FEntry * Find(const FString &Name) const;
+	void Add(const FString &Name, const FEntry &Entry);
+	void Add(const FString &Name, uint32 Hash, const TArray<AActor*> &Actors);
+
+	/** Destroy the actors of every entry that is not part of Other */
+	int32 DestroyActorsMissingFrom(const FUDKImportManifest &Other) const;
+	static void DestroyActors(const FEntry &Entry);
+
+private:
+	TMap<FString, FEntry> Entries;
+};
@@ -0,0 +1,266 @@
+#include "UDKImportPluginPrivatePCH.h"
+#include "UDKImportPipeline.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "UDKBulkImportScope.h"
+#include "UDKImportPluginSettings.h"
+
+FUDKImportPipeline::FUDKImportPipeline(const TSharedPtr<FUDKImportProgressReporter, ESPMode::ThreadSafe> &Reporter)
+{
+	this->Reporter = Reporter;
+	this->bRunning = false;
+	this->RunningStageCount = 0;
+	this->DoneStageCount = 0;
+	this->bFailed = false;
+	this->SliceDuration = GetDefault<UUDKImportPluginSettings>()->ApplyFrameBudgetMs / 1000.0;
+}
+
+FUDKImportPipeline::~FUDKImportPipeline()
+{
+}
+
+FUDKImportPipeline::FStageId FUDKImportPipeline::AddStage(EThread Thread, FStage Stage)
+{
+	return AddStage(Thread, MoveTemp(Stage), GetDefaultPrerequisites());
+}
+
+FUDKImportPipeline::FStageId FUDKImportPipeline::AddSlicedStage(FSlicedStage Stage)
+{
+	return AddSlicedStage(MoveTemp(Stage), GetDefaultPrerequisites());
+}
+
+FUDKImportPipeline::FStageId FUDKImportPipeline::AddStage(EThread Thread, FStage Stage, const TArray<FStageId> &Prerequisites)
+{
+	AddStageInfo(Thread, Prerequisites).Function = MoveTemp(Stage);
+	return GetLastStage();
+}
+
+FUDKImportPipeline::FStageId FUDKImportPipeline::AddSlicedStage(FSlicedStage Stage, const TArray<FStageId> &Prerequisites)
+{
+	AddStageInfo(EThread::GameThread, Prerequisites).SlicedFunction = MoveTemp(Stage);
+	return GetLastStage();
+}
+
+FUDKImportPipeline::FStageId FUDKImportPipeline::GetLastStage() const
+{
+	return Stages.Num() - 1;
+}
+
+TArray<FUDKImportPipeline::FStageId> FUDKImportPipeline::GetDefaultPrerequisites() const
+{
+	TArray<FStageId> Prerequisites;
+	if (Stages.Num() > 0)
+	{
+		Prerequisites.Add(GetLastStage());
+	}
+	return Prerequisites;
+}
+
+FUDKImportPipeline::FStageInfo & FUDKImportPipeline::AddStageInfo(EThread Thread, const TArray<FStageId> &Prerequisites)
+{
+	check(!bRunning);
+
+	const FStageId StageIndex = Stages.AddDefaulted();
+	FStageInfo &StageInfo = Stages[StageIndex];
+	StageInfo.Thread = Thread;
+	StageInfo.PendingPrerequisites = 0;
+
+	// Prerequisites are always added first, so the order stages are added in is a valid order to run them
+	for (FStageId Prerequisite : Prerequisites)
+	{
+		check(Prerequisite >= 0 && Prerequisite < StageIndex);
+		if (!Stages[Prerequisite].Dependents.Contains(StageIndex))
+		{
+			Stages[Prerequisite].Dependents.Add(StageIndex);
+			++StageInfo.PendingPrerequisites;
+		}
+	}
+
+	return StageInfo;
+}
+
+void FUDKImportPipeline::Start(FOnFinished InOnFinished)
+{
+	check(IsInGameThread());
+	check(!bRunning);
+
+	bRunning = true;
+	bFailed = false;
+	RunningStageCount = 0;
+	DoneStageCount = 0;
+	OnFinished = InOnFinished;
+
+	if (Stages.Num() == 0)
+	{
+		Finish(true);
+		return;
+	}
+
+	for (FStageId StageIndex = 0; StageIndex < Stages.Num(); ++StageIndex)
+	{
+		if (Stages[StageIndex].PendingPrerequisites == 0)
+		{
+			LaunchStage(StageIndex);
+		}
+	}
+}
+
+bool FUDKImportPipeline::RunSynchronously()
+{
+	check(!bRunning);
+
+	// Nothing else runs meanwhile, a single scope covers the whole import
+	TUniquePtr<FUDKBulkImportScope> BulkImportScope;
+	bRunning = true;
+	bool bSuccess = true;
+	for (FStageId StageIndex = 0; StageIndex < Stages.Num() && bSuccess; ++StageIndex)
+	{
+		const FStageInfo &Stage = Stages[StageIndex];
+		if (IsCancelled())
+		{
+			bSuccess = false;
+		}
+		else
+		{
+			if (Stage.Thread == EThread::GameThread && !BulkImportScope.IsValid())
+			{
+				BulkImportScope.Reset(new FUDKBulkImportScope());
+			}
+			if (Stage.SlicedFunction)
+			{
+				ESliceResult Result;
+				while ((Result = IsCancelled() ? ESliceResult::Failed : Stage.SlicedFunction(FPlatformTime::Seconds() + SliceDuration)) == ESliceResult::Pending)
+				{
+					// Sliced stages may be waiting for worker tasks
+					FPlatformProcess::Sleep(0.0f);
+				}
+				bSuccess = Result == ESliceResult::Done;
+			}
+			else
+			{
+				bSuccess = Stage.Function();
+			}
+		}
+	}
+
+	BulkImportScope.Reset();
+	bRunning = false;
+	return bSuccess;
+}
+
+bool FUDKImportPipeline::IsRunning() const
+{
+	return bRunning;
+}
+
+bool FUDKImportPipeline::IsCancelled() const
+{
+	return Reporter.IsValid() && Reporter->IsCancelled();
+}
+
+void FUDKImportPipeline::LaunchStage(FStageId StageIndex)
+{
+	check(IsInGameThread());
+
+	++RunningStageCount;
+
+	if (Stages[StageIndex].Thread == EThread::GameThread)
+	{
+		if (Stages[StageIndex].SlicedFunction)
+		{
+			RunSlicedStage(StageIndex);
+			return;
+		}
+
+		// Let the editor tick before the stage
+		AsyncTask(ENamedThreads::GameThread, [Self = AsShared(), StageIndex]()
+		{
+			bool bSuccess = false;
+			if (!Self->bFailed && !Self->IsCancelled())
+			{
+				FUDKBulkImportScope BulkImportScope;
+				bSuccess = Self->Stages[StageIndex].Function();
+			}
+			Self->OnStageDone(StageIndex, bSuccess);
+		});
+		return;
+	}
+
+	// Stages may block on UDK for minutes, each one gets a dedicated thread instead of holding a task graph
+	// worker, which would starve ParallelFor and the other users of the pool
+	Async(EAsyncExecution::Thread, [Self = AsShared(), StageIndex]() mutable
+	{
+		const bool bSuccess = Self->Stages[StageIndex].Function();
+
+		// The pipeline is moved to the game thread so that it is never released by the worker
+		AsyncTask(ENamedThreads::GameThread, [Self = MoveTemp(Self), StageIndex, bSuccess]()
+		{
+			Self->OnStageDone(StageIndex, bSuccess);
+		});
+	});
+}
+
+void FUDKImportPipeline::RunSlicedStage(FStageId StageIndex)
+{
+	// Tickers are called once per frame, unlike game thread tasks that are drained until none is left
+	FTickerDelegate TickSlice = FTickerDelegate::CreateLambda([Self = AsShared(), StageIndex](float DeltaTime)
+	{
+		ESliceResult Result = ESliceResult::Failed;
+		if (!Self->bFailed && !Self->IsCancelled())
+		{
+			FUDKBulkImportScope BulkImportScope;
+			Result = Self->Stages[StageIndex].SlicedFunction(FPlatformTime::Seconds() + Self->SliceDuration);
+		}
+		if (Result == ESliceResult::Pending)
+			return true;
+
+		Self->OnStageDone(StageIndex, Result == ESliceResult::Done);
+		return false;
+	});
+
+#if ENGINE_MAJOR_VERSION >= 5
+	FTSTicker::GetCoreTicker().AddTicker(TickSlice);
+#else
+	FTicker::GetCoreTicker().AddTicker(TickSlice);
+#endif
+}
+
+void FUDKImportPipeline::OnStageDone(FStageId StageIndex, bool bSuccess)
+{
+	check(IsInGameThread());
+
+	--RunningStageCount;
+	++DoneStageCount;
+	bFailed |= !bSuccess || IsCancelled();
+
+	if (!bFailed)
+	{
+		for (FStageId Dependent : Stages[StageIndex].Dependents)
+		{
+			if (--Stages[Dependent].PendingPrerequisites == 0)
+			{
+				LaunchStage(Dependent);
+			}
+		}
+	}
+
+	// A failed import waits for its running stages, they may use what the callback releases
+	if (RunningStageCount == 0 && (bFailed || DoneStageCount == Stages.Num()))
+	{
+		Finish(!bFailed);
+	}
+}
+
+void FUDKImportPipeline::Finish(bool bSuccess)
+{
+	check(IsInGameThread());
+
+	bRunning = false;
+
+	// The stages may own the objects the callback releases
+	FOnFinished Callback = OnFinished;
+	OnFinished.Unbind();
+	Stages.Empty();
+
+	Callback.ExecuteIfBound(bSuccess && !IsCancelled());
+}
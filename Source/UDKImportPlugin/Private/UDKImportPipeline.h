@@ -0,0 +1,103 @@
+#pragma once
+
+#include "UDKImportProgressReporter.h"
+
+/**
+ * Graph of import stages, each one either running on a worker thread or on the game thread.
+ * A stage starts as soon as all of its prerequisites are done, so that independent work, like texture
+ * exports and mesh conversions, overlaps. Worker stages run on a dedicated thread each, since they wait on
+ * UDK and file conversions for minutes and would starve the task graph workers; parsing within a stage
+ * may still use ParallelFor. The editor stays responsive meanwhile. Only the stages creating or modifying
+ * UObjects run on the game thread, one at a time, each one and each slice inside its own bulk import scope
+ * so that the editor is usable between them.
+ * Sliced stages create objects on the game thread a few at a time, within a per-frame budget.
+ * Cancellation requested through the progress reporter is honored between stages and slices, and long
+ * stages poll it between their batches.
+ */
+class FUDKImportPipeline : public TSharedFromThis<FUDKImportPipeline, ESPMode::ThreadSafe>
+{
+public:
+	enum class EThread : uint8
+	{
+		Worker,
+		GameThread
+	};
+
+	/** A stage returns false to abort the import */
+	typedef TFunction<bool()> FStage;
+
+	enum class ESliceResult : uint8
+	{
+		Done,
+		Pending,
+		Failed
+	};
+
+	/** A sliced stage does its work until FPlatformTime::Seconds() reaches EndTime, and returns Pending to be called again next frame */
+	typedef TFunction<ESliceResult(double EndTime)> FSlicedStage;
+
+	/** Identifies a stage in the prerequisites of the stages added after it */
+	typedef int32 FStageId;
+
+	DECLARE_DELEGATE_OneParam(FOnFinished, bool /*bSuccess*/);
+
+	FUDKImportPipeline(const TSharedPtr<FUDKImportProgressReporter, ESPMode::ThreadSafe> &Reporter = NULL);
+	~FUDKImportPipeline();
+
+	/** Add a stage depending on the stage added before it */
+	FStageId AddStage(EThread Thread, FStage Stage);
+	FStageId AddSlicedStage(FSlicedStage Stage);
+	/** Add a stage depending on Prerequisites only, which must have been added before it */
+	FStageId AddStage(EThread Thread, FStage Stage, const TArray<FStageId> &Prerequisites);
+	FStageId AddSlicedStage(FSlicedStage Stage, const TArray<FStageId> &Prerequisites);
+
+	/** @return the stage added last, INDEX_NONE if there is none */
+	FStageId GetLastStage() const;
+
+	/**
+	 * Run the stages asynchronously, must be called from the game thread.
+	 * @param OnFinished - Called on the game thread once every stage ran, or when the import failed or got cancelled
+	 */
+	void Start(FOnFinished OnFinished);
+
+	/** Run every stage on the calling thread in the order they were added, for commandlets and blocking imports */
+	bool RunSynchronously();
+
+	bool IsRunning() const;
+	bool IsCancelled() const;
+
+private:
+	struct FStageInfo
+	{
+		EThread Thread;
+		FStage Function;
+		FSlicedStage SlicedFunction;
+		/** Stages having this one as prerequisite */
+		TArray<FStageId> Dependents;
+		/** Prerequisites not done yet */
+		int32 PendingPrerequisites;
+	};
+
+	FStageInfo & AddStageInfo(EThread Thread, const TArray<FStageId> &Prerequisites);
+	TArray<FStageId> GetDefaultPrerequisites() const;
+
+	/** Schedule the stage at StageIndex, called on the game thread */
+	void LaunchStage(FStageId StageIndex);
+	/** Run one slice of the sliced stage at StageIndex per frame until it is done */
+	void RunSlicedStage(FStageId StageIndex);
+	/** Called on the game thread when a stage is done, launch the stages that were only waiting for it */
+	void OnStageDone(FStageId StageIndex, bool bSuccess);
+	void Finish(bool bSuccess);
+
+	TArray<FStageInfo> Stages;
+	TSharedPtr<FUDKImportProgressReporter, ESPMode::ThreadSafe> Reporter;
+	FOnFinished OnFinished;
+	bool bRunning;
+
+	/** Scheduling state, only accessed on the game thread */
+	int32 RunningStageCount, DoneStageCount;
+	bool bFailed;
+
+	/** Game thread time given to each slice, in seconds */
+	double SliceDuration;
+};
@@ -8,11 +8,24 @@ UUDKImportPluginSettings::UUDKImportPluginSettings()
 	, bVerboseLogging(false)
 	, bCacheExportedMeshes(true)
 	, MaxParallelImports(4)
+	, ApplyFrameBudgetMs(8.0f)
+	, MemoryBudgetMB(0)
+	, bCacheParsedLevels(true)
+	, bIncrementalReimport(false)
+	, bConsolidateStaticMeshActors(false)
+	, InstancingCellSize(0.0f)
+	, bBakeBrushesToStaticMeshes(false)
+	, BrushBakeCellSize(4096.0f)
+	, bBinaryBrushManifest(false)
+	, bLabelBrushesWithImportOrder(false)
+	, SubLevelCellSize(0.0f)
 	, bImportStaticMeshes(true)
 	, bImportMaterials(true)
 	, bImportTextures(true)
 	, bImportLights(true)
 	, bImportBrushes(true)
+	, bUseImportRegion(false)
+	, ImportRegion(ForceInit)
 	, bEnableNanite(false)
 	, bConvertToLumenMaterials(false)
 {
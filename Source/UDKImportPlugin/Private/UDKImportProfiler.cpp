@@ -0,0 +1,205 @@
+#include "UDKImportPluginPrivatePCH.h"
+#include "UDKImportProfiler.h"
+#include "Serialization/JsonSerializer.h"
+
+#if ENGINE_MAJOR_VERSION >= 5
+UE_TRACE_CHANNEL_DEFINE(UDKImportChannel);
+#endif
+
+FUDKImportProfiler::FUDKImportProfiler()
+{
+	this->BeginTime = FPlatformTime::Seconds();
+	this->PeakUsedPhysical = 0;
+	this->CacheCount = 0;
+}
+
+FUDKImportProfiler & FUDKImportProfiler::Get()
+{
+	static FUDKImportProfiler Profiler;
+	return Profiler;
+}
+
+void FUDKImportProfiler::Begin()
+{
+	FScopeLock Lock(&Mutex);
+	BeginTime = FPlatformTime::Seconds();
+	PeakUsedPhysical = 0;
+	Phases.Empty();
+	Counts.Empty();
+	Bytes.Empty();
+	// Caches stay registered, lookups may be recorded meanwhile
+	for (int32 Index = 0; Index < FPlatformAtomics::AtomicRead(&CacheCount); ++Index)
+	{
+		FPlatformAtomics::InterlockedExchange(&CacheLookups[Index].Hits, 0);
+		FPlatformAtomics::InterlockedExchange(&CacheLookups[Index].Misses, 0);
+	}
+	SlowestAssets.Empty();
+}
+
+void FUDKImportProfiler::AddPhaseTime(const TCHAR * Phase, double Seconds)
+{
+	FScopeLock Lock(&Mutex);
+	FPhase &Entry = Phases.FindOrAdd(Phase);
+	Entry.Seconds += Seconds;
+	++Entry.Calls;
+}
+
+void FUDKImportProfiler::AddCount(const TCHAR * Counter, int64 Count)
+{
+	FScopeLock Lock(&Mutex);
+	Counts.FindOrAdd(Counter) += Count;
+}
+
+void FUDKImportProfiler::AddBytes(const TCHAR * Counter, int64 Count)
+{
+	FScopeLock Lock(&Mutex);
+	Bytes.FindOrAdd(Counter) += Count;
+}
+
+void FUDKImportProfiler::AddCacheLookup(const TCHAR * Cache, bool bHit)
+{
+	FCacheLookups * Entry = FindOrAddCacheLookups(Cache);
+	if (Entry != NULL)
+	{
+		FPlatformAtomics::InterlockedIncrement(bHit ? &Entry->Hits : &Entry->Misses);
+	}
+}
+
+FUDKImportProfiler::FCacheLookups * FUDKImportProfiler::FindOrAddCacheLookups(const TCHAR * Cache)
+{
+	// There are only a few caches, registered by their first lookup, the lock is only taken then
+	const int32 Count = FPlatformAtomics::AtomicRead(&CacheCount);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		if (CacheLookups[Index].Name == Cache)
+			return &CacheLookups[Index];
+	}
+
+	FScopeLock Lock(&Mutex);
+	for (int32 Index = Count; Index < CacheCount; ++Index)
+	{
+		if (CacheLookups[Index].Name == Cache)
+			return &CacheLookups[Index];
+	}
+	if (!ensure(CacheCount < MaxCaches))
+		return NULL;
+
+	CacheLookups[CacheCount].Name = Cache;
+	FPlatformAtomics::InterlockedIncrement(&CacheCount);
+	return &CacheLookups[CacheCount - 1];
+}
+
+void FUDKImportProfiler::AddAssetTime(const FString &Asset, double Seconds)
+{
+	FScopeLock Lock(&Mutex);
+	if (SlowestAssets.Num() == MaxReportedAssets && SlowestAssets.Last().Value >= Seconds)
+		return;
+
+	int32 Index = 0;
+	while (Index < SlowestAssets.Num() && SlowestAssets[Index].Value >= Seconds)
+	{
+		++Index;
+	}
+	SlowestAssets.Insert(TPair<FString, double>(Asset, Seconds), Index);
+	if (SlowestAssets.Num() > MaxReportedAssets)
+	{
+		SlowestAssets.Pop();
+	}
+}
+
+uint64 FUDKImportProfiler::SampleMemory(const TCHAR * Phase)
+{
+	const uint64 UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+
+	FScopeLock Lock(&Mutex);
+	PeakUsedPhysical = FMath::Max(PeakUsedPhysical, UsedPhysical);
+	if (Phase != NULL)
+	{
+		FPhase &Entry = Phases.FindOrAdd(Phase);
+		Entry.PeakUsedPhysical = FMath::Max(Entry.PeakUsedPhysical, UsedPhysical);
+	}
+	return UsedPhysical;
+}
+
+bool FUDKImportProfiler::WriteReport(const FString &FileName) const
+{
+	FScopeLock Lock(&Mutex);
+
+	FString ReportJson;
+	TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR> > > Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR> >::Create(&ReportJson);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("GeneratedOn"), FDateTime::UtcNow().ToString());
+	Writer->WriteValue(TEXT("TotalSeconds"), FPlatformTime::Seconds() - BeginTime);
+	Writer->WriteValue(TEXT("PeakUsedPhysicalMB"), PeakUsedPhysical / (1024.0 * 1024.0));
+
+	// Phases may overlap, each one is the sum of the time spent in it by every thread
+	Writer->WriteObjectStart(TEXT("Phases"));
+	for (auto Iter = Phases.CreateConstIterator(); Iter; ++Iter)
+	{
+		Writer->WriteObjectStart(Iter.Key());
+		Writer->WriteValue(TEXT("Seconds"), Iter.Value().Seconds);
+		Writer->WriteValue(TEXT("Calls"), Iter.Value().Calls);
+		Writer->WriteValue(TEXT("PeakUsedPhysicalMB"), Iter.Value().PeakUsedPhysical / (1024.0 * 1024.0));
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteObjectEnd();
+
+	Writer->WriteObjectStart(TEXT("Counts"));
+	for (auto Iter = Counts.CreateConstIterator(); Iter; ++Iter)
+	{
+		Writer->WriteValue(Iter.Key(), Iter.Value());
+	}
+	Writer->WriteObjectEnd();
+
+	Writer->WriteObjectStart(TEXT("Bytes"));
+	for (auto Iter = Bytes.CreateConstIterator(); Iter; ++Iter)
+	{
+		Writer->WriteValue(Iter.Key(), Iter.Value());
+	}
+	Writer->WriteObjectEnd();
+
+	Writer->WriteObjectStart(TEXT("Caches"));
+	for (int32 Index = 0; Index < CacheCount; ++Index)
+	{
+		const int64 Hits = FPlatformAtomics::AtomicRead(&CacheLookups[Index].Hits);
+		const int64 Misses = FPlatformAtomics::AtomicRead(&CacheLookups[Index].Misses);
+		const int64 Total = Hits + Misses;
+		if (Total == 0)
+			continue;
+
+		Writer->WriteObjectStart(CacheLookups[Index].Name);
+		Writer->WriteValue(TEXT("Hits"), Hits);
+		Writer->WriteValue(TEXT("Misses"), Misses);
+		Writer->WriteValue(TEXT("HitRate"), (double)Hits / Total);
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteObjectEnd();
+
+	Writer->WriteArrayStart(TEXT("SlowestAssets"));
+	for (const TPair<FString, double> &Asset : SlowestAssets)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Asset"), Asset.Key);
+		Writer->WriteValue(TEXT("Seconds"), Asset.Value);
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	return FFileHelper::SaveStringToFile(ReportJson, *FileName);
+}
+
+FUDKImportProfiler::FScope::FScope(const TCHAR * Phase)
+{
+	this->Phase = Phase;
+	this->StartTime = FPlatformTime::Seconds();
+	FUDKImportProfiler::Get().SampleMemory(Phase);
+}
+
+FUDKImportProfiler::FScope::~FScope()
+{
+	FUDKImportProfiler::Get().SampleMemory(Phase);
+	FUDKImportProfiler::Get().AddPhaseTime(Phase, FPlatformTime::Seconds() - StartTime);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Stats/Stats.h"
+#if ENGINE_MAJOR_VERSION >= 5
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+#endif
+
+DECLARE_STATS_GROUP(TEXT("UDK Import"), STATGROUP_UDKImport, STATCAT_Advanced);
+
+#if ENGINE_MAJOR_VERSION >= 5
+UE_TRACE_CHANNEL_EXTERN(UDKImportChannel);
+#define UDK_IMPORT_TRACE_SCOPE(Phase) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(UDKImport_##Phase, UDKImportChannel)
+#else
+#define UDK_IMPORT_TRACE_SCOPE(Phase)
+#endif
+
+/**
+ * Time a phase of the import: as a cycle stat of STATGROUP_UDKImport, as an Insights event on the
+ * UDKImport trace channel (-trace=cpu,UDKImport), and in the import report.
+ */
+#define UDK_IMPORT_PROFILE_SCOPE(Phase) \
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT(#Phase), STAT_UDKImport_##Phase, STATGROUP_UDKImport); \
+	UDK_IMPORT_TRACE_SCOPE(Phase); \
+	FUDKImportProfiler::FScope UDKImportProfileScope_##Phase(TEXT(#Phase))
+
+/**
+ * Durations, peak memory, counts, bytes and cache hit rates of the running import, written as a JSON
+ * report once it is done. There is only one import at a time, every parser of the import records into Get().
+ * Recording is safe from any thread. Cache lookups are counted without locking, they are recorded from
+ * the hot paths of the parallel parse.
+ */
+class FUDKImportProfiler
+{
+public:
+	FUDKImportProfiler();
+	static FUDKImportProfiler & Get();
+
+	/** Forget the previous import, called when the stages of a new one are added */
+	void Begin();
+
+	void AddPhaseTime(const TCHAR * Phase, double Seconds);
+	void AddCount(const TCHAR * Counter, int64 Count = 1);
+	void AddBytes(const TCHAR * Counter, int64 Bytes);
+	void AddCacheLookup(const TCHAR * Cache, bool bHit);
+	/** Time of an asset, only the slowest ones are kept in the report */
+	void AddAssetTime(const FString &Asset, double Seconds);
+	/** Record the physical memory used by the process, in Phase when given, @return the used memory */
+	uint64 SampleMemory(const TCHAR * Phase = NULL);
+
+	bool WriteReport(const FString &FileName) const;
+
+	/** Add the time spent in its scope to a phase */
+	class FScope
+	{
+	public:
+		FScope(const TCHAR * Phase);
+		~FScope();
+
+	private:
+		const TCHAR * Phase;
+		double StartTime;
+	};
+
+private:
+	struct FPhase
+	{
+		FPhase() : Seconds(0.0), Calls(0), PeakUsedPhysical(0) {}
+		double Seconds;
+		int32 Calls;
+		/** Highest memory used by the process when entering or leaving the phase */
+		uint64 PeakUsedPhysical;
+	};
+
+	/** Lookups of a cache, its name is only written once, before the cache is published in CacheCount */
+	struct FCacheLookups
+	{
+		FCacheLookups() : Hits(0), Misses(0) {}
+		FString Name;
+		volatile int64 Hits, Misses;
+	};
+
+	/** @return the lookups of Cache, registering it the first time, NULL once MaxCaches are registered */
+	FCacheLookups * FindOrAddCacheLookups(const TCHAR * Cache);
+
+	static const int32 MaxReportedAssets = 50;
+	static const int32 MaxCaches = 16;
+
+	mutable FCriticalSection Mutex;
+	double BeginTime;
+	uint64 PeakUsedPhysical;
+	TMap<FString, FPhase> Phases;
+	TMap<FString, int64> Counts;
+	TMap<FString, int64> Bytes;
+	FCacheLookups CacheLookups[MaxCaches];
+	volatile int32 CacheCount;
+	/** Slowest assets, sorted from the slowest */
+	TArray<TPair<FString, double> > SlowestAssets;
+};
@@ -1,5 +1,10 @@
 #include "UDKImportPluginPrivatePCH.h"
 #include "UDKImportProgressReporter.h"
+#include "Async/Async.h"
+#include "Framework/Notifications/NotificationManager.h"
+#include "Widgets/Notifications/SNotificationList.h"
+
+#define LOCTEXT_NAMESPACE "UDKImportProgress"
 
 DEFINE_LOG_CATEGORY_STATIC(LogUDKImportProgress, Log, All);
 
@@ -20,23 +25,105 @@ void FUDKImportProgressReporterLog::LogError(const FText& Message)
 
 // UI Reporter implementation
 FUDKImportProgressReporterUI::FUDKImportProgressReporterUI()
-	: bCancelled(false)
+	: State(MakeShared<FNotificationState, ESPMode::ThreadSafe>())
+	, bCancelled(false)
 {
-	// TODO: Create progress dialog for UE5
-	// Can use SNotificationItem for non-modal feedback
+	check(IsInGameThread());
+	State->bUpdateQueued = false;
+
+	FNotificationInfo Info(LOCTEXT("ImportStarted", "Importing from UDK"));
+	Info.bFireAndForget = false;
+	Info.FadeOutDuration = 1.0f;
+	Info.ExpireDuration = 4.0f;
+	Info.ButtonDetails.Add(FNotificationButtonInfo(
+		LOCTEXT("CancelImport", "Cancel"),
+		LOCTEXT("CancelImportTooltip", "Stop the import once the current step is done"),
+		FSimpleDelegate::CreateRaw(this, &FUDKImportProgressReporterUI::Cancel),
+		SNotificationItem::CS_Pending));
+
+	TSharedPtr<SNotificationItem> Notification = FSlateNotificationManager::Get().AddNotification(Info);
+	if (Notification.IsValid())
+	{
+		Notification->SetCompletionState(SNotificationItem::CS_Pending);
+		State->Notification = Notification;
+	}
 }
 
 FUDKImportProgressReporterUI::~FUDKImportProgressReporterUI()
 {
-	// TODO: Close progress dialog
+	check(IsInGameThread());
+
+	// The cancel button is bound to this reporter
+	TSharedPtr<SNotificationItem> Notification = State->Notification.Pin();
+	State->Notification.Reset();
+	if (Notification.IsValid())
+	{
+		if (bCancelled)
+		{
+			Notification->SetText(LOCTEXT("ImportCancelled", "UDK import cancelled"));
+			Notification->SetCompletionState(SNotificationItem::CS_Fail);
+		}
+		else if (Errors.Num() > 0)
+		{
+			Notification->SetText(FText::Format(LOCTEXT("ImportFailed", "UDK import failed: {0}"), Errors.Last()));
+			Notification->SetCompletionState(SNotificationItem::CS_Fail);
+		}
+		else
+		{
+			Notification->SetText(FText::Format(LOCTEXT("ImportSucceeded", "UDK import done ({0} warnings)"), FText::AsNumber(Warnings.Num())));
+			Notification->SetCompletionState(SNotificationItem::CS_Success);
+		}
+		Notification->ExpireAndFadeout();
+	}
 }
 
 void FUDKImportProgressReporterUI::UpdateProgress(const FText& Message, float Progress)
 {
 	// Log to output as well
 	UE_LOG(LogUDKImportProgress, Log, TEXT("[%d%%] %s"), FMath::RoundToInt(Progress * 100.0f), *Message.ToString());
-	
-	// TODO: Update progress dialog
+
+	bool bQueueUpdate;
+	{
+		FScopeLock ScopeLock(&State->Lock);
+		State->PendingText = FText::Format(LOCTEXT("ImportProgress", "{0} ({1}%)"), Message, FText::AsNumber(FMath::RoundToInt(Progress * 100.0f)));
+		bQueueUpdate = !State->bUpdateQueued;
+		State->bUpdateQueued = true;
+	}
+
+	// Updates reported faster than the game thread ticks are coalesced
+	if (bQueueUpdate)
+	{
+		if (IsInGameThread())
+		{
+			FlushNotification(State);
+		}
+		else
+		{
+			TSharedRef<FNotificationState, ESPMode::ThreadSafe> SharedState = State;
+			AsyncTask(ENamedThreads::GameThread, [SharedState]()
+			{
+				FlushNotification(SharedState);
+			});
+		}
+	}
+}
+
+void FUDKImportProgressReporterUI::FlushNotification(const TSharedRef<FNotificationState, ESPMode::ThreadSafe>& State)
+{
+	check(IsInGameThread());
+
+	FText Text;
+	{
+		FScopeLock ScopeLock(&State->Lock);
+		Text = State->PendingText;
+		State->bUpdateQueued = false;
+	}
+
+	TSharedPtr<SNotificationItem> Notification = State->Notification.Pin();
+	if (Notification.IsValid())
+	{
+		Notification->SetText(Text);
+	}
 }
 
 bool FUDKImportProgressReporterUI::IsCancelled() const
@@ -44,18 +131,31 @@ bool FUDKImportProgressReporterUI::IsCancelled() const
 	return bCancelled;
 }
 
+void FUDKImportProgressReporterUI::Cancel()
+{
+	bCancelled = true;
+
+	TSharedPtr<SNotificationItem> Notification = State->Notification.Pin();
+	if (Notification.IsValid())
+	{
+		Notification->SetText(LOCTEXT("ImportCancelling", "Cancelling UDK import..."));
+	}
+}
+
 void FUDKImportProgressReporterUI::LogWarning(const FText& Message)
 {
 	UE_LOG(LogUDKImportProgress, Warning, TEXT("%s"), *Message.ToString());
+
+	FScopeLock ScopeLock(&LogLock);
 	Warnings.Add(Message);
-	
-	// TODO: Display in progress dialog
 }
 
 void FUDKImportProgressReporterUI::LogError(const FText& Message)
 {
 	UE_LOG(LogUDKImportProgress, Error, TEXT("%s"), *Message.ToString());
+
+	FScopeLock ScopeLock(&LogLock);
 	Errors.Add(Message);
-	
-	// TODO: Display in progress dialog
 }
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,53 @@
+#include "UDKImportPluginPrivatePCH.h"
+#include "UDKImportedAssetIndex.h"
+#include "AssetRegistryModule.h"
+#include "UDKImportProfiler.h"
+
+void FUDKImportedAssetIndex::Build(const FString &RootPath)
+{
+	check(IsInGameThread());
+	UDK_IMPORT_PROFILE_SCOPE(BuildAssetIndex);
+
+	IAssetRegistry &AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+
+	// The registry may still be discovering the project assets, only wait for the folder that is queried
+	TArray<FString> Paths;
+	Paths.Add(RootPath);
+	AssetRegistry.ScanPathsSynchronous(Paths);
+
+	TArray<FAssetData> Assets;
+	AssetRegistry.GetAssetsByPath(FName(*RootPath), Assets, true);
+
+	FRWScopeLock ScopeLock(Lock, SLT_Write);
+	ObjectPaths.Empty(Assets.Num());
+	for (const FAssetData &Asset : Assets)
+	{
+		ObjectPaths.Add(Asset.PackageName.ToString() + TEXT(".") + Asset.AssetName.ToString());
+	}
+}
+
+void FUDKImportedAssetIndex::Empty()
+{
+	FRWScopeLock ScopeLock(Lock, SLT_Write);
+	ObjectPaths.Empty();
+}
+
+bool FUDKImportedAssetIndex::Contains(const FString &ObjectPath) const
+{
+	bool bContains;
+	{
+		FRWScopeLock ScopeLock(Lock, SLT_ReadOnly);
+		bContains = ObjectPaths.Contains(ObjectPath);
+	}
+	FUDKImportProfiler::Get().AddCacheLookup(TEXT("ImportedAssetIndex"), bContains);
+	return bContains;
+}
+
+void FUDKImportedAssetIndex::Add(const UObject * Asset)
+{
+	if (Asset == NULL)
+		return;
+
+	FRWScopeLock ScopeLock(Lock, SLT_Write);
+	ObjectPaths.Add(Asset->GetPathName());
+}
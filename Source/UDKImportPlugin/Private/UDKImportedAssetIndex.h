@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * Object paths of the assets under a content folder, read once from the asset registry so that checking
+ * whether a UDK asset was already imported is a lookup that never loads a package.
+ * Assets created by the import are added as they are. Reads are safe from any thread.
+ */
+class FUDKImportedAssetIndex
+{
+public:
+	/** Replace the index by the assets found under RootPath (ex: "/Game/UDK"), on the game thread */
+	void Build(const FString &RootPath);
+	void Empty();
+
+	/** @param ObjectPath - Path of the asset object (ex: "/Game/UDK/Package/Textures/Name.Name") */
+	bool Contains(const FString &ObjectPath) const;
+	void Add(const UObject * Asset);
+
+	/** @return the asset at ObjectPath if it is indexed, loading it if needed, NULL otherwise */
+	template<class T>
+	T * Load(const FString &ObjectPath) const
+	{
+		return Contains(ObjectPath) ? LoadObject<T>(NULL, *ObjectPath, NULL, LOAD_NoWarn | LOAD_Quiet) : NULL;
+	}
+
+private:
+	mutable FRWLock Lock;
+	TSet<FString> ObjectPaths;
+};
@@ -0,0 +1,115 @@
+#include "UDKImportPluginPrivatePCH.h"
+#include "UDKSubLevelSharder.h"
+#include "EditorLevelUtils.h"
+#include "Engine/LevelStreamingDynamic.h"
+#include "Engine/World.h"
+#include "FileHelpers.h"
+#include "Misc/PackageName.h"
+#include "UDKImportProfiler.h"
+
+FUDKSubLevelSharder::FUDKSubLevelSharder(UWorld * World, const FString &PackagePath, const FString &LevelName, float CellSize)
+{
+	this->World = World;
+	this->PackagePath = PackagePath;
+	this->LevelName = LevelName;
+	this->CellSize = CellSize;
+	NextCellToSave = 0;
+
+#if ENGINE_MAJOR_VERSION >= 5
+	bWorldPartition = World->GetWorldPartition() != NULL;
+	if (bWorldPartition)
+	{
+		UE_LOG(UDKImportPluginLog, Log, TEXT("%s uses World Partition, actors are not split into sub-levels"), *World->GetName());
+	}
+#else
+	bWorldPartition = false;
+#endif
+}
+
+FIntPoint FUDKSubLevelSharder::GetCellFor(const FVector &Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+ULevel * FUDKSubLevelSharder::GetLevelFor(const FVector &Location)
+{
+	if (bWorldPartition)
+		return NULL;
+
+	const FIntPoint Coord = GetCellFor(Location);
+	const int32 * pCellIndex = CellIndices.Find(Coord);
+	if (pCellIndex != NULL)
+		return Cells[*pCellIndex].Level;
+
+	FCell &Cell = Cells[Cells.AddDefaulted()];
+	Cell.Coord = Coord;
+	Cell.Level = FindOrCreateLevel(Coord);
+	CellIndices.Add(Coord, Cells.Num() - 1);
+	return Cell.Level;
+}
+
+ULevel * FUDKSubLevelSharder::FindOrCreateLevel(const FIntPoint &Coord)
+{
+	const FString PackageName = PackagePath / FString::Printf(TEXT("%s_X%d_Y%d"), *LevelName, Coord.X, Coord.Y);
+	const FName PackageFName(*PackageName);
+
+	// Sub-levels of a previous import are reused, their actors are replaced through the import manifest
+	for (ULevelStreaming * StreamingLevel : World->GetStreamingLevels())
+	{
+		if (StreamingLevel && StreamingLevel->GetWorldAssetPackageFName() == PackageFName)
+		{
+			// Unloaded from the editor, it is loaded back so that its actors get replaced instead of duplicated
+			if (StreamingLevel->GetLoadedLevel() == NULL)
+			{
+				StreamingLevel->SetShouldBeLoaded(true);
+				StreamingLevel->SetShouldBeVisibleInEditor(true);
+				World->FlushLevelStreaming(EFlushLevelStreamingType::Full);
+			}
+			if (StreamingLevel->GetLoadedLevel() == NULL)
+			{
+				UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to load sub-level %s, its actors are imported into the current level"), *PackageName);
+			}
+			return StreamingLevel->GetLoadedLevel();
+		}
+	}
+
+	// Creating a level makes it the current one
+	ULevel * CurrentLevel = World->GetCurrentLevel();
+	ULevelStreaming * StreamingLevel;
+	if (FPackageName::DoesPackageExist(PackageName))
+	{
+		StreamingLevel = UEditorLevelUtils::AddLevelToWorld(World, *PackageName, ULevelStreamingDynamic::StaticClass());
+	}
+	else
+	{
+		const FString FileName = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetMapPackageExtension());
+#if ENGINE_MAJOR_VERSION >= 5
+		StreamingLevel = UEditorLevelUtils::CreateNewStreamingLevelForWorld(*World, ULevelStreamingDynamic::StaticClass(), FileName, false, NULL, false);
+#else
+		StreamingLevel = UEditorLevelUtils::CreateNewStreamingLevelForWorld(*World, ULevelStreamingDynamic::StaticClass(), FileName, false);
+#endif
+	}
+	World->SetCurrentLevel(CurrentLevel);
+
+	if (StreamingLevel == NULL || StreamingLevel->GetLoadedLevel() == NULL)
+	{
+		UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to create sub-level %s, its actors are imported into the current level"), *PackageName);
+		return NULL;
+	}
+	return StreamingLevel->GetLoadedLevel();
+}
+
+bool FUDKSubLevelSharder::SaveLevels(double EndTime)
+{
+	UDK_IMPORT_PROFILE_SCOPE(SaveSubLevels);
+	while (NextCellToSave < Cells.Num() && FPlatformTime::Seconds() < EndTime)
+	{
+		const FCell &Cell = Cells[NextCellToSave++];
+		if (Cell.Level && !FEditorFileUtils::SaveLevel(Cell.Level))
+		{
+			UE_LOG(UDKImportPluginLog, Warning, TEXT("Unable to save sub-level %s"), *Cell.Level->GetOutermost()->GetName());
+		}
+	}
+
+	return NextCellToSave >= Cells.Num();
+}
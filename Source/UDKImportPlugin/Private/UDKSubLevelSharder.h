@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+ * Spreads the actors of an import over streaming sub-levels, one per cell of a grid on the XY plane, so
+ * that very large maps can be loaded, saved and edited a few cells at a time instead of as one persistent
+ * level. Sub-levels are created on demand, or reused when a previous import created them, and only the
+ * ones that received actors are saved.
+ * World Partition worlds already stream their actors by cell, actors are left in their persistent level.
+ */
+class FUDKSubLevelSharder
+{
+public:
+	/**
+	 * @param World - World receiving the sub-levels
+	 * @param PackagePath - Content folder receiving the sub-level packages (ex: "/Game/UDK/MyLevel/SubLevels")
+	 * @param LevelName - Prefix of the sub-level names, followed by the cell coordinates
+	 * @param CellSize - Size of the cells in unreal units
+	 */
+	FUDKSubLevelSharder(UWorld * World, const FString &PackagePath, const FString &LevelName, float CellSize);
+
+	/** Coordinates of the cell holding Location */
+	FIntPoint GetCellFor(const FVector &Location) const;
+
+	/** Level the actors located at Location are spawned into, NULL for the current level of the world */
+	ULevel * GetLevelFor(const FVector &Location);
+
+	/** Save the sub-levels that received actors until EndTime, @return true once they are all saved */
+	bool SaveLevels(double EndTime);
+
+	int32 GetLevelCount() const { return Cells.Num(); }
+
+private:
+	struct FCell
+	{
+		FIntPoint Coord;
+		/** NULL if the sub-level could not be created */
+		ULevel * Level;
+	};
+
+	ULevel * FindOrCreateLevel(const FIntPoint &Coord);
+
+	UWorld * World;
+	FString PackagePath;
+	FString LevelName;
+	float CellSize;
+	bool bWorldPartition;
+
+	TArray<FCell> Cells;
+	TMap<FIntPoint, int32> CellIndices;
+	int32 NextCellToSave;
+};
@@ -24,6 +24,14 @@ public:
 	UPROPERTY(Config, EditAnywhere, Category = "Paths", meta = (DisplayName = "Temporary Export Path"))
 	FDirectoryPath DefaultTempPath;
 
+	/** Executable run for the UDK exports (empty = Binaries/Win32/UDK.com of the UDK installation), see Tools/MockUDK for a stand-in */
+	UPROPERTY(Config, EditAnywhere, Category = "Paths", meta = (DisplayName = "UDK Executable Override"))
+	FFilePath UDKExecutablePath;
+
+	/** Arguments put before every UDK command line, such as the script run by the UDK Executable Override */
+	UPROPERTY(Config, EditAnywhere, Category = "Paths", meta = (DisplayName = "UDK Executable Arguments"))
+	FString UDKExecutableArguments;
+
 	/** Enable automatic StaticMesh export to OBJ format */
 	UPROPERTY(Config, EditAnywhere, Category = "Export Options", meta = (DisplayName = "Auto Export Static Meshes"))
 	bool bAutoExportStaticMeshes;
@@ -32,10 +40,14 @@ public:
 	UPROPERTY(Config, EditAnywhere, Category = "Export Options", meta = (DisplayName = "Auto Convert OBJ to FBX"))
 	bool bAutoConvertOBJToFBX;
 
-	/** Path to Autodesk FBX Converter executable */
+	/** Path to Autodesk FBX Converter executable, see Tools/MockUDK for a stand-in */
 	UPROPERTY(Config, EditAnywhere, Category = "Tools", meta = (DisplayName = "FBX Converter Path", EditCondition = "bAutoConvertOBJToFBX"))
 	FFilePath FBXConverterPath;
 
+	/** Arguments put before the OBJ and FBX file names, such as the script run by the FBX Converter Path */
+	UPROPERTY(Config, EditAnywhere, Category = "Tools", meta = (DisplayName = "FBX Converter Arguments", EditCondition = "bAutoConvertOBJToFBX"))
+	FString FBXConverterArguments;
+
 	/** Light intensity multiplier for UDK to UE4/5 conversion */
 	UPROPERTY(Config, EditAnywhere, Category = "Conversion", meta = (DisplayName = "Light Intensity Multiplier", ClampMin = "0.1", ClampMax = "10000.0"))
 	float LightIntensityMultiplier;
@@ -52,7 +64,51 @@ public:
 	UPROPERTY(Config, EditAnywhere, Category = "Performance", meta = (DisplayName = "Max Parallel Imports", ClampMin = "1", ClampMax = "16"))
 	int32 MaxParallelImports;
 
-	// Future expansion: Asset type filters
+	/** Game thread time spent creating imported actors and materials each frame, the editor stays interactive in between */
+	UPROPERTY(Config, EditAnywhere, Category = "Performance", meta = (DisplayName = "Apply Frame Budget (ms)", ClampMin = "1.0", ClampMax = "100.0"))
+	float ApplyFrameBudgetMs;
+
+	/** Memory the editor may use while importing (0 = unlimited), garbage is collected between imported packages above it */
+	UPROPERTY(Config, EditAnywhere, Category = "Performance", meta = (DisplayName = "Memory Budget (MB)", ClampMin = "0"))
+	int32 MemoryBudgetMB;
+
+	/** Keep a binary copy of parsed levels next to their T3D export, reused while the export does not change */
+	UPROPERTY(Config, EditAnywhere, Category = "Performance", meta = (DisplayName = "Cache Parsed Levels"))
+	bool bCacheParsedLevels;
+
+	/** Only re-import the actors whose T3D block changed since the previous import of the level */
+	UPROPERTY(Config, EditAnywhere, Category = "Performance", meta = (DisplayName = "Incremental Re-import"))
+	bool bIncrementalReimport;
+
+	/** Merge StaticMeshActors sharing mesh, material overrides and collision into hierarchical instanced static mesh actors */
+	UPROPERTY(Config, EditAnywhere, Category = "Performance", meta = (DisplayName = "Consolidate Static Mesh Actors"))
+	bool bConsolidateStaticMeshActors;
+
+	/** Size of the grid cells used to split consolidated instances (0 = one group for the whole map) */
+	UPROPERTY(Config, EditAnywhere, Category = "Performance", meta = (DisplayName = "Instancing Cell Size", ClampMin = "0.0", EditCondition = "bConsolidateStaticMeshActors"))
+	float InstancingCellSize;
+
+	/** Replace imported brushes by static meshes baked from their CSG result */
+	UPROPERTY(Config, EditAnywhere, Category = "Performance", meta = (DisplayName = "Bake Brushes To Static Meshes"))
+	bool bBakeBrushesToStaticMeshes;
+
+	/** Size of the grid cells used to split baked brushes into static meshes */
+	UPROPERTY(Config, EditAnywhere, Category = "Performance", meta = (DisplayName = "Brush Bake Cell Size", ClampMin = "256.0", EditCondition = "bBakeBrushesToStaticMeshes"))
+	float BrushBakeCellSize;
+
+	/** Write the brush manifest as BrushesManifest.bin, a compact binary read by FUDKBrushManifestReader, instead of BrushesManifest.json */
+	UPROPERTY(Config, EditAnywhere, Category = "Performance", meta = (DisplayName = "Binary Brush Manifest"))
+	bool bBinaryBrushManifest;
+
+	/** Prefix the label of imported brushes with their CSG order. Their order is always kept in their ImportedBrushOrder tag and in the brush manifest, labels only sort the World Outliner but notify the editor for every brush */
+	UPROPERTY(Config, EditAnywhere, Category = "Performance", meta = (DisplayName = "Label Brushes With Import Order"))
+	bool bLabelBrushesWithImportOrder;
+
+	/** Split the imported actors into streaming sub-levels, one per cell of this size on the XY plane, so that very large maps can be loaded and saved a few cells at a time. 0 keeps every actor in the current level. Brushes always stay in the current level, their CSG is built per level */
+	UPROPERTY(Config, EditAnywhere, Category = "Performance", meta = (DisplayName = "Sub-Level Cell Size", ClampMin = "0.0"))
+	float SubLevelCellSize;
+
+	// Asset type filters
 	UPROPERTY(Config, EditAnywhere, Category = "Asset Filters", meta = (DisplayName = "Import Static Meshes"))
 	bool bImportStaticMeshes;
 
@@ -68,6 +124,22 @@ public:
 	UPROPERTY(Config, EditAnywhere, Category = "Asset Filters", meta = (DisplayName = "Import Brushes"))
 	bool bImportBrushes;
 
+	/** Only import actors of these UDK classes (empty = every supported class) */
+	UPROPERTY(Config, EditAnywhere, Category = "Asset Filters", meta = (DisplayName = "Import Actor Classes"))
+	TArray<FString> ImportActorClasses;
+
+	/** Only import actors belonging to these UDK layers (empty = every layer) */
+	UPROPERTY(Config, EditAnywhere, Category = "Asset Filters", meta = (DisplayName = "Import Layers"))
+	TArray<FName> ImportLayers;
+
+	/** Only import actors located inside Import Region */
+	UPROPERTY(Config, EditAnywhere, Category = "Asset Filters", meta = (DisplayName = "Use Import Region"))
+	bool bUseImportRegion;
+
+	/** Region of the UDK map to import, in UDK units */
+	UPROPERTY(Config, EditAnywhere, Category = "Asset Filters", meta = (DisplayName = "Import Region", EditCondition = "bUseImportRegion"))
+	FBox ImportRegion;
+
 	// Future: UE5-specific options
 	UPROPERTY(Config, EditAnywhere, Category = "UE5 Features", meta = (DisplayName = "Enable Nanite for Static Meshes", EditCondition = "false"))
 	bool bEnableNanite;
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+
+class SNotificationItem;
 
 /**
  * Progress reporting interface for UDK import operations
@@ -51,7 +54,9 @@ public:
 
 /**
  * Progress reporter with Slate UI feedback
- * TODO: Implement with progress dialog for UE5
+ * Shows a notification with a cancel button for the lifetime of the reporter.
+ * Can be used from any thread, the notification is updated on the game thread.
+ * Must be created and destroyed on the game thread.
  */
 class UDKIMPORTPLUGIN_API FUDKImportProgressReporterUI : public FUDKImportProgressReporter
 {
@@ -64,8 +69,25 @@ public:
 	virtual void LogWarning(const FText& Message) override;
 	virtual void LogError(const FText& Message) override;
 
+	/** Request the import to stop, bound to the cancel button */
+	void Cancel();
+
 private:
-	bool bCancelled;
+	/** State shared with the game thread tasks updating the notification */
+	struct FNotificationState
+	{
+		FCriticalSection Lock;
+		FText PendingText;
+		bool bUpdateQueued;
+		TWeakPtr<SNotificationItem> Notification;
+	};
+
+	/** Set the text of the notification to the last reported one, game thread only */
+	static void FlushNotification(const TSharedRef<FNotificationState, ESPMode::ThreadSafe>& State);
+
+	TSharedRef<FNotificationState, ESPMode::ThreadSafe> State;
+	FThreadSafeBool bCancelled;
+	FCriticalSection LogLock;
 	TArray<FText> Warnings;
 	TArray<FText> Errors;
 };
@@ -33,7 +33,9 @@ public class UDKImportPlugin : ModuleRules
 				"EditorFramework",
 				"PropertyEditor",
 				"DesktopPlatform",
-				"ContentBrowser"
+				"ContentBrowser",
+				"AssetRegistry",
+				"Json"
 			}
 		);
 
@@ -0,0 +1,119 @@
+#include "T3DTestHarness.h"
+#include "T3DCore/T3DBoundedMPSCQueue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace T3DCore;
+
+namespace
+{
+	/** Producer index in the high bits, sequence within the producer in the low bits */
+	const int SequenceBits = 40;
+
+	/** Run ProducerCount producers through a queue of Capacity cells, @return true if every item is received once and in producer order */
+	bool StressQueue(int ProducerCount, int ItemsPerProducer, std::uint32_t Capacity)
+	{
+		TBoundedMPSCQueue<std::uint64_t> Queue(Capacity);
+		std::atomic<bool> bConsumerStopped(false);
+		std::vector<std::thread> Producers;
+		for (int Producer = 0; Producer < ProducerCount; ++Producer)
+		{
+			Producers.emplace_back([&Queue, &bConsumerStopped, Producer, ItemsPerProducer]()
+			{
+				for (int Sequence = 0; Sequence < ItemsPerProducer; ++Sequence)
+				{
+					std::uint64_t Item = ((std::uint64_t)Producer << SequenceBits) | (std::uint64_t)Sequence;
+					if (!Queue.Enqueue(std::move(Item), [&bConsumerStopped]() { return bConsumerStopped.load(); }))
+						return;
+				}
+			});
+		}
+
+		std::vector<std::uint64_t> NextSequences(ProducerCount, 0);
+		bool bValid = true;
+		const long long ItemCount = (long long)ProducerCount * ItemsPerProducer;
+		std::uint64_t Item;
+		for (long long Received = 0; Received < ItemCount && bValid;)
+		{
+			if (!Queue.TryDequeue(Item))
+			{
+				// Don't starve the producers on machines with few cores
+				std::this_thread::yield();
+				continue;
+			}
+
+			const int Producer = (int)(Item >> SequenceBits);
+			const std::uint64_t Sequence = Item & ((1ull << SequenceBits) - 1);
+			bValid = Producer < ProducerCount && NextSequences[Producer] == Sequence;
+			if (bValid)
+				++NextSequences[Producer];
+			++Received;
+		}
+
+		// Producers left waiting on a full queue after a failure give up
+		bConsumerStopped = true;
+		for (std::thread &Thread : Producers)
+		{
+			Thread.join();
+		}
+		return bValid && !Queue.TryDequeue(Item);
+	}
+}
+
+T3D_TEST(QueueRoundsCapacityUp)
+{
+	CHECK(TBoundedMPSCQueue<int>(0).GetCapacity() == 2);
+	CHECK(TBoundedMPSCQueue<int>(3).GetCapacity() == 4);
+	CHECK(TBoundedMPSCQueue<int>(4096).GetCapacity() == 4096);
+	CHECK(TBoundedMPSCQueue<int>(4097).GetCapacity() == 8192);
+}
+
+T3D_TEST(QueueFullAndEmpty)
+{
+	TBoundedMPSCQueue<std::string> Queue(2);
+	std::string Item;
+	CHECK(!Queue.TryDequeue(Item));
+	CHECK(Queue.TryEnqueue(std::string("A")));
+	CHECK(Queue.TryEnqueue(std::string("B")));
+
+	std::string Rejected = "C";
+	CHECK(!Queue.TryEnqueue(std::move(Rejected)));
+	CHECK(Rejected == "C");
+	CHECK(!Queue.Enqueue(std::move(Rejected), []() { return true; }));
+
+	CHECK(Queue.TryDequeue(Item) && Item == "A");
+	CHECK(Queue.TryEnqueue(std::move(Rejected)));
+	CHECK(Queue.TryDequeue(Item) && Item == "B");
+	CHECK(Queue.TryDequeue(Item) && Item == "C");
+	CHECK(!Queue.TryDequeue(Item));
+}
+
+T3D_TEST(QueueStressBackPressure)
+{
+	// Tiny capacities keep the producers on the back-pressure path
+	const std::uint32_t Capacities[] = { 2, 3, 64 };
+	for (std::uint32_t Capacity : Capacities)
+	{
+		for (int Producers = 1; Producers <= 8; Producers *= 2)
+		{
+			const bool bValid = StressQueue(Producers, 20000 / Producers, Capacity);
+			if (!bValid)
+				std::printf("  %d producers, capacity %u\n", Producers, Capacity);
+			CHECK(bValid);
+		}
+	}
+}
+
+T3D_TEST(QueueStressThroughput)
+{
+	CHECK(StressQueue(4, 250000, 4096));
+}
+
+int main()
+{
+	return T3DTest::RunAll();
+}
@@ -0,0 +1,243 @@
+#include "T3DTestHarness.h"
+#include "T3DCore/T3DCore.h"
+#include "T3DCore/T3DRequirementGraph.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace T3DCore;
+
+typedef TRange<char> FRange;
+
+/// Lines
+
+T3D_TEST(TrimWhitespaces)
+{
+	CHECK_RANGE(Trim(MakeRange(" \t Begin Actor \r")), "Begin Actor");
+	CHECK_RANGE(Trim(MakeRange("NoSpace")), "NoSpace");
+	CHECK(Trim(MakeRange(" \t\r\n")).IsEmpty());
+	CHECK(Trim(MakeRange("")).IsEmpty());
+}
+
+T3D_TEST(ForEachLineSkipsEmptyLines)
+{
+	std::vector<std::string> Lines;
+	ForEachLine(MakeRange("Begin Map\r\n\n   \nEnd Map"), [&Lines](const FRange &Line)
+	{
+		Lines.push_back(std::string(Line.Begin, Line.End));
+	});
+	CHECK(Lines.size() == 3);
+	CHECK(Lines.size() == 3 && Lines[0] == "Begin Map\r" && Lines[1] == "   " && Lines[2] == "End Map");
+
+	int Count = 0;
+	ForEachLine(MakeRange("\n\n"), [&Count](const FRange &) { ++Count; });
+	CHECK(Count == 0);
+}
+
+/// Values
+
+T3D_TEST(FindValueAfterPlainValue)
+{
+	FRange Value;
+	CHECK(FindValueAfter(MakeRange("Begin Actor Class=StaticMeshActor Name=Mesh_12,Archetype"), MakeRange("Name="), 1000, Value));
+	CHECK_RANGE(Value, "Mesh_12");
+	CHECK(FindValueAfter(MakeRange("Tag=(Value)"), MakeRange("Tag="), 1000, Value));
+	CHECK_RANGE(Value, "(Value)");
+	CHECK(!FindValueAfter(MakeRange("Class=Light"), MakeRange("Name="), 1000, Value));
+}
+
+T3D_TEST(FindValueAfterMaxIndex)
+{
+	FRange Value;
+	CHECK(FindValueAfter(MakeRange("DrawScale=2.0"), MakeRange("DrawScale="), 0, Value));
+	CHECK_RANGE(Value, "2.0");
+	CHECK(!FindValueAfter(MakeRange("PrePivot DrawScale=2.0"), MakeRange("DrawScale="), 0, Value));
+}
+
+T3D_TEST(FindValueAfterQuotedValue)
+{
+	FRange Value;
+	CHECK(FindValueAfter(MakeRange("Text=\"Hello, World\" Next=1"), MakeRange("Text="), 1000, Value));
+	CHECK_RANGE(Value, "Hello, World");
+	CHECK(FindValueAfter(MakeRange("Text=\"Unterminated"), MakeRange("Text="), 1000, Value));
+	CHECK_RANGE(Value, "Unterminated");
+}
+
+T3D_TEST(FindValueAfterEscapedQuotes)
+{
+	FRange Value;
+	CHECK(FindValueAfter(MakeRange("Text=\"Say \\\"Hi\\\" \\\\\" Next=1"), MakeRange("Text="), 1000, Value));
+	CHECK_RANGE(Value, "Say \\\"Hi\\\" \\\\");
+}
+
+T3D_TEST(FindValueAfterNestedParentheses)
+{
+	FRange Value;
+	CHECK(FindValueAfter(MakeRange("Param=(Name=\"A\",Value=(R=1,G=(2)),B=3) Next=1"), MakeRange("Param="), 1000, Value));
+	CHECK_RANGE(Value, "(Name=\"A\",Value=(R=1,G=(2)),B=3)");
+	CHECK(FindValueAfter(MakeRange("Param=((Open"), MakeRange("Param="), 1000, Value));
+	CHECK_RANGE(Value, "((Open");
+}
+
+T3D_TEST(SplitPropertyAtFirstEqual)
+{
+	FRange Name, Value;
+	CHECK(SplitProperty(MakeRange("Location=(X=1,Y=2,Z=3)"), Name, Value));
+	CHECK_RANGE(Name, "Location");
+	CHECK_RANGE(Value, "(X=1,Y=2,Z=3)");
+	CHECK(SplitProperty(MakeRange("bHidden="), Name, Value));
+	CHECK_RANGE(Name, "bHidden");
+	CHECK(Value.IsEmpty());
+	CHECK(!SplitProperty(MakeRange("=Value"), Name, Value));
+	CHECK(!SplitProperty(MakeRange("NoValue"), Name, Value));
+}
+
+/// Ressource urls
+
+T3D_TEST(ParseRessourceUrlWithPackage)
+{
+	FRange Type, Package, Name;
+	bool bHasPackage = false;
+	CHECK(ParseRessourceUrl(MakeRange("StaticMesh'Pkg.Group.SubGroup.Mesh'"), Type, bHasPackage, Package, Name));
+	CHECK(bHasPackage);
+	CHECK_RANGE(Type, "StaticMesh");
+	CHECK_RANGE(Package, "Pkg");
+	CHECK_RANGE(Name, "Mesh");
+}
+
+T3D_TEST(ParseRessourceUrlWithoutPackage)
+{
+	FRange Type, Package, Name;
+	bool bHasPackage = true;
+	CHECK(ParseRessourceUrl(MakeRange("Texture2D'Diffuse'"), Type, bHasPackage, Package, Name));
+	CHECK(!bHasPackage);
+	CHECK_RANGE(Type, "Texture2D");
+	CHECK(Package.IsEmpty());
+	CHECK_RANGE(Name, "Diffuse");
+}
+
+T3D_TEST(ParseRessourceUrlMalformed)
+{
+	FRange Type, Package, Name;
+	bool bHasPackage;
+	CHECK(!ParseRessourceUrl(MakeRange("None"), Type, bHasPackage, Package, Name));
+	CHECK(!ParseRessourceUrl(MakeRange("Material'Pkg.Unterminated"), Type, bHasPackage, Package, Name));
+	CHECK(!ParseRessourceUrl(MakeRange(""), Type, bHasPackage, Package, Name));
+	CHECK(ParseRessourceUrl(MakeRange("'"), Type, bHasPackage, Package, Name));
+	CHECK(Type.IsEmpty() && Name.IsEmpty());
+}
+
+T3D_TEST(SplitPackagePathGroups)
+{
+	FRange Package, Name;
+	SplitPackagePath(MakeRange("Pkg.Group.Name"), Package, Name);
+	CHECK_RANGE(Package, "Pkg");
+	CHECK_RANGE(Name, "Name");
+	SplitPackagePath(MakeRange("Pkg"), Package, Name);
+	CHECK_RANGE(Package, "Pkg");
+	CHECK(Name.IsEmpty());
+}
+
+/// Polygons
+
+T3D_TEST(ParseVectorComponents)
+{
+	double Vector[3];
+	CHECK(ParseVector("+00128.000000,-00064.500000,+00000.250000", Vector));
+	CHECK(Vector[0] == 128.0 && Vector[1] == -64.5 && Vector[2] == 0.25);
+	CHECK(ParseVector(" 1 , 2 , 3", Vector));
+	CHECK(Vector[0] == 1.0 && Vector[1] == 2.0 && Vector[2] == 3.0);
+}
+
+T3D_TEST(ParseVectorMissingComponent)
+{
+	double Vector[3];
+	CHECK(!ParseVector("1,2", Vector));
+	CHECK(Vector[0] == 1.0 && Vector[1] == 2.0 && Vector[2] == 0.0);
+	CHECK(!ParseVector("7", Vector));
+	CHECK(Vector[0] == 7.0 && Vector[1] == 0.0 && Vector[2] == 0.0);
+	CHECK(!ParseVector("", Vector));
+}
+
+T3D_TEST(ParsePolyLineCommands)
+{
+	double Vector[3];
+	CHECK(ParsePolyLine("   Origin   +00128.000000,+00256.000000,-00032.000000", Vector) == EPolyLine::Origin);
+	CHECK(Vector[0] == 128.0 && Vector[1] == 256.0 && Vector[2] == -32.0);
+	CHECK(ParsePolyLine("\tvertex 1,2,3", Vector) == EPolyLine::Vertex);
+	CHECK(Vector[2] == 3.0);
+	CHECK(ParsePolyLine("TextureU +00001.000000,+00000.000000,+00000.000000", Vector) == EPolyLine::TextureU);
+	CHECK(ParsePolyLine("TextureV +00000.000000,-00001.000000,+00000.000000", Vector) == EPolyLine::TextureV);
+	CHECK(Vector[1] == -1.0);
+	CHECK(ParsePolyLine("Normal +00000.000000,+00000.000000,+00001.000000", Vector) == EPolyLine::Normal);
+	CHECK(ParsePolyLine("Pan U=0 V=0", Vector) == EPolyLine::Other);
+	CHECK(ParsePolyLine("VertexCount 4", Vector) == EPolyLine::Other);
+	CHECK(ParsePolyLine("End Polygon", Vector) == EPolyLine::Other);
+}
+
+/// Requirements
+
+typedef TRequirementGraph<std::string, std::function<void(int)>, int> FTestGraph;
+
+T3D_TEST(RequirementGraphRunsActionsOnFix)
+{
+	FTestGraph Graph;
+	std::vector<int> Received;
+	Graph.Add("Mesh'A.B'", [&Received](int Object) { Received.push_back(Object); });
+	Graph.Add("Mesh'A.B'", [&Received](int Object) { Received.push_back(Object * 10); });
+	CHECK(Graph.IsPending("Mesh'A.B'"));
+	CHECK(Graph.NumPending() == 1);
+	CHECK(Graph.Find("Mesh'A.B'") == NULL);
+
+	Graph.Fix("Mesh'A.B'", 4);
+	CHECK(Received.size() == 2 && Received[0] == 4 && Received[1] == 40);
+	CHECK(!Graph.IsPending("Mesh'A.B'"));
+	CHECK(Graph.NumPending() == 0 && Graph.NumFixed() == 1);
+	CHECK(Graph.Find("Mesh'A.B'") != NULL && *Graph.Find("Mesh'A.B'") == 4);
+}
+
+T3D_TEST(RequirementGraphRunsLateActionsRightAway)
+{
+	FTestGraph Graph;
+	Graph.Fix("Texture'A.T'", 7);
+	int Received = 0;
+	Graph.Add("Texture'A.T'", [&Received](int Object) { Received = Object; });
+	CHECK(Received == 7);
+	CHECK(Graph.NumPending() == 0);
+}
+
+T3D_TEST(RequirementGraphActionsMayAddRequirements)
+{
+	FTestGraph Graph;
+	int MaterialObject = 0;
+	// A material requiring its textures once it is imported, as T3DMaterialParser does
+	Graph.Add("Material'A.M'", [&Graph, &MaterialObject](int Object)
+	{
+		MaterialObject = Object;
+		for (int Index = 0; Index < 64; ++Index)
+		{
+			Graph.Add("Texture'A.T" + std::to_string(Index) + "'", [](int) {});
+		}
+		Graph.Add("Material'A.M'", [&MaterialObject](int Late) { MaterialObject += Late; });
+	});
+	Graph.Fix("Material'A.M'", 3);
+	CHECK(MaterialObject == 6);
+	CHECK(Graph.NumPending() == 64);
+
+	int Missing = 0;
+	Graph.ForEachPending([&Missing](const std::string &Key) { Missing += Key.compare(0, 9, "Texture'A") == 0; });
+	CHECK(Missing == 64);
+
+	int Fixed = 0;
+	Graph.ForEachFixed([&Fixed](const std::string &, int Object) { Fixed += Object; });
+	CHECK(Fixed == 3);
+
+	Graph.Reset();
+	CHECK(Graph.NumPending() == 0 && Graph.NumFixed() == 0);
+}
+
+int main()
+{
+	return T3DTest::RunAll();
+}
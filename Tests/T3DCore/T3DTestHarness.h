@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Minimal test harness of the engine independent core. Tests register themselves with T3D_TEST, CHECK
+ * reports a failure and goes on, the executable returns the number of failed tests for ctest.
+ */
+namespace T3DTest
+{
+	typedef void (*FTestFunc)(int &Failures);
+
+	struct FTest
+	{
+		const char * Name;
+		FTestFunc Func;
+	};
+
+	inline std::vector<FTest> & GetTests()
+	{
+		static std::vector<FTest> Tests;
+		return Tests;
+	}
+
+	struct FRegister
+	{
+		FRegister(const char * Name, FTestFunc Func) { GetTests().push_back({ Name, Func }); }
+	};
+
+	inline int RunAll()
+	{
+		int FailedTests = 0;
+		for (const FTest &Test : GetTests())
+		{
+			int Failures = 0;
+			Test.Func(Failures);
+			std::printf("%s %s\n", Failures == 0 ? "[ OK ]" : "[FAIL]", Test.Name);
+			if (Failures != 0)
+				++FailedTests;
+		}
+		std::printf("%d of %d tests failed\n", FailedTests, (int)GetTests().size());
+		return FailedTests;
+	}
+
+	template<typename RangeType>
+	std::string ToString(const RangeType &Range)
+	{
+		return std::string(Range.Begin, Range.End);
+	}
+}
+
+#define T3D_TEST(Name) \
+	static void Name(int &Failures); \
+	static T3DTest::FRegister Name##Register(#Name, &Name); \
+	static void Name(int &Failures)
+
+#define CHECK(Condition) \
+	do { if (!(Condition)) { ++Failures; std::printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #Condition); } } while (0)
+
+#define CHECK_RANGE(Range, Expected) \
+	do { const std::string Actual = T3DTest::ToString(Range); if (Actual != (Expected)) { ++Failures; std::printf("  %s:%d: \"%s\" != \"%s\"\n", __FILE__, __LINE__, Actual.c_str(), Expected); } } while (0)
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""
+Stand-in for FbxConverter.exe, converting the OBJ static meshes exported by UDK or MockUDK without the
+Autodesk FBX Converter, on Linux build machines too.
+
+Usage: MockFbxConverter.py [--latency=<Seconds>] <OBJ file> <FBX file>
+
+Writes an ASCII FBX 7.3 file holding one mesh made of the vertices and faces of the OBJ file, its normals,
+texture coordinates and materials are dropped.
+"""
+
+import os
+import sys
+import time
+
+
+def log(message):
+	print(message)
+	sys.stdout.flush()
+
+
+def read_obj(file_name):
+	"""Vertices as (X, Y, Z) and faces as lists of zero based vertex indices"""
+	vertices = []
+	faces = []
+	with open(file_name, 'r', errors='replace') as obj:
+		for line in obj:
+			fields = line.split()
+			if not fields:
+				continue
+			if fields[0] == 'v' and len(fields) >= 4:
+				vertices.append(tuple(float(value) for value in fields[1:4]))
+			elif fields[0] == 'f' and len(fields) >= 4:
+				# "v", "v/vt", "v//vn" or "v/vt/vn", negative indices are relative to the last vertex
+				face = []
+				for field in fields[1:]:
+					index = int(field.split('/')[0])
+					face.append(index - 1 if index > 0 else len(vertices) + index)
+				faces.append(face)
+	return vertices, faces
+
+
+def fbx_array(values):
+	return '*%d {\n\ta: %s\n}' % (len(values), ','.join(values))
+
+
+def write_fbx(file_name, name, vertices, faces):
+	# The last index of every polygon is stored as -(index + 1)
+	polygon_indices = []
+	for face in faces:
+		polygon_indices.extend(str(index) for index in face[:-1])
+		polygon_indices.append(str(-face[-1] - 1))
+	coordinates = ['%.6f' % value for vertex in vertices for value in vertex]
+
+	with open(file_name, 'w', newline='\n') as fbx:
+		fbx.write('; FBX 7.3.0 project file\n')
+		fbx.write('FBXHeaderExtension:  {\n\tFBXHeaderVersion: 1003\n\tFBXVersion: 7300\n\tCreator: "MockFbxConverter"\n}\n')
+		fbx.write('GlobalSettings:  {\n\tVersion: 1000\n\tProperties70:  {\n'
+			'\t\tP: "UpAxis", "int", "Integer", "",2\n'
+			'\t\tP: "UpAxisSign", "int", "Integer", "",1\n'
+			'\t\tP: "FrontAxis", "int", "Integer", "",1\n'
+			'\t\tP: "FrontAxisSign", "int", "Integer", "",-1\n'
+			'\t\tP: "CoordAxis", "int", "Integer", "",0\n'
+			'\t\tP: "CoordAxisSign", "int", "Integer", "",1\n'
+			'\t\tP: "UnitScaleFactor", "double", "Number", "",1\n'
+			'\t}\n}\n')
+		fbx.write('Definitions:  {\n\tVersion: 100\n\tCount: 2\n'
+			'\tObjectType: "Geometry" {\n\t\tCount: 1\n\t}\n'
+			'\tObjectType: "Model" {\n\t\tCount: 1\n\t}\n}\n')
+		fbx.write('Objects:  {\n')
+		fbx.write('\tGeometry: 1000, "Geometry::%s", "Mesh" {\n' % name)
+		fbx.write('\t\tVertices: %s\n' % fbx_array(coordinates).replace('\n', '\n\t\t'))
+		fbx.write('\t\tPolygonVertexIndex: %s\n' % fbx_array(polygon_indices).replace('\n', '\n\t\t'))
+		fbx.write('\t\tGeometryVersion: 124\n\t}\n')
+		fbx.write('\tModel: 2000, "Model::%s", "Mesh" {\n\t\tVersion: 232\n\t}\n' % name)
+		fbx.write('}\n')
+		fbx.write('Connections:  {\n\tC: "OO",2000,0\n\tC: "OO",1000,2000\n}\n')
+
+
+def main(arguments):
+	latency = 0.0
+	while arguments and arguments[0].startswith('--'):
+		option, _, value = arguments.pop(0).partition('=')
+		if option == '--latency':
+			latency = float(value)
+		else:
+			log('Error: Unknown option %s' % option)
+			return 1
+
+	if len(arguments) != 2:
+		log('Error: Expected an OBJ file and an FBX file')
+		return 1
+
+	obj_file, fbx_file = arguments
+	try:
+		vertices, faces = read_obj(obj_file)
+	except (OSError, ValueError) as error:
+		log('Error: Unable to read %s: %s' % (obj_file, error))
+		return 1
+	if not faces or any(index < 0 or index >= len(vertices) for face in faces for index in face):
+		log('Error: No valid face in %s' % obj_file)
+		return 1
+
+	name = os.path.splitext(os.path.basename(fbx_file))[0]
+	write_fbx(fbx_file, name, vertices, faces)
+
+	# Conversions take time in the FBX Converter, the latency stands for it
+	time.sleep(latency)
+	log('Converted %s to %s' % (obj_file, fbx_file))
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv[1:]))
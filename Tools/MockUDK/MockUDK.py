@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""
+Stand-in for UDK.com, answering the commands run by the import plugin without a UDK installation.
+
+Usage: MockUDK.py [--fixtures=<Folder>] [--latency=<Seconds>] [--latency-per-file=<Seconds>] <UDK command line>
+
+Commands:
+  batchexport <Level> Level T3D <Folder>
+      Copies <Fixtures>/<Level>.T3D, or <Fixtures>/PersistentLevel.T3D, to <Folder>/PersistentLevel.T3D
+  batchexport <Package> <Class> <Format> <Folder>
+      Copies the files of <Fixtures>/<Export folder>/<Package>, laid out like the export folders of the plugin.
+      Without them, placeholder files are written for every object of Package referenced by the fixtures.
+  run UDKPluginExport.ExportStaticMeshMaterials <StaticMesh urls>
+      Logs the materials of the meshes, from <Fixtures>/StaticMeshMaterials.log when it exists,
+      otherwise picks them amongst the materials referenced by the fixtures.
+
+The fixtures folder can be written by the T3DCoreBenchmark tool with --output=<Folder>.
+"""
+
+import os
+import re
+import shutil
+import struct
+import sys
+import time
+import zlib
+
+# Classes and extensions of the batchexport formats used by the plugin
+EXPORT_FORMATS = {
+	('material', 't3d'): (('Material',), '.T3D'),
+	('materialinstanceconstant', 't3d'): (('MaterialInstanceConstant',), '.T3D'),
+	('texture', 'tga'): (('Texture2D',), '.TGA'),
+	('texture', 't3d'): (('Texture2D',), '.T3D'),
+	('staticmesh', 'obj'): (('StaticMesh',), '.OBJ'),
+}
+
+CLASS_URL = re.compile(r"(\w+)'([\w.]+)'")
+POLYGON_TEXTURE = re.compile(r"Begin Polygon .*?Texture=([\w.]+)")
+
+
+def log(message):
+	print(message)
+	sys.stdout.flush()
+
+
+def fixture_references(fixtures):
+	"""Objects referenced by the T3D files of the fixtures, as a set of (Class, Path)"""
+	references = set()
+	if not fixtures or not os.path.isdir(fixtures):
+		return references
+
+	for root, _, files in os.walk(fixtures):
+		for name in files:
+			if not name.upper().endswith('.T3D'):
+				continue
+			with open(os.path.join(root, name), 'r', errors='replace') as t3d:
+				for line in t3d:
+					for match in CLASS_URL.finditer(line):
+						references.add((match.group(1), match.group(2)))
+					match = POLYGON_TEXTURE.search(line)
+					if match:
+						references.add(('Material', match.group(1)))
+	return references
+
+
+def placeholder_material(name):
+	return (
+		'Begin Object Class=Material Name=%s\r\n'
+		'Begin Object Class=MaterialExpressionConstant3Vector Name=MaterialExpressionConstant3Vector_0\r\n'
+		'   R=0.500000\r\n'
+		'   G=0.500000\r\n'
+		'   B=0.500000\r\n'
+		'   Material=Material\'%s\'\r\n'
+		'   Name="MaterialExpressionConstant3Vector_0"\r\n'
+		'End Object\r\n'
+		'DiffuseColor=(Expression=MaterialExpressionConstant3Vector\'MaterialExpressionConstant3Vector_0\')\r\n'
+		'Name="%s"\r\n'
+		'End Object\r\n' % (name, name, name)).encode('ascii')
+
+
+def placeholder_material_instance(name):
+	return (
+		'Begin Object Class=MaterialInstanceConstant Name=%s\r\n'
+		'   Name="%s"\r\n'
+		'End Object\r\n' % (name, name)).encode('ascii')
+
+
+def placeholder_texture_info(name):
+	return (
+		'Begin Object Class=Texture2D Name=%s\r\n'
+		'   SizeX=4\r\n'
+		'   SizeY=4\r\n'
+		'   Name="%s"\r\n'
+		'End Object\r\n' % (name, name)).encode('ascii')
+
+
+def placeholder_texture(name):
+	# 4x4 uncompressed 32 bits TGA, tinted from the name so that textures can be told apart
+	color = zlib.crc32(name.encode('utf-8')) & 0xFFFFFF
+	header = struct.pack('<BBBHHBHHHHBB', 0, 0, 2, 0, 0, 0, 0, 0, 4, 4, 32, 8)
+	pixel = struct.pack('<BBBB', color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF, 255)
+	return header + pixel * 16
+
+
+def placeholder_static_mesh(name):
+	lines = ['# %s' % name, 'g %s' % name, 'usemtl Material_0']
+	for x in (-64, 64):
+		for y in (-64, 64):
+			for z in (-64, 64):
+				lines.append('v %d %d %d' % (x, y, z))
+	for face in ((1, 3, 4, 2), (5, 6, 8, 7), (1, 2, 6, 5), (3, 7, 8, 4), (1, 5, 7, 3), (2, 4, 8, 6)):
+		lines.append('f %d %d %d %d' % face)
+	return ('\r\n'.join(lines) + '\r\n').encode('ascii')
+
+
+def placeholder(class_name, extension, name):
+	if extension == '.TGA':
+		return placeholder_texture(name)
+	if extension == '.OBJ':
+		return placeholder_static_mesh(name)
+	if class_name == 'Material':
+		return placeholder_material(name)
+	if class_name == 'MaterialInstanceConstant':
+		return placeholder_material_instance(name)
+	return placeholder_texture_info(name)
+
+
+def batch_export_level(fixtures, level, folder):
+	for candidate in (level + '.T3D', 'PersistentLevel.T3D'):
+		source = os.path.join(fixtures or '', candidate)
+		if os.path.isfile(source):
+			os.makedirs(folder, exist_ok=True)
+			shutil.copyfile(source, os.path.join(folder, 'PersistentLevel.T3D'))
+			log('Log: Exported Level %s to %s' % (level, folder))
+			return 1
+	log('Error: No fixture for level %s' % level)
+	return None
+
+
+def batch_export_package(fixtures, package, class_name, export_format, folder):
+	key = (class_name.lower(), export_format.lower())
+	if key not in EXPORT_FORMATS:
+		log('Error: Unsupported export %s %s' % (class_name, export_format))
+		return None
+	classes, extension = EXPORT_FORMATS[key]
+
+	os.makedirs(folder, exist_ok=True)
+	exported = 0
+
+	# Same layout as the export folders of the plugin, <Export folder>/<Package>
+	source = os.path.join(fixtures or '', os.path.basename(os.path.dirname(folder)), package)
+	if fixtures and os.path.isdir(source):
+		for name in os.listdir(source):
+			if name.upper().endswith(extension):
+				shutil.copyfile(os.path.join(source, name), os.path.join(folder, name))
+				log('Log: Exported %s %s.%s' % (class_name, package, name[:-len(extension)]))
+				exported += 1
+		return exported
+
+	names = set()
+	for reference_class, path in fixture_references(fixtures):
+		parts = path.split('.')
+		if reference_class in classes and len(parts) > 1 and parts[0] == package:
+			names.add(parts[-1])
+	for name in sorted(names):
+		with open(os.path.join(folder, name + extension), 'wb') as exported_file:
+			exported_file.write(placeholder(classes[0], extension, name))
+		log('Log: Exported %s %s.%s' % (class_name, package, name))
+		exported += 1
+	return exported
+
+
+def export_static_mesh_materials(fixtures, static_mesh_urls):
+	requested = set(static_mesh_urls)
+	recorded = os.path.join(fixtures or '', 'StaticMeshMaterials.log')
+	if fixtures and os.path.isfile(recorded):
+		with open(recorded, 'r', errors='replace') as recorded_log:
+			for line in recorded_log:
+				fields = line.rstrip('\r\n').split(' ')
+				if len(fields) >= 4 and fields[0] == 'ScriptLog:' and fields[1] in requested:
+					log(line.rstrip('\r\n'))
+		return len(requested)
+
+	materials = sorted(path for reference_class, path in fixture_references(fixtures) if reference_class == 'Material')
+	for url in static_mesh_urls:
+		if materials:
+			material = materials[zlib.crc32(url.encode('utf-8')) % len(materials)]
+			log("ScriptLog: %s 0 Material'%s'" % (url, material))
+	return len(requested)
+
+
+def main(arguments):
+	fixtures = None
+	latency = 0.0
+	latency_per_file = 0.0
+	while arguments and arguments[0].startswith('--'):
+		option, _, value = arguments.pop(0).partition('=')
+		if option == '--fixtures':
+			fixtures = value
+		elif option == '--latency':
+			latency = float(value)
+		elif option == '--latency-per-file':
+			latency_per_file = float(value)
+		else:
+			log('Error: Unknown option %s' % option)
+			return 1
+
+	log('Log: MockUDK %s' % ' '.join(arguments))
+	command = [argument.lower() for argument in arguments[:2]]
+	if len(arguments) == 5 and command[0] == 'batchexport' and arguments[2].lower() == 'level':
+		exported = batch_export_level(fixtures, arguments[1], arguments[4])
+	elif len(arguments) == 5 and command[0] == 'batchexport':
+		exported = batch_export_package(fixtures, arguments[1], arguments[2], arguments[3], arguments[4])
+	elif len(arguments) >= 2 and command == ['run', 'udkpluginexport.exportstaticmeshmaterials']:
+		exported = export_static_mesh_materials(fixtures, arguments[2:])
+	else:
+		log('Error: Unknown command')
+		return 1
+
+	# Exports take time in UDK, the latency stands for it
+	time.sleep(latency + latency_per_file * (exported or 0))
+	if exported is None:
+		return 1
+	log('Success - 0 error(s), 0 warning(s)')
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv[1:]))
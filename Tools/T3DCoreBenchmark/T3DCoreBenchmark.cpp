@@ -0,0 +1,237 @@
+#include "T3DCore/T3DCore.h"
+#include "T3DCore/T3DRequirementGraph.h"
+#include "T3DSyntheticGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Throughput of the engine independent T3D core over synthetic exports, see FT3DSyntheticGenerator:
+ *   T3DCoreBenchmark [--static-mesh-actors=2000] [--brushes=200] [--polys-per-brush=6] [--lights=200]
+ *     [--sub-object-depth=2] [--materials=100] [--expressions-per-material=20] [--material-instances=100]
+ *     [--seed=0] [--iterations=5] [--output=<Folder>]
+ * Each benchmark reports its best iteration in MB/s and objects/s. With --output, the generated files are
+ * written to Folder, as fixtures for Tools/MockUDK, and nothing is measured.
+ */
+namespace
+{
+	typedef T3DCore::TRange<char> FRange;
+
+	double Now()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/** Best time of the iterations of a benchmark, and the amount of work done by one iteration */
+	struct FBenchmarkResult
+	{
+		FBenchmarkResult() : Seconds(1e30), Bytes(0), Objects(0) {}
+
+		double Seconds;
+		long long Bytes, Objects;
+
+		void AddIteration(double IterationSeconds, long long IterationBytes, long long IterationObjects)
+		{
+			Seconds = std::min(Seconds, IterationSeconds);
+			Bytes = IterationBytes;
+			Objects = IterationObjects;
+		}
+
+		void Print(const char * Name, const char * ObjectName) const
+		{
+			const double SafeSeconds = std::max(Seconds, 1e-9);
+			std::printf("%-22s %8.3f ms %10.1f MB/s %12.0f %s/s\n", Name, Seconds * 1000.0,
+				Bytes / SafeSeconds / (1024.0 * 1024.0), Objects / SafeSeconds, ObjectName);
+		}
+	};
+
+	const char * FindArgument(int Argc, char ** Argv, const char * Name)
+	{
+		const size_t NameLen = std::strlen(Name);
+		for (int Index = 1; Index < Argc; ++Index)
+		{
+			if (std::strncmp(Argv[Index], Name, NameLen) == 0)
+				return Argv[Index] + NameLen;
+		}
+		return NULL;
+	}
+
+	void ParseIntArgument(int Argc, char ** Argv, const char * Name, int &Value)
+	{
+		if (const char * Argument = FindArgument(Argc, Argv, Name))
+		{
+			Value = std::atoi(Argument);
+		}
+	}
+
+	std::vector<FRange> SplitLines(const std::string &Content)
+	{
+		std::vector<FRange> Lines;
+		T3DCore::ForEachLine(FRange(Content.data(), Content.data() + Content.size()), [&Lines](const FRange &Line)
+		{
+			Lines.push_back(T3DCore::Trim(Line));
+		});
+		return Lines;
+	}
+
+	bool StartsWith(const FRange &Line, const char * Prefix)
+	{
+		return Line.StartsWith(T3DCore::MakeRange(Prefix));
+	}
+}
+
+int main(int Argc, char ** Argv)
+{
+	FT3DSyntheticGenerator::FSettings GeneratorSettings;
+	int Iterations = 5;
+	ParseIntArgument(Argc, Argv, "--static-mesh-actors=", GeneratorSettings.StaticMeshActors);
+	ParseIntArgument(Argc, Argv, "--brushes=", GeneratorSettings.Brushes);
+	ParseIntArgument(Argc, Argv, "--polys-per-brush=", GeneratorSettings.PolysPerBrush);
+	ParseIntArgument(Argc, Argv, "--lights=", GeneratorSettings.Lights);
+	ParseIntArgument(Argc, Argv, "--sub-object-depth=", GeneratorSettings.SubObjectDepth);
+	ParseIntArgument(Argc, Argv, "--materials=", GeneratorSettings.Materials);
+	ParseIntArgument(Argc, Argv, "--expressions-per-material=", GeneratorSettings.ExpressionsPerMaterial);
+	ParseIntArgument(Argc, Argv, "--material-instances=", GeneratorSettings.MaterialInstances);
+	ParseIntArgument(Argc, Argv, "--seed=", GeneratorSettings.Seed);
+	ParseIntArgument(Argc, Argv, "--iterations=", Iterations);
+	Iterations = std::max(Iterations, 1);
+
+	const FT3DSyntheticGenerator Generator(GeneratorSettings);
+	if (const char * OutputFolder = FindArgument(Argc, Argv, "--output="))
+	{
+		if (!Generator.WriteFiles(OutputFolder))
+		{
+			std::fprintf(stderr, "Unable to write the synthetic exports to %s\n", OutputFolder);
+			return 1;
+		}
+		std::printf("Generated synthetic exports in %s\n", OutputFolder);
+		return 0;
+	}
+
+	double StartTime = Now();
+	const std::string Level = Generator.GenerateLevel();
+	std::vector<std::string> Materials;
+	long long MaterialBytes = 0;
+	for (int MaterialIndex = 0; MaterialIndex < GeneratorSettings.Materials; ++MaterialIndex)
+	{
+		Materials.push_back(Generator.GenerateMaterial(MaterialIndex));
+		MaterialBytes += (long long)Materials.back().size();
+	}
+	for (int InstanceIndex = 0; InstanceIndex < GeneratorSettings.MaterialInstances; ++InstanceIndex)
+	{
+		Materials.push_back(Generator.GenerateMaterialInstance(InstanceIndex));
+		MaterialBytes += (long long)Materials.back().size();
+	}
+	std::printf("Generated synthetic exports in %.1f ms\n", (Now() - StartTime) * 1000.0);
+	const long long LevelBytes = (long long)Level.size();
+
+	FBenchmarkResult Tokenize, GetValues, Scan, ParsePolys, RegisterRequirements, ParseMaterials;
+	for (int Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		// Splitting into lines, then trimming each of them
+		StartTime = Now();
+		const std::vector<FRange> Lines = SplitLines(Level);
+		Tokenize.AddIteration(Now() - StartTime, LevelBytes, (long long)Lines.size());
+
+		// Value lookups, over every line
+		const FRange NameKey = T3DCore::MakeRange(" Name=");
+		const FRange LocationKey = T3DCore::MakeRange("Location=");
+		const FRange TextureKey = T3DCore::MakeRange(" Texture=");
+		long long Found = 0;
+		FRange Value;
+		StartTime = Now();
+		for (const FRange &Line : Lines)
+		{
+			Found += T3DCore::FindValueAfter(Line, NameKey, Line.Len(), Value);
+			Found += T3DCore::FindValueAfter(Line, LocationKey, Line.Len(), Value);
+			Found += T3DCore::FindValueAfter(Line, TextureKey, Line.Len(), Value);
+		}
+		GetValues.AddIteration(Now() - StartTime, LevelBytes, (long long)Lines.size() * 3);
+
+		// Delimiting the actor blocks, the children of the level object
+		long long BlockCount = 0;
+		int Depth = 0;
+		StartTime = Now();
+		for (const FRange &Line : Lines)
+		{
+			if (StartsWith(Line, "Begin Object"))
+			{
+				if (++Depth == 2)
+					++BlockCount;
+			}
+			else if (StartsWith(Line, "End Object"))
+			{
+				--Depth;
+			}
+		}
+		Scan.AddIteration(Now() - StartTime, LevelBytes, BlockCount);
+
+		// Polygon lines, parsed in place: each line stops at its '\r'
+		long long PolyLines = 0, PolyBytes = 0;
+		double Vector[3];
+		StartTime = Now();
+		for (const FRange &Line : Lines)
+		{
+			if (T3DCore::ParsePolyLine(Line.Begin, Vector) != T3DCore::EPolyLine::Other)
+			{
+				++PolyLines;
+				PolyBytes += Line.Len();
+			}
+		}
+		ParsePolys.AddIteration(Now() - StartTime, PolyBytes, PolyLines);
+
+		// Registering the assets required by the actors
+		std::vector<std::string> Urls;
+		FRange Name;
+		for (const FRange &Line : Lines)
+		{
+			if (T3DCore::SplitProperty(Line, Name, Value) && (StartsWith(Name, "StaticMesh") || StartsWith(Name, "Materials(")) && Value.FindChar('\'') != -1)
+			{
+				Urls.push_back(std::string(Value.Begin, Value.End));
+			}
+		}
+		T3DCore::TRequirementGraph<std::string, void(*)(int), int> Graph;
+		long long Requirements = 0;
+		StartTime = Now();
+		for (const std::string &Url : Urls)
+		{
+			FRange Type, Package, ObjectName;
+			bool bHasPackage;
+			if (T3DCore::ParseRessourceUrl(FRange(Url.data(), Url.data() + Url.size()), Type, bHasPackage, Package, ObjectName))
+			{
+				Graph.Add(Url, [](int) {});
+				++Requirements;
+			}
+		}
+		RegisterRequirements.AddIteration(Now() - StartTime, 0, Requirements);
+
+		// Material and material instance properties
+		long long Properties = 0;
+		StartTime = Now();
+		for (const std::string &Material : Materials)
+		{
+			for (const FRange &Line : SplitLines(Material))
+			{
+				Properties += T3DCore::SplitProperty(Line, Name, Value);
+			}
+		}
+		ParseMaterials.AddIteration(Now() - StartTime, MaterialBytes, Properties);
+
+		if (Found == 0)
+			return 1;
+	}
+
+	std::printf("Best of %d iterations, %.1f MB of level T3D:\n", Iterations, LevelBytes / (1024.0 * 1024.0));
+	Tokenize.Print("ForEachLine/Trim", "lines");
+	GetValues.Print("FindValueAfter", "lookups");
+	Scan.Print("Scan blocks", "blocks");
+	ParsePolys.Print("ParsePolyLine", "lines");
+	RegisterRequirements.Print("Add requirements", "requirements");
+	ParseMaterials.Print("Material properties", "properties");
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include "T3DCore/T3DBoundedMPSCQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * Throughput of TBoundedMPSCQueue against a mutex protected std::queue, with 1 to N producers:
+ *   T3DQueueBenchmark [--items=1000000] [--capacity=4096] [--producers=8]
+ */
+namespace
+{
+	double Now()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/** Same interface as the bounded queue for the benchmark, unbounded */
+	class FLockedQueue
+	{
+	public:
+		template<typename AbortPredicateType>
+		bool Enqueue(std::uint64_t &&Item, AbortPredicateType)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			Items.push(Item);
+			return true;
+		}
+
+		bool TryDequeue(std::uint64_t &OutItem)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			if (Items.empty())
+				return false;
+			OutItem = Items.front();
+			Items.pop();
+			return true;
+		}
+
+	private:
+		std::mutex Mutex;
+		std::queue<std::uint64_t> Items;
+	};
+
+	/** @return the seconds taken to pass ItemsPerProducer items from every producer to the consumer */
+	template<typename QueueType>
+	double RunQueue(QueueType &Queue, int ProducerCount, int ItemsPerProducer)
+	{
+		const double StartTime = Now();
+		std::vector<std::thread> Producers;
+		for (int Producer = 0; Producer < ProducerCount; ++Producer)
+		{
+			Producers.emplace_back([&Queue, ItemsPerProducer]()
+			{
+				for (int Sequence = 0; Sequence < ItemsPerProducer; ++Sequence)
+				{
+					std::uint64_t Item = (std::uint64_t)Sequence;
+					Queue.Enqueue(std::move(Item), []() { return false; });
+				}
+			});
+		}
+
+		const long long ItemCount = (long long)ProducerCount * ItemsPerProducer;
+		std::uint64_t Item;
+		for (long long Received = 0; Received < ItemCount;)
+		{
+			if (Queue.TryDequeue(Item))
+				++Received;
+			else
+				std::this_thread::yield();
+		}
+		const double Seconds = Now() - StartTime;
+
+		for (std::thread &Thread : Producers)
+		{
+			Thread.join();
+		}
+		return Seconds;
+	}
+
+	int ParseIntArgument(int Argc, char ** Argv, const char * Name, int Default)
+	{
+		const size_t NameLen = std::strlen(Name);
+		for (int Index = 1; Index < Argc; ++Index)
+		{
+			if (std::strncmp(Argv[Index], Name, NameLen) == 0)
+				return std::atoi(Argv[Index] + NameLen);
+		}
+		return Default;
+	}
+}
+
+int main(int Argc, char ** Argv)
+{
+	const int ItemCount = std::max(ParseIntArgument(Argc, Argv, "--items=", 1000000), 1);
+	const int Capacity = std::max(ParseIntArgument(Argc, Argv, "--capacity=", 4096), 1);
+	const int MaxProducers = std::max(ParseIntArgument(Argc, Argv, "--producers=", 8), 1);
+
+	for (int Producers = 1; Producers <= MaxProducers; Producers *= 2)
+	{
+		const int ItemsPerProducer = std::max(ItemCount / Producers, 1);
+		const double Items = (double)ItemsPerProducer * Producers;
+
+		T3DCore::TBoundedMPSCQueue<std::uint64_t> BoundedQueue((std::uint32_t)Capacity);
+		const double BoundedSeconds = RunQueue(BoundedQueue, Producers, ItemsPerProducer);
+		FLockedQueue LockedQueue;
+		const double LockedSeconds = RunQueue(LockedQueue, Producers, ItemsPerProducer);
+
+		std::printf("%d producers: bounded %.1f Mitems/s, locked std::queue %.1f Mitems/s\n", Producers,
+			Items / BoundedSeconds / 1000000.0, Items / LockedSeconds / 1000000.0);
+	}
+	return 0;
+}
@@ -0,0 +1,360 @@
+#include "T3DSyntheticGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+namespace
+{
+	struct FVector3
+	{
+		double X, Y, Z;
+
+		FVector3 operator+(const FVector3 &Other) const { return FVector3{ X + Other.X, Y + Other.Y, Z + Other.Z }; }
+		FVector3 operator-(const FVector3 &Other) const { return FVector3{ X - Other.X, Y - Other.Y, Z - Other.Z }; }
+		FVector3 operator*(double Scale) const { return FVector3{ X * Scale, Y * Scale, Z * Scale }; }
+		double Dot(const FVector3 &Other) const { return X * Other.X + Y * Other.Y + Z * Other.Z; }
+		FVector3 Cross(const FVector3 &Other) const { return FVector3{ Y * Other.Z - Z * Other.Y, Z * Other.X - X * Other.Z, X * Other.Y - Y * Other.X }; }
+		FVector3 Normalized() const
+		{
+			const double Length = std::sqrt(Dot(*this));
+			return Length > 1e-8 ? *this * (1.0 / Length) : FVector3{ 0.0, 0.0, 0.0 };
+		}
+	};
+
+	void Appendf(std::string &Out, const char * Format, ...)
+	{
+		char Buffer[1024];
+		va_list Args;
+		va_start(Args, Format);
+		const int Length = std::vsnprintf(Buffer, sizeof(Buffer), Format, Args);
+		va_end(Args);
+		Out.append(Buffer, std::min(Length, (int)sizeof(Buffer) - 1));
+	}
+
+	int RandRange(std::mt19937 &Random, int Min, int Max)
+	{
+		return std::uniform_int_distribution<int>(Min, Max)(Random);
+	}
+
+	double FRandRange(std::mt19937 &Random, double Min, double Max)
+	{
+		return std::uniform_real_distribution<double>(Min, Max)(Random);
+	}
+
+	double FRand(std::mt19937 &Random)
+	{
+		return FRandRange(Random, 0.0, 1.0);
+	}
+
+	FVector3 RandomUnitVector(std::mt19937 &Random)
+	{
+		FVector3 Result;
+		do
+		{
+			Result = FVector3{ FRandRange(Random, -1.0, 1.0), FRandRange(Random, -1.0, 1.0), FRandRange(Random, -1.0, 1.0) };
+		} while (Result.Dot(Result) > 1.0 || Result.Dot(Result) < 1e-4);
+		return Result.Normalized();
+	}
+
+	/** Same axes as FVector::FindBestAxisVectors, so that the polygons are kept by FPoly::Finalize */
+	void FindBestAxisVectors(const FVector3 &Normal, FVector3 &AxisU, FVector3 &AxisV)
+	{
+		const double NX = std::fabs(Normal.X), NY = std::fabs(Normal.Y), NZ = std::fabs(Normal.Z);
+		const FVector3 Axis = NZ > NX && NZ > NY ? FVector3{ 1.0, 0.0, 0.0 } : FVector3{ 0.0, 0.0, 1.0 };
+		AxisU = (Axis - Normal * Axis.Dot(Normal)).Normalized();
+		AxisV = AxisU.Cross(Normal);
+	}
+
+	bool MakeDirectories(const std::string &Path)
+	{
+		for (size_t Index = 1; Index <= Path.size(); ++Index)
+		{
+			if (Index == Path.size() || Path[Index] == '/' || Path[Index] == '\\')
+			{
+				const std::string Directory = Path.substr(0, Index);
+#ifdef _WIN32
+				_mkdir(Directory.c_str());
+#else
+				mkdir(Directory.c_str(), 0755);
+#endif
+			}
+		}
+		struct stat Status;
+		return stat(Path.c_str(), &Status) == 0 && (Status.st_mode & S_IFDIR) != 0;
+	}
+
+	bool SaveStringToFile(const std::string &Content, const std::string &FileName)
+	{
+		std::ofstream File(FileName, std::ios::binary);
+		File.write(Content.data(), (std::streamsize)Content.size());
+		return (bool)File;
+	}
+}
+
+FT3DSyntheticGenerator::FSettings::FSettings()
+{
+	this->StaticMeshActors = 2000;
+	this->Brushes = 200;
+	this->PolysPerBrush = 6;
+	this->Lights = 200;
+	this->SubObjectDepth = 2;
+	this->Materials = 100;
+	this->ExpressionsPerMaterial = 20;
+	this->MaterialInstances = 100;
+	this->Seed = 0;
+	this->Package = "SyntheticPackage";
+}
+
+FT3DSyntheticGenerator::FT3DSyntheticGenerator(const FSettings &Settings)
+{
+	this->Settings = Settings;
+}
+
+std::string FT3DSyntheticGenerator::GetMaterialName(int MaterialIndex) const
+{
+	return "SyntheticMaterial_" + std::to_string(MaterialIndex);
+}
+
+std::string FT3DSyntheticGenerator::GetMaterialInstanceName(int InstanceIndex) const
+{
+	return "SyntheticMaterialInstance_" + std::to_string(InstanceIndex);
+}
+
+std::string FT3DSyntheticGenerator::GenerateLevel() const
+{
+	FRandom Random((FRandom::result_type)Settings.Seed);
+	std::string Out;
+	Out += "Begin Object Class=Level Name=PersistentLevel\r\n";
+
+	for (int ActorIndex = 0; ActorIndex < Settings.StaticMeshActors; ++ActorIndex)
+	{
+		AppendStaticMeshActor(Out, Random, ActorIndex);
+	}
+	for (int BrushIndex = 0; BrushIndex < Settings.Brushes; ++BrushIndex)
+	{
+		AppendBrush(Out, Random, BrushIndex);
+	}
+	for (int LightIndex = 0; LightIndex < Settings.Lights; ++LightIndex)
+	{
+		AppendLight(Out, Random, LightIndex);
+	}
+
+	Out += "End Object\r\n";
+	return Out;
+}
+
+void FT3DSyntheticGenerator::AppendStaticMeshActor(std::string &Out, FRandom &Random, int ActorIndex) const
+{
+	Appendf(Out, "      Begin Object Class=StaticMeshActor Name=StaticMeshActor_%d Archetype=StaticMeshActor'Engine.Default__StaticMeshActor'\r\n", ActorIndex);
+	Appendf(Out, "         Begin Object Class=StaticMeshComponent Name=StaticMeshComponent0 ObjName=StaticMeshComponent_%d Archetype=StaticMeshComponent'Engine.Default__StaticMeshActor:StaticMeshComponent0'\r\n", ActorIndex);
+	Appendf(Out, "            StaticMesh=StaticMesh'%s.Meshes.SyntheticMesh_%d'\r\n", Settings.Package.c_str(), RandRange(Random, 0, 63));
+	if (Settings.Materials > 0)
+	{
+		Appendf(Out, "            Materials(0)=Material'%s.Materials.%s'\r\n", Settings.Package.c_str(), GetMaterialName(RandRange(Random, 0, Settings.Materials - 1)).c_str());
+	}
+	Out += "            BlockRigidBody=True\r\n";
+	Out += "            LightEnvironment=None\r\n";
+	Out += "         End Object\r\n";
+
+	AppendSubObject(Out, Random, Settings.SubObjectDepth, "         ");
+
+	Appendf(Out, "         StaticMeshComponent=StaticMeshComponent'StaticMeshComponent_%d'\r\n", ActorIndex);
+	Appendf(Out, "         Location=(X=%f,Y=%f,Z=%f)\r\n", FRandRange(Random, -65536, 65536), FRandRange(Random, -65536, 65536), FRandRange(Random, -4096, 4096));
+	Appendf(Out, "         Rotation=(Pitch=%d,Yaw=%d,Roll=%d)\r\n", RandRange(Random, -32768, 32767), RandRange(Random, -32768, 32767), 0);
+	Appendf(Out, "         DrawScale=%f\r\n", FRandRange(Random, 0.5, 2.0));
+	Out += "         CollisionType=COLLIDE_BlockAll\r\n";
+	Appendf(Out, "         Layer=\"Layer_%d\"\r\n", RandRange(Random, 0, 7));
+	Out += "         Tag=\"StaticMeshActor\"\r\n";
+	Appendf(Out, "         Name=\"StaticMeshActor_%d\"\r\n", ActorIndex);
+	Out += "         ObjectArchetype=StaticMeshActor'Engine.Default__StaticMeshActor'\r\n";
+	Out += "      End Object\r\n";
+}
+
+void FT3DSyntheticGenerator::AppendSubObject(std::string &Out, FRandom &Random, int Depth, const std::string &Indent) const
+{
+	if (Depth <= 0)
+		return;
+
+	Out += Indent;
+	Appendf(Out, "Begin Object Class=DynamicLightEnvironmentComponent Name=SubObject_%d\r\n", Depth);
+	Out += Indent;
+	Appendf(Out, "   AmbientGlow=(R=%f,G=%f,B=%f,A=1.000000)\r\n", FRand(Random), FRand(Random), FRand(Random));
+	AppendSubObject(Out, Random, Depth - 1, Indent + "   ");
+	Out += Indent + "End Object\r\n";
+}
+
+void FT3DSyntheticGenerator::AppendBrush(std::string &Out, FRandom &Random, int BrushIndex) const
+{
+	Appendf(Out, "      Begin Object Class=Brush Name=Brush_%d Archetype=Brush'Engine.Default__Brush'\r\n", BrushIndex);
+	Appendf(Out, "         CsgOper=%s\r\n", FRand(Random) < 0.3 ? "CSG_Subtract" : "CSG_Add");
+	Appendf(Out, "         Begin Brush Name=Model_%d\r\n", BrushIndex);
+	Out += "            Begin PolyList\r\n";
+	for (int PolyIndex = 0; PolyIndex < Settings.PolysPerBrush; ++PolyIndex)
+	{
+		// Random quads in the plane of a random normal, so that FPoly::Finalize keeps them
+		const FVector3 Normal = RandomUnitVector(Random);
+		FVector3 AxisU, AxisV;
+		FindBestAxisVectors(Normal, AxisU, AxisV);
+		const FVector3 Base = { FRandRange(Random, -1024, 1024), FRandRange(Random, -1024, 1024), FRandRange(Random, -1024, 1024) };
+		const double Size = FRandRange(Random, 64, 512);
+
+		if (Settings.Materials > 0)
+		{
+			Appendf(Out, "               Begin Polygon Texture=%s.Materials.%s Link=%d\r\n", Settings.Package.c_str(), GetMaterialName(RandRange(Random, 0, Settings.Materials - 1)).c_str(), PolyIndex);
+		}
+		else
+		{
+			Appendf(Out, "               Begin Polygon Link=%d\r\n", PolyIndex);
+		}
+		Appendf(Out, "                  Origin   %+013.6f,%+013.6f,%+013.6f\r\n", Base.X, Base.Y, Base.Z);
+		Appendf(Out, "                  Normal   %+013.6f,%+013.6f,%+013.6f\r\n", Normal.X, Normal.Y, Normal.Z);
+		Appendf(Out, "                  TextureU %+013.6f,%+013.6f,%+013.6f\r\n", AxisU.X, AxisU.Y, AxisU.Z);
+		Appendf(Out, "                  TextureV %+013.6f,%+013.6f,%+013.6f\r\n", AxisV.X, AxisV.Y, AxisV.Z);
+		const FVector3 Corners[] = { Base, Base + AxisU * Size, Base + (AxisU + AxisV) * Size, Base + AxisV * Size };
+		for (const FVector3 &Corner : Corners)
+		{
+			Appendf(Out, "                  Vertex   %+013.6f,%+013.6f,%+013.6f\r\n", Corner.X, Corner.Y, Corner.Z);
+		}
+		Out += "               End Polygon\r\n";
+	}
+	Out += "            End PolyList\r\n";
+	Out += "         End Brush\r\n";
+	Appendf(Out, "         Brush=Model'Model_%d'\r\n", BrushIndex);
+	Appendf(Out, "         Location=(X=%f,Y=%f,Z=%f)\r\n", FRandRange(Random, -65536, 65536), FRandRange(Random, -65536, 65536), FRandRange(Random, -4096, 4096));
+	Appendf(Out, "         Name=\"Brush_%d\"\r\n", BrushIndex);
+	Out += "         ObjectArchetype=Brush'Engine.Default__Brush'\r\n";
+	Out += "      End Object\r\n";
+}
+
+void FT3DSyntheticGenerator::AppendLight(std::string &Out, FRandom &Random, int LightIndex) const
+{
+	const bool bSpotLight = (LightIndex % 4) == 3;
+	const char * Class = bSpotLight ? "SpotLight" : "PointLight";
+	Appendf(Out, "      Begin Object Class=%s Name=%s_%d Archetype=%s'Engine.Default__%s'\r\n", Class, Class, LightIndex, Class, Class);
+	Appendf(Out, "         Begin Object Class=%sComponent Name=LightComponent0 ObjName=%sComponent_%d\r\n", Class, Class, LightIndex);
+	Appendf(Out, "            Radius=%f\r\n", FRandRange(Random, 256, 4096));
+	Appendf(Out, "            Brightness=%f\r\n", FRandRange(Random, 0.5, 4.0));
+	Appendf(Out, "            LightColor=(B=%d,G=%d,R=%d,A=0)\r\n", RandRange(Random, 0, 255), RandRange(Random, 0, 255), RandRange(Random, 0, 255));
+	if (bSpotLight)
+	{
+		Appendf(Out, "            InnerConeAngle=%f\r\n", FRandRange(Random, 0, 20));
+		Appendf(Out, "            OuterConeAngle=%f\r\n", FRandRange(Random, 20, 60));
+	}
+	Out += "         End Object\r\n";
+	Appendf(Out, "         Location=(X=%f,Y=%f,Z=%f)\r\n", FRandRange(Random, -65536, 65536), FRandRange(Random, -65536, 65536), FRandRange(Random, -4096, 4096));
+	if (bSpotLight)
+	{
+		Appendf(Out, "         Rotation=(Pitch=%d,Yaw=%d,Roll=0)\r\n", RandRange(Random, -16384, 0), RandRange(Random, -32768, 32767));
+	}
+	Appendf(Out, "         Name=\"%s_%d\"\r\n", Class, LightIndex);
+	Out += "      End Object\r\n";
+}
+
+std::string FT3DSyntheticGenerator::GenerateMaterial(int MaterialIndex) const
+{
+	FRandom Random((FRandom::result_type)(Settings.Seed + MaterialIndex + 1));
+	const std::string Name = GetMaterialName(MaterialIndex);
+	std::string Out;
+	Appendf(Out, "Begin Object Class=Material Name=%s\r\n", Name.c_str());
+
+	// Leaves first, then each operator combines the two previous expressions, the last one feeds the material
+	const int ExpressionCount = std::max(Settings.ExpressionsPerMaterial, 1);
+	std::vector<std::string> Expressions;
+	for (int ExpressionIndex = 0; ExpressionIndex < ExpressionCount; ++ExpressionIndex)
+	{
+		std::string Class;
+		std::string Properties;
+		if (ExpressionIndex < 2 || FRand(Random) < 0.3)
+		{
+			if (FRand(Random) < 0.5)
+			{
+				Class = "MaterialExpressionTextureSample";
+				Appendf(Properties, "   Texture=Texture2D'%s.Textures.SyntheticTexture_%d'\r\n", Settings.Package.c_str(), RandRange(Random, 0, 63));
+			}
+			else
+			{
+				Class = "MaterialExpressionConstant3Vector";
+				Appendf(Properties, "   R=%f\r\n   G=%f\r\n   B=%f\r\n", FRand(Random), FRand(Random), FRand(Random));
+			}
+		}
+		else
+		{
+			Class = FRand(Random) < 0.5 ? "MaterialExpressionMultiply" : "MaterialExpressionAdd";
+			Appendf(Properties, "   A=(Expression=%s,Mask=1,MaskR=1,MaskG=1,MaskB=1)\r\n", Expressions[ExpressionIndex - 1].c_str());
+			Appendf(Properties, "   B=(Expression=%s,Mask=1,MaskR=1,MaskG=1,MaskB=1)\r\n", Expressions[ExpressionIndex - 2].c_str());
+		}
+
+		const std::string ExpressionName = Class + "_" + std::to_string(ExpressionIndex);
+		Expressions.push_back(Class + "'" + ExpressionName + "'");
+
+		Appendf(Out, "Begin Object Class=%s Name=%s\r\n", Class.c_str(), ExpressionName.c_str());
+		Out += Properties;
+		Appendf(Out, "   MaterialExpressionEditorX=%d\r\n", -200 * (ExpressionCount - ExpressionIndex));
+		Appendf(Out, "   MaterialExpressionEditorY=%d\r\n", RandRange(Random, 0, 2000));
+		Appendf(Out, "   Material=Material'%s'\r\n", Name.c_str());
+		Appendf(Out, "   ExpressionGUID=%08X%08X%08X%08X\r\n", (unsigned)Random(), (unsigned)Random(), (unsigned)Random(), (unsigned)Random());
+		Appendf(Out, "   Name=\"%s\"\r\n", ExpressionName.c_str());
+		Appendf(Out, "   ObjectArchetype=%s'Engine.Default__%s'\r\n", Class.c_str(), Class.c_str());
+		Out += "End Object\r\n";
+	}
+
+	Appendf(Out, "DiffuseColor=(Expression=%s,Mask=1,MaskR=1,MaskG=1,MaskB=1)\r\n", Expressions.back().c_str());
+	Appendf(Out, "EmissiveColor=(Expression=%s,Mask=1,MaskR=1,MaskG=1,MaskB=1)\r\n", Expressions[0].c_str());
+	Out += "TwoSided=True\r\n";
+	Appendf(Out, "Name=\"%s\"\r\n", Name.c_str());
+	Out += "ObjectArchetype=Material'Engine.Default__Material'\r\n";
+	Out += "End Object\r\n";
+	return Out;
+}
+
+std::string FT3DSyntheticGenerator::GenerateMaterialInstance(int InstanceIndex) const
+{
+	FRandom Random((FRandom::result_type)(Settings.Seed - InstanceIndex - 1));
+	const std::string Name = GetMaterialInstanceName(InstanceIndex);
+	std::string Out;
+	Appendf(Out, "Begin Object Class=MaterialInstanceConstant Name=%s\r\n", Name.c_str());
+	for (int ParameterIndex = 0; ParameterIndex < 4; ++ParameterIndex)
+	{
+		Appendf(Out, "   ScalarParameterValues(%d)=(ParameterName=\"Scalar_%d\",ParameterValue=%f)\r\n", ParameterIndex, ParameterIndex, FRand(Random));
+		Appendf(Out, "   TextureParameterValues(%d)=(ParameterName=\"Texture_%d\",ParameterValue=Texture2D'%s.Textures.SyntheticTexture_%d')\r\n", ParameterIndex, ParameterIndex, Settings.Package.c_str(), RandRange(Random, 0, 63));
+		Appendf(Out, "   VectorParameterValues(%d)=(ParameterName=\"Vector_%d\",ParameterValue=(R=%f,G=%f,B=%f,A=1.000000))\r\n", ParameterIndex, ParameterIndex, FRand(Random), FRand(Random), FRand(Random));
+	}
+	if (Settings.Materials > 0)
+	{
+		Appendf(Out, "   Parent=Material'%s.Materials.%s'\r\n", Settings.Package.c_str(), GetMaterialName(RandRange(Random, 0, Settings.Materials - 1)).c_str());
+	}
+	Appendf(Out, "   Name=\"%s\"\r\n", Name.c_str());
+	Out += "   ObjectArchetype=MaterialInstanceConstant'Engine.Default__MaterialInstanceConstant'\r\n";
+	Out += "End Object\r\n";
+	return Out;
+}
+
+bool FT3DSyntheticGenerator::WriteFiles(const std::string &Folder) const
+{
+	bool bSuccess = MakeDirectories(Folder) && SaveStringToFile(GenerateLevel(), Folder + "/PersistentLevel.T3D");
+
+	// Same layout as the UDK exports of T3DLevelParser, see ExportFolderFor
+	const std::string MaterialFolder = Folder + "/ExportedMaterials/" + Settings.Package;
+	bSuccess &= MakeDirectories(MaterialFolder);
+	for (int MaterialIndex = 0; MaterialIndex < Settings.Materials; ++MaterialIndex)
+	{
+		bSuccess &= SaveStringToFile(GenerateMaterial(MaterialIndex), MaterialFolder + "/" + GetMaterialName(MaterialIndex) + ".T3D");
+	}
+
+	const std::string InstanceFolder = Folder + "/ExportedMaterialInstances/" + Settings.Package;
+	bSuccess &= MakeDirectories(InstanceFolder);
+	for (int InstanceIndex = 0; InstanceIndex < Settings.MaterialInstances; ++InstanceIndex)
+	{
+		bSuccess &= SaveStringToFile(GenerateMaterialInstance(InstanceIndex), InstanceFolder + "/" + GetMaterialInstanceName(InstanceIndex) + ".T3D");
+	}
+
+	return bSuccess;
+}
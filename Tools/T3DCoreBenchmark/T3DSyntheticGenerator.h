@@ -0,0 +1,55 @@
+#pragma once
+
+#include <random>
+#include <string>
+
+/**
+ * Writes synthetic UDK exports with tunable sizes: a PersistentLevel.T3D with static mesh actors, brushes,
+ * lights and nested sub-objects, and the T3D exports of materials and material instances, laid out like
+ * the export folders of T3DLevelParser. Output is deterministic for a given seed.
+ */
+class FT3DSyntheticGenerator
+{
+public:
+	struct FSettings
+	{
+		FSettings();
+
+		int StaticMeshActors;
+		int Brushes;
+		int PolysPerBrush;
+		int Lights;
+		/** Depth of the sub-objects nested in each static mesh actor, beside its mesh component */
+		int SubObjectDepth;
+		int Materials;
+		int ExpressionsPerMaterial;
+		int MaterialInstances;
+		int Seed;
+		/** UDK package of the generated meshes, textures and materials */
+		std::string Package;
+	};
+
+	FT3DSyntheticGenerator(const FSettings &Settings);
+
+	std::string GenerateLevel() const;
+	std::string GenerateMaterial(int MaterialIndex) const;
+	std::string GenerateMaterialInstance(int InstanceIndex) const;
+
+	std::string GetMaterialName(int MaterialIndex) const;
+	std::string GetMaterialInstanceName(int InstanceIndex) const;
+
+	const FSettings & GetSettings() const { return Settings; }
+
+	/** Write every generated file under Folder, @return false if one could not be written */
+	bool WriteFiles(const std::string &Folder) const;
+
+private:
+	typedef std::mt19937 FRandom;
+
+	void AppendStaticMeshActor(std::string &Out, FRandom &Random, int ActorIndex) const;
+	void AppendSubObject(std::string &Out, FRandom &Random, int Depth, const std::string &Indent) const;
+	void AppendBrush(std::string &Out, FRandom &Random, int BrushIndex) const;
+	void AppendLight(std::string &Out, FRandom &Random, int LightIndex) const;
+
+	FSettings Settings;
+};